@@ -0,0 +1,384 @@
+/*
+ * Analiza como reparte un conjunto real de claves cada funcion de hash,
+ * para elegir la mas rapida que todavia distribuye bien esas claves.
+ *
+ * Lee un archivo con una clave por linea y, para cada funcion de hash y
+ * cada forma en que los motores eligen el balde, reparte las claves en
+ * tablas de varias capacidades e informa:
+ *   chi2_normalizado: chi cuadrado de la ocupacion de los baldes dividido
+ *     sus grados de libertad. Cerca de 1 es uniforme; bastante mas de 1
+ *     significa que hay baldes sobrecargados.
+ *   z_chi2: cuantos desvios se aleja el chi cuadrado de lo esperado.
+ *   carga_maxima y carga_media: elementos del balde mas cargado y
+ *     promedio por balde.
+ *   sesgo_avalancha_max y sesgo_avalancha_medio: al cambiar un bit de la
+ *     clave cada bit del hash deberia cambiar la mitad de las veces; el
+ *     sesgo es |2 * proporcion - 1| entre 0 (ideal) y 1, el peor y el
+ *     promedio de todos los pares (bit de entrada, bit de salida).
+ *   gb_por_segundo: bytes de clave hasheados por segundo.
+ *
+ * Los mapeos imitan a los motores:
+ *   listas: hash % capacidad, con capacidad prima.
+ *   encadenado: bits bajos del hash, con capacidad potencia de 2.
+ *   abierto: bits del hash por encima de los 7 de la etiqueta, sobre
+ *     grupos de 16 ranuras (cada grupo cuenta como un balde).
+ *
+ * Compilacion, desde esta carpeta:
+ *   gcc -O2 -std=c11 -pthread -I.. ../[a-z]*.c cargas.c analizar_hash.c -lm -o analizar_hash
+ *
+ * Uso:
+ *   ./analizar_hash [-n capacidades] [-s semilla] archivo
+ * Por defecto las capacidades son las que tendria cada motor con
+ * factores de carga 3, 1 y 0.5 para la cantidad de claves del archivo.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <unistd.h>
+#include "hash.h"
+#include "cargas.h"
+
+#define MAXIMO_CANTIDADES 16
+#define SEMILLA_POR_DEFECTO 2024
+#define TAMANIO_GRUPO 16
+#define CLAVES_AVALANCHA 4096
+#define BITS_ENTRADA_AVALANCHA 256
+#define NANOSEGUNDOS_RENDIMIENTO 200000000ull
+
+typedef struct funcion_analizada{
+	const char* nombre;
+	hash_funcion_t funcion;
+}funcion_analizada_t;
+
+const funcion_analizada_t FUNCIONES[] = {
+	{"rapida", hash_funcion_rapida},
+	{"siphash", hash_funcion_siphash}
+};
+
+#define CANTIDAD_FUNCIONES (sizeof(FUNCIONES) / sizeof(FUNCIONES[0]))
+
+typedef enum mapeo{
+	MAPEO_LISTAS = 0,
+	MAPEO_ENCADENADO,
+	MAPEO_ABIERTO,
+	CANTIDAD_MAPEOS
+}mapeo_t;
+
+const char* NOMBRES_MAPEOS[CANTIDAD_MAPEOS] = {"listas", "encadenado", "abierto"};
+
+typedef struct claves{
+	char* texto;
+	const char** clave;
+	size_t* largo;
+	size_t cantidad;
+	size_t bytes;
+}claves_t;
+
+/* Evita que el compilador descarte los hashes cuyo resultado no se usa. */
+volatile uint64_t sumidero;
+
+// pre: claves es distinto de NULL
+// pos: lee el archivo entero y separa una clave por linea (sin el '\n' ni un '\r' final, y salteando lineas vacias). Devuelve false si no pudo leerlo o no tiene claves
+bool leer_claves(const char* ruta, claves_t* claves){
+
+	memset(claves, 0, sizeof(claves_t));
+
+	FILE* archivo = fopen(ruta, "rb");
+	if(!archivo)
+		return false;
+
+	size_t capacidad = 1 << 16;
+	size_t leidos = 0;
+	char* texto = malloc(capacidad);
+	size_t ultimos;
+	while(texto && (ultimos = fread(texto + leidos, 1, capacidad - leidos, archivo)) > 0){
+		leidos += ultimos;
+		if(leidos == capacidad){
+			capacidad *= 2;
+			char* auxiliar = realloc(texto, capacidad);
+			if(!auxiliar){
+				free(texto);
+				texto = NULL;
+			}
+			else
+				texto = auxiliar;
+		}
+	}
+	fclose(archivo);
+	if(!texto)
+		return false;
+
+	size_t lineas = 1;
+	for(size_t i = 0; i < leidos; i++)
+		lineas += texto[i] == '\n';
+
+	claves->texto = texto;
+	claves->clave = malloc(lineas * sizeof(char*));
+	claves->largo = malloc(lineas * sizeof(size_t));
+	if(!claves->clave || !claves->largo)
+		return false;
+
+	size_t inicio = 0;
+	for(size_t i = 0; i <= leidos; i++){
+		if(i < leidos && texto[i] != '\n')
+			continue;
+
+		size_t largo = i - inicio;
+		if(largo > 0 && texto[inicio + largo - 1] == '\r')
+			largo--;
+		if(largo > 0){
+			claves->clave[claves->cantidad] = texto + inicio;
+			claves->largo[claves->cantidad] = largo;
+			claves->cantidad++;
+			claves->bytes += largo;
+		}
+		inicio = i + 1;
+	}
+
+	return claves->cantidad > 0;
+}
+
+// pre:
+// pos: libera las claves leidas
+void liberar_claves(claves_t* claves){
+
+	free(claves->texto);
+	free(claves->clave);
+	free(claves->largo);
+}
+
+// pre:
+// pos: devuelve el menor primo mayor o igual a numero, igual que el motor de listas
+size_t proximo_primo(size_t numero){
+
+	for(;; numero++){
+		bool primo = numero >= 2;
+		for(size_t i = 2; primo && i <= numero / i; i++)
+			primo = numero % i != 0;
+		if(primo)
+			return numero;
+	}
+}
+
+// pre:
+// pos: devuelve la menor potencia de 2 mayor o igual a numero y a minimo
+size_t proxima_potencia(size_t numero, size_t minimo){
+
+	size_t potencia = minimo;
+	while(potencia < numero)
+		potencia *= 2;
+
+	return potencia;
+}
+
+// pre: capacidad es mayor a 0
+// pos: devuelve la cantidad de baldes que usa el mapeo para una tabla de esa capacidad
+size_t baldes_del_mapeo(mapeo_t mapeo, size_t capacidad){
+
+	if(mapeo == MAPEO_LISTAS)
+		return proximo_primo(capacidad);
+	if(mapeo == MAPEO_ENCADENADO)
+		return proxima_potencia(capacidad, 1);
+
+	return proxima_potencia(capacidad, TAMANIO_GRUPO) / TAMANIO_GRUPO;
+}
+
+// pre: baldes es el resultado de baldes_del_mapeo
+// pos: devuelve el balde en que el mapeo ubica al hash
+size_t balde_del_hash(mapeo_t mapeo, uint64_t valor_hash, size_t baldes){
+
+	if(mapeo == MAPEO_LISTAS)
+		return (size_t)(valor_hash % baldes);
+	if(mapeo == MAPEO_ENCADENADO)
+		return (size_t)(valor_hash & (baldes - 1));
+
+	return (size_t)(valor_hash >> 7) & (baldes - 1);
+}
+
+// pre: claves tiene al menos una clave
+// pos: mide el sesgo de avalancha de la funcion sobre las primeras CLAVES_AVALANCHA claves, cambiando cada uno de sus primeros BITS_ENTRADA_AVALANCHA bits
+void medir_avalancha(hash_funcion_t funcion, const claves_t* claves, uint64_t semilla, double* sesgo_maximo, double* sesgo_medio){
+
+	uint32_t (*cambios)[64] = calloc(BITS_ENTRADA_AVALANCHA, sizeof(*cambios));
+	uint32_t* pruebas = calloc(BITS_ENTRADA_AVALANCHA, sizeof(uint32_t));
+	char copia[BITS_ENTRADA_AVALANCHA / 8];
+
+	*sesgo_maximo = *sesgo_medio = 0;
+	if(!cambios || !pruebas){
+		free(cambios);
+		free(pruebas);
+		return;
+	}
+
+	size_t cantidad = claves->cantidad < CLAVES_AVALANCHA ? claves->cantidad : CLAVES_AVALANCHA;
+	for(size_t c = 0; c < cantidad; c++){
+
+		size_t largo = claves->largo[c] < sizeof(copia) ? claves->largo[c] : sizeof(copia);
+		memcpy(copia, claves->clave[c], largo);
+		uint64_t original = funcion(copia, largo, semilla);
+
+		for(size_t bit = 0; bit < largo * 8; bit++){
+			copia[bit / 8] ^= (char)(1 << (bit % 8));
+			uint64_t diferencia = original ^ funcion(copia, largo, semilla);
+			copia[bit / 8] ^= (char)(1 << (bit % 8));
+
+			pruebas[bit]++;
+			for(size_t salida = 0; salida < 64; salida++)
+				cambios[bit][salida] += (uint32_t)((diferencia >> salida) & 1);
+		}
+	}
+
+	size_t pares = 0;
+	for(size_t bit = 0; bit < BITS_ENTRADA_AVALANCHA; bit++){
+		if(pruebas[bit] == 0)
+			continue;
+		for(size_t salida = 0; salida < 64; salida++){
+			double sesgo = fabs(2.0 * cambios[bit][salida] / pruebas[bit] - 1.0);
+			if(sesgo > *sesgo_maximo)
+				*sesgo_maximo = sesgo;
+			*sesgo_medio += sesgo;
+			pares++;
+		}
+	}
+	if(pares)
+		*sesgo_medio /= (double)pares;
+
+	free(cambios);
+	free(pruebas);
+}
+
+// pre: claves tiene al menos una clave
+// pos: devuelve cuantos GB de claves por segundo hashea la funcion, repitiendo todas las claves por lo menos NANOSEGUNDOS_RENDIMIENTO
+double medir_rendimiento(hash_funcion_t funcion, const claves_t* claves, uint64_t semilla){
+
+	uint64_t acumulado = 0;
+	size_t vueltas = 0;
+	uint64_t inicio = reloj_ns();
+	uint64_t transcurrido;
+
+	do{
+		for(size_t i = 0; i < claves->cantidad; i++)
+			acumulado += funcion(claves->clave[i], claves->largo[i], semilla);
+		vueltas++;
+		transcurrido = reloj_ns() - inicio;
+	}while(transcurrido < NANOSEGUNDOS_RENDIMIENTO);
+
+	sumidero = acumulado;
+
+	return (double)claves->bytes * (double)vueltas / (double)transcurrido;
+}
+
+// pre: hashes tiene los hashes de todas las claves y ocupacion tiene lugar para los baldes del mapeo
+// pos: reparte los hashes en la tabla e imprime la linea CSV de la funcion, el mapeo y la capacidad
+void analizar_reparto(const char* funcion, mapeo_t mapeo, size_t capacidad, const uint64_t* hashes, size_t cantidad, size_t* ocupacion,
+	double sesgo_maximo, double sesgo_medio, double gb_por_segundo){
+
+	size_t baldes = baldes_del_mapeo(mapeo, capacidad);
+	memset(ocupacion, 0, baldes * sizeof(size_t));
+
+	for(size_t i = 0; i < cantidad; i++)
+		ocupacion[balde_del_hash(mapeo, hashes[i], baldes)]++;
+
+	double esperada = (double)cantidad / (double)baldes;
+	double chi2 = 0;
+	size_t maxima = 0;
+	for(size_t i = 0; i < baldes; i++){
+		double diferencia = (double)ocupacion[i] - esperada;
+		chi2 += diferencia * diferencia / esperada;
+		if(ocupacion[i] > maxima)
+			maxima = ocupacion[i];
+	}
+
+	double libertad = baldes > 1 ? (double)(baldes - 1) : 1.0;
+
+	printf("%s,%s,%zu,%zu,%.4f,%.2f,%zu,%.3f,%.4f,%.4f,%.3f\n", funcion, NOMBRES_MAPEOS[mapeo], mapeo == MAPEO_ABIERTO ? baldes * TAMANIO_GRUPO : baldes,
+		cantidad, chi2 / libertad, (chi2 - libertad) / sqrt(2.0 * libertad), maxima, esperada, sesgo_maximo, sesgo_medio, gb_por_segundo);
+}
+
+// pre:
+// pos: imprime como se usa el programa
+void mostrar_uso(const char* programa){
+
+	fprintf(stderr, "uso: %s [-n capacidades] [-s semilla] archivo\n", programa);
+}
+
+int main(int argc, char* argv[]){
+
+	size_t capacidades[MAXIMO_CANTIDADES];
+	size_t cantidad_capacidades = 0;
+	uint64_t semilla = SEMILLA_POR_DEFECTO;
+	int opcion;
+
+	while((opcion = getopt(argc, argv, "n:s:")) != -1){
+		switch(opcion){
+			case 'n': cantidad_capacidades = leer_cantidades(optarg, capacidades, MAXIMO_CANTIDADES); break;
+			case 's': semilla = strtoull(optarg, NULL, 0); break;
+			default:
+				mostrar_uso(argv[0]);
+				return 1;
+		}
+	}
+	if(optind != argc - 1){
+		mostrar_uso(argv[0]);
+		return 1;
+	}
+
+	claves_t claves;
+	if(!leer_claves(argv[optind], &claves)){
+		fprintf(stderr, "no se pudieron leer claves de %s\n", argv[optind]);
+		liberar_claves(&claves);
+		return 1;
+	}
+
+	if(cantidad_capacidades == 0){
+		capacidades[0] = claves.cantidad / 3 + 1;
+		capacidades[1] = claves.cantidad;
+		capacidades[2] = claves.cantidad * 2;
+		cantidad_capacidades = 3;
+	}
+
+	size_t maximos_baldes = 0;
+	for(size_t c = 0; c < cantidad_capacidades; c++){
+		for(int m = 0; m < CANTIDAD_MAPEOS; m++){
+			size_t baldes = baldes_del_mapeo((mapeo_t)m, capacidades[c]);
+			if(baldes > maximos_baldes)
+				maximos_baldes = baldes;
+		}
+	}
+
+	uint64_t* hashes = malloc(claves.cantidad * sizeof(uint64_t));
+	size_t* ocupacion = malloc(maximos_baldes * sizeof(size_t));
+	if(!hashes || !ocupacion){
+		fprintf(stderr, "no hay memoria para %zu claves\n", claves.cantidad);
+		free(hashes);
+		free(ocupacion);
+		liberar_claves(&claves);
+		return 1;
+	}
+
+	printf("funcion,mapeo,capacidad,claves,chi2_normalizado,z_chi2,carga_maxima,carga_media,sesgo_avalancha_max,sesgo_avalancha_medio,gb_por_segundo\n");
+
+	for(size_t f = 0; f < CANTIDAD_FUNCIONES; f++){
+
+		double sesgo_maximo, sesgo_medio;
+		medir_avalancha(FUNCIONES[f].funcion, &claves, semilla, &sesgo_maximo, &sesgo_medio);
+		double gb_por_segundo = medir_rendimiento(FUNCIONES[f].funcion, &claves, semilla);
+
+		for(size_t i = 0; i < claves.cantidad; i++)
+			hashes[i] = FUNCIONES[f].funcion(claves.clave[i], claves.largo[i], semilla);
+
+		for(size_t c = 0; c < cantidad_capacidades; c++){
+			for(int m = 0; m < CANTIDAD_MAPEOS; m++)
+				analizar_reparto(FUNCIONES[f].nombre, (mapeo_t)m, capacidades[c], hashes, claves.cantidad, ocupacion, sesgo_maximo, sesgo_medio, gb_por_segundo);
+		}
+	}
+
+	free(hashes);
+	free(ocupacion);
+	liberar_claves(&claves);
+
+	return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * Linea de base del benchmark: mide con std::unordered_map las mismas
+ * operaciones que benchmark.c, con las mismas claves, en el mismo orden y
+ * con el mismo formato CSV (motor "unordered_map"), para poder comparar
+ * ambas salidas directamente.
+ *
+ * Compilacion, desde esta carpeta:
+ *   gcc -O2 -std=c11 -c cargas.c
+ *   g++ -O2 -std=c++20 baseline.cpp cargas.o -o baseline
+ *
+ * Uso:
+ *   ./baseline [-d distribuciones] [-n cantidades] [-s semilla]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unistd.h>
+#include "cargas.h"
+
+#define MAXIMO_CANTIDADES 16
+#define SEMILLA_POR_DEFECTO 2024
+
+/* Permite buscar con const char* sin construir un std::string por busqueda. */
+struct hash_transparente{
+	using is_transparent = void;
+	size_t operator()(std::string_view clave) const{
+		return std::hash<std::string_view>{}(clave);
+	}
+};
+
+typedef std::unordered_map<std::string, void*, hash_transparente, std::equal_to<>> tabla_t;
+
+/* Evita que el compilador descarte las busquedas cuyo resultado no se usa. */
+volatile uintptr_t sumidero;
+
+// pre:
+// pos: devuelve true si nombre aparece en la lista separada por comas, o si la lista es NULL
+bool en_lista(const char* lista, const char* nombre){
+
+	if(!lista)
+		return true;
+
+	size_t largo = strlen(nombre);
+	const char* actual = lista;
+	while(actual){
+		if(strncmp(actual, nombre, largo) == 0 && (actual[largo] == ',' || actual[largo] == '\0'))
+			return true;
+		actual = strchr(actual, ',');
+		if(actual)
+			actual++;
+	}
+
+	return false;
+}
+
+// pre: carga fue creada con carga_crear
+// pos: corre todas las mediciones sobre un std::unordered_map. Devuelve false si no hay memoria para las muestras
+bool medir_baseline(distribucion_t distribucion, const carga_t* carga){
+
+	const char* motor = "unordered_map";
+	size_t n = carga->cantidad;
+	medicion_t medicion;
+	uintptr_t acumulado = 0;
+
+	tabla_t* tabla = new tabla_t();
+
+	if(!medicion_iniciar(&medicion, n))
+		return false;
+	for(size_t i = 0; i < n; i++)
+		MEDIR_OPERACION(&medicion, i, tabla->emplace(carga->claves[i], (void*)(uintptr_t)(i + 1)));
+	medicion_terminar(&medicion);
+	medicion_informar(&medicion, motor, distribucion, n, "insertar");
+
+	if(!medicion_iniciar(&medicion, n))
+		return false;
+	for(size_t i = 0; i < n; i++)
+		MEDIR_OPERACION(&medicion, i, acumulado += (uintptr_t)tabla->find(std::string_view(carga->claves[carga->accesos[i]]))->second);
+	medicion_terminar(&medicion);
+	medicion_informar(&medicion, motor, distribucion, n, "buscar_presente");
+
+	if(!medicion_iniciar(&medicion, n))
+		return false;
+	for(size_t i = 0; i < n; i++)
+		MEDIR_OPERACION(&medicion, i, acumulado += tabla->contains(std::string_view(carga->ausentes[carga->accesos[i]])));
+	medicion_terminar(&medicion);
+	medicion_informar(&medicion, motor, distribucion, n, "buscar_ausente");
+
+	if(!medicion_iniciar(&medicion, n))
+		return false;
+	for(size_t i = 0; i < n; i++)
+		MEDIR_OPERACION(&medicion, i, tabla->insert_or_assign(carga->claves[carga->accesos[i]], (void*)(uintptr_t)i));
+	medicion_terminar(&medicion);
+	medicion_informar(&medicion, motor, distribucion, n, "reemplazar");
+
+	if(!medicion_iniciar(&medicion, n))
+		return false;
+	size_t i = 0;
+	for(auto actual = tabla->begin(); ; i++){
+		bool hay_siguiente;
+		MEDIR_OPERACION(&medicion, i, hay_siguiente = actual != tabla->end(); if(hay_siguiente) acumulado += (uintptr_t)(actual++)->second);
+		if(!hay_siguiente)
+			break;
+	}
+	medicion_terminar(&medicion);
+	medicion_informar(&medicion, motor, distribucion, n, "recorrer");
+
+	size_t bajas = n / 2;
+	if(!medicion_iniciar(&medicion, bajas))
+		return false;
+	for(i = 0; i < bajas; i++)
+		MEDIR_OPERACION(&medicion, i, tabla->erase(carga->claves[carga->bajas[i]]));
+	medicion_terminar(&medicion);
+	medicion_informar(&medicion, motor, distribucion, n, "quitar");
+
+	if(!medicion_iniciar(&medicion, 1))
+		return false;
+	size_t restantes = tabla->size();
+	MEDIR_OPERACION(&medicion, 0, delete tabla);
+	medicion_terminar(&medicion);
+	medicion.operaciones = restantes;
+	medicion_informar(&medicion, motor, distribucion, n, "destruir");
+
+	sumidero = acumulado;
+
+	return true;
+}
+
+int main(int argc, char* argv[]){
+
+	const char* distribuciones = NULL;
+	size_t cantidades[MAXIMO_CANTIDADES] = {1000, 10000, 100000, 1000000};
+	size_t cantidad_cantidades = 4;
+	uint64_t semilla = SEMILLA_POR_DEFECTO;
+	int opcion;
+
+	while((opcion = getopt(argc, argv, "d:n:s:")) != -1){
+		switch(opcion){
+			case 'd': distribuciones = optarg; break;
+			case 'n': cantidad_cantidades = leer_cantidades(optarg, cantidades, MAXIMO_CANTIDADES); break;
+			case 's': semilla = strtoull(optarg, NULL, 0); break;
+			default:
+				fprintf(stderr, "uso: %s [-d uniforme,zipf,secuencial,patentes] [-n 1e3,1e4,...] [-s semilla]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	informar_encabezado();
+
+	for(int d = 0; d < CANTIDAD_DISTRIBUCIONES; d++){
+		if(!en_lista(distribuciones, nombre_distribucion((distribucion_t)d)))
+			continue;
+		for(size_t c = 0; c < cantidad_cantidades; c++){
+			carga_t carga;
+			if(!carga_crear(&carga, (distribucion_t)d, cantidades[c], semilla) || !medir_baseline((distribucion_t)d, &carga)){
+				fprintf(stderr, "no hay memoria para %zu claves\n", cantidades[c]);
+				return 1;
+			}
+			carga_destruir(&carga);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,230 @@
+/*
+ * Benchmark reproducible del hash: para cada motor, distribucion de
+ * claves y tamanio de tabla mide insercion, busqueda de claves presentes
+ * y ausentes, reemplazo, recorrido, borrado y destruccion, e imprime una
+ * linea CSV por operacion con el rendimiento y la latencia (percentiles
+ * 50, 99 y 99.9 de una de cada MUESTREO_LATENCIA operaciones).
+ *
+ * Compilacion, desde esta carpeta:
+ *   gcc -O2 -std=c11 -pthread -I.. ../[a-z]*.c cargas.c benchmark.c -lm -o benchmark
+ *
+ * Uso:
+ *   ./benchmark [-m motores] [-d distribuciones] [-n cantidades] [-s semilla]
+ * motores: listas,abierto,encadenado (por defecto todos)
+ * distribuciones: uniforme,zipf,secuencial,patentes (por defecto todas)
+ * cantidades: por defecto 1e3,1e4,1e5,1e6. Con 1e8 la carga sola ocupa
+ * unos 8 GB ademas de la tabla.
+ *
+ * baseline.cpp mide lo mismo con std::unordered_map, con las mismas
+ * claves y en el mismo orden.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "hash.h"
+#include "hash_iterador.h"
+#include "cargas.h"
+
+#define ERROR -1
+#define EXITO 0
+#define MAXIMO_CANTIDADES 16
+#define CAPACIDAD_INICIAL 16
+#define SEMILLA_POR_DEFECTO 2024
+
+typedef struct motor_benchmark{
+	const char* nombre;
+	hash_motor_t motor;
+}motor_benchmark_t;
+
+const motor_benchmark_t MOTORES[] = {
+	{"listas", HASH_MOTOR_LISTAS},
+	{"abierto", HASH_MOTOR_ABIERTO},
+	{"encadenado", HASH_MOTOR_ENCADENADO}
+};
+
+#define CANTIDAD_MOTORES_BENCHMARK (sizeof(MOTORES) / sizeof(MOTORES[0]))
+
+/* Evita que el compilador descarte las busquedas cuyo resultado no se usa. */
+volatile uintptr_t sumidero;
+
+// pre:
+// pos: devuelve true si nombre aparece en la lista separada por comas, o si la lista es NULL
+bool en_lista(const char* lista, const char* nombre){
+
+	if(!lista)
+		return true;
+
+	size_t largo = strlen(nombre);
+	const char* actual = lista;
+	while(actual){
+		if(strncmp(actual, nombre, largo) == 0 && (actual[largo] == ',' || actual[largo] == '\0'))
+			return true;
+		actual = strchr(actual, ',');
+		if(actual)
+			actual++;
+	}
+
+	return false;
+}
+
+// pre: carga fue creada con carga_crear
+// pos: corre todas las mediciones sobre una tabla del motor. Devuelve ERROR si falla alguna operacion
+int medir_motor(const motor_benchmark_t* motor, distribucion_t distribucion, const carga_t* carga, uint64_t semilla){
+
+	hash_opciones_t opciones = {0};
+	opciones.motor = motor->motor;
+	opciones.semilla = semilla;
+	opciones.semilla_fija = true;
+
+	size_t n = carga->cantidad;
+	medicion_t medicion;
+	int estado = EXITO;
+	uintptr_t acumulado = 0;
+
+	if(!medicion_iniciar(&medicion, n))
+		return ERROR;
+	hash_t* hash = hash_crear_con_opciones(NULL, CAPACIDAD_INICIAL, &opciones);
+	if(!hash){
+		free(medicion.muestras);
+		return ERROR;
+	}
+	for(size_t i = 0; i < n; i++)
+		MEDIR_OPERACION(&medicion, i, estado |= hash_insertar(hash, carga->claves[i], (void*)(uintptr_t)(i + 1)));
+	medicion_terminar(&medicion);
+	medicion_informar(&medicion, motor->nombre, distribucion, n, "insertar");
+
+	if(estado != EXITO || hash_cantidad(hash) != n){
+		hash_destruir(hash);
+		return ERROR;
+	}
+
+	if(!medicion_iniciar(&medicion, n))
+		estado = ERROR;
+	for(size_t i = 0; estado == EXITO && i < n; i++)
+		MEDIR_OPERACION(&medicion, i, acumulado += (uintptr_t)hash_obtener(hash, carga->claves[carga->accesos[i]]));
+	medicion_terminar(&medicion);
+	if(estado == EXITO)
+		medicion_informar(&medicion, motor->nombre, distribucion, n, "buscar_presente");
+
+	if(estado == EXITO && !medicion_iniciar(&medicion, n))
+		estado = ERROR;
+	for(size_t i = 0; estado == EXITO && i < n; i++)
+		MEDIR_OPERACION(&medicion, i, acumulado += (uintptr_t)hash_contiene(hash, carga->ausentes[carga->accesos[i]]));
+	medicion_terminar(&medicion);
+	if(estado == EXITO)
+		medicion_informar(&medicion, motor->nombre, distribucion, n, "buscar_ausente");
+
+	if(estado == EXITO && !medicion_iniciar(&medicion, n))
+		estado = ERROR;
+	for(size_t i = 0; estado == EXITO && i < n; i++)
+		MEDIR_OPERACION(&medicion, i, estado |= hash_insertar_o_reemplazar(hash, carga->claves[carga->accesos[i]], (void*)(uintptr_t)i, NULL));
+	medicion_terminar(&medicion);
+	if(estado == EXITO)
+		medicion_informar(&medicion, motor->nombre, distribucion, n, "reemplazar");
+
+	if(estado == EXITO && !medicion_iniciar(&medicion, n))
+		estado = ERROR;
+	if(estado == EXITO){
+		hash_cursor_t cursor;
+		void* elemento;
+		size_t i = 0;
+		hash_cursor_iniciar(&cursor, hash);
+		while(true){
+			bool hay_siguiente;
+			MEDIR_OPERACION(&medicion, i, hay_siguiente = hash_cursor_siguiente(&cursor, NULL, NULL, &elemento));
+			if(!hay_siguiente)
+				break;
+			acumulado += (uintptr_t)elemento;
+			i++;
+		}
+		medicion_terminar(&medicion);
+		medicion_informar(&medicion, motor->nombre, distribucion, n, "recorrer");
+	}
+
+	size_t bajas = n / 2;
+	if(estado == EXITO && !medicion_iniciar(&medicion, bajas))
+		estado = ERROR;
+	for(size_t i = 0; estado == EXITO && i < bajas; i++)
+		MEDIR_OPERACION(&medicion, i, estado |= hash_quitar(hash, carga->claves[carga->bajas[i]]));
+	medicion_terminar(&medicion);
+	if(estado == EXITO)
+		medicion_informar(&medicion, motor->nombre, distribucion, n, "quitar");
+
+	if(estado == EXITO && !medicion_iniciar(&medicion, 1))
+		estado = ERROR;
+	if(estado == EXITO){
+		size_t restantes = hash_cantidad(hash);
+		MEDIR_OPERACION(&medicion, 0, hash_destruir(hash));
+		medicion_terminar(&medicion);
+		medicion.operaciones = restantes;
+		medicion_informar(&medicion, motor->nombre, distribucion, n, "destruir");
+	}
+	else
+		hash_destruir(hash);
+
+	sumidero = acumulado;
+
+	return estado;
+}
+
+// pre:
+// pos: imprime como se usa el programa
+void mostrar_uso(const char* programa){
+
+	fprintf(stderr, "uso: %s [-m listas,abierto,encadenado] [-d uniforme,zipf,secuencial,patentes] [-n 1e3,1e4,...] [-s semilla]\n", programa);
+}
+
+int main(int argc, char* argv[]){
+
+	const char* motores = NULL;
+	const char* distribuciones = NULL;
+	size_t cantidades[MAXIMO_CANTIDADES] = {1000, 10000, 100000, 1000000};
+	size_t cantidad_cantidades = 4;
+	uint64_t semilla = SEMILLA_POR_DEFECTO;
+	int opcion;
+
+	while((opcion = getopt(argc, argv, "m:d:n:s:")) != -1){
+		switch(opcion){
+			case 'm': motores = optarg; break;
+			case 'd': distribuciones = optarg; break;
+			case 'n': cantidad_cantidades = leer_cantidades(optarg, cantidades, MAXIMO_CANTIDADES); break;
+			case 's': semilla = strtoull(optarg, NULL, 0); break;
+			default:
+				mostrar_uso(argv[0]);
+				return 1;
+		}
+	}
+	if(cantidad_cantidades == 0){
+		mostrar_uso(argv[0]);
+		return 1;
+	}
+
+	informar_encabezado();
+
+	for(int d = 0; d < CANTIDAD_DISTRIBUCIONES; d++){
+		if(!en_lista(distribuciones, nombre_distribucion((distribucion_t)d)))
+			continue;
+		for(size_t c = 0; c < cantidad_cantidades; c++){
+			carga_t carga;
+			if(!carga_crear(&carga, (distribucion_t)d, cantidades[c], semilla)){
+				fprintf(stderr, "no hay memoria para %zu claves\n", cantidades[c]);
+				return 1;
+			}
+			for(size_t m = 0; m < CANTIDAD_MOTORES_BENCHMARK; m++){
+				if(!en_lista(motores, MOTORES[m].nombre))
+					continue;
+				if(medir_motor(&MOTORES[m], (distribucion_t)d, &carga, semilla) == ERROR){
+					fprintf(stderr, "fallo %s con %s y %zu claves\n", MOTORES[m].nombre, nombre_distribucion((distribucion_t)d), cantidades[c]);
+					carga_destruir(&carga);
+					return 1;
+				}
+			}
+			carga_destruir(&carga);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,307 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "cargas.h"
+
+#define LARGO_MAXIMO_CLAVE 24
+#define ZIPF_THETA 0.99
+#define COMBINACIONES_PATENTE (26ull * 26 * 26 * 26 * 1000)
+#define MULTIPLICADOR_PATENTE 2654435761ull
+
+const char* NOMBRES_DISTRIBUCIONES[] = {"uniforme", "zipf", "secuencial", "patentes"};
+
+/*
+ * Devuelve el nombre de la distribucion o NULL si no existe.
+ */
+const char* nombre_distribucion(distribucion_t distribucion){
+
+	if(distribucion >= CANTIDAD_DISTRIBUCIONES)
+		return NULL;
+
+	return NOMBRES_DISTRIBUCIONES[distribucion];
+}
+
+/*
+ * Devuelve la distribucion con ese nombre, o CANTIDAD_DISTRIBUCIONES si
+ * no hay ninguna.
+ */
+distribucion_t distribucion_de_nombre(const char* nombre){
+
+	for(int i = 0; i < CANTIDAD_DISTRIBUCIONES; i++){
+		if(strcmp(nombre, NOMBRES_DISTRIBUCIONES[i]) == 0)
+			return (distribucion_t)i;
+	}
+
+	return CANTIDAD_DISTRIBUCIONES;
+}
+
+// pre:
+// pos: mezcla los bits de x (finalizador de splitmix64). Es una biyeccion, asi que valores distintos dan resultados distintos
+uint64_t mezclar(uint64_t x){
+
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ull;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebull;
+	x ^= x >> 31;
+
+	return x;
+}
+
+// pre: estado es distinto de NULL
+// pos: devuelve el proximo numero pseudoaleatorio de 64 bits (splitmix64)
+uint64_t aleatorio(uint64_t* estado){
+
+	*estado += 0x9e3779b97f4a7c15ull;
+
+	return mezclar(*estado);
+}
+
+// pre: estado es distinto de NULL
+// pos: devuelve un numero pseudoaleatorio en [0, 1)
+double aleatorio_unitario(uint64_t* estado){
+
+	return (double)(aleatorio(estado) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// pre: destino tiene LARGO_MAXIMO_CLAVE bytes
+// pos: escribe la clave numero indice de la distribucion. Indices distintos dan claves distintas
+void escribir_clave(char* destino, distribucion_t distribucion, uint64_t indice, uint64_t semilla){
+
+	if(distribucion == DISTRIBUCION_SECUENCIAL){
+		snprintf(destino, LARGO_MAXIMO_CLAVE, "%llu", (unsigned long long)indice);
+		return;
+	}
+
+	if(distribucion == DISTRIBUCION_PATENTES){
+		uint64_t numero = (indice * MULTIPLICADOR_PATENTE + semilla) % COMBINACIONES_PATENTE;
+		char letras[4];
+		for(int i = 0; i < 4; i++){
+			letras[i] = (char)('A' + numero % 26);
+			numero /= 26;
+		}
+		snprintf(destino, LARGO_MAXIMO_CLAVE, "%c%c%03llu%c%c", letras[0], letras[1], (unsigned long long)numero, letras[2], letras[3]);
+		return;
+	}
+
+	snprintf(destino, LARGO_MAXIMO_CLAVE, "%016llx", (unsigned long long)mezclar(indice ^ semilla));
+}
+
+// pre: a y b no son ambos 0
+// pos: devuelve el maximo comun divisor
+size_t mcd(size_t a, size_t b){
+
+	while(b){
+		size_t resto = a % b;
+		a = b;
+		b = resto;
+	}
+
+	return a;
+}
+
+// pre: accesos tiene cantidad posiciones y cantidad es mayor a 0
+// pos: llena accesos con indices que siguen una distribucion de Zipf (metodo de Gray et al., el mismo de YCSB). El rango mas frecuente se reparte entre las claves con una biyeccion, para que las claves populares no sean justo las primeras insertadas
+void generar_zipf(size_t* accesos, size_t cantidad, uint64_t* estado){
+
+	double zeta_n = 0;
+	for(size_t i = 1; i <= cantidad; i++)
+		zeta_n += 1.0 / pow((double)i, ZIPF_THETA);
+	double zeta_2 = 1.0 + 1.0 / pow(2.0, ZIPF_THETA);
+	double alfa = 1.0 / (1.0 - ZIPF_THETA);
+	double eta = (1.0 - pow(2.0 / (double)cantidad, 1.0 - ZIPF_THETA)) / (1.0 - zeta_2 / zeta_n);
+
+	size_t multiplicador = 2654435761u % cantidad;
+	while(cantidad > 1 && (multiplicador == 0 || mcd(multiplicador, cantidad) != 1))
+		multiplicador++;
+
+	for(size_t i = 0; i < cantidad; i++){
+		double u = aleatorio_unitario(estado);
+		double uz = u * zeta_n;
+		size_t rango;
+		if(uz < 1.0)
+			rango = 0;
+		else if(uz < 1.0 + pow(0.5, ZIPF_THETA))
+			rango = 1;
+		else
+			rango = (size_t)((double)cantidad * pow(eta * u - eta + 1.0, alfa));
+		if(rango >= cantidad)
+			rango = cantidad - 1;
+		accesos[i] = (size_t)(((unsigned __int128)rango * multiplicador) % cantidad);
+	}
+}
+
+/*
+ * Genera la carga de trabajo de cantidad claves con esa distribucion y
+ * semilla.
+ * Devuelve false si no hay memoria.
+ */
+bool carga_crear(carga_t* carga, distribucion_t distribucion, size_t cantidad, uint64_t semilla){
+
+	carga->cantidad = cantidad;
+	carga->textos = malloc(2 * cantidad * LARGO_MAXIMO_CLAVE);
+	carga->claves = malloc(cantidad * sizeof(char*));
+	carga->ausentes = malloc(cantidad * sizeof(char*));
+	carga->accesos = malloc(cantidad * sizeof(size_t));
+	carga->bajas = malloc(cantidad * sizeof(size_t));
+	if(cantidad == 0 || !carga->textos || !carga->claves || !carga->ausentes || !carga->accesos || !carga->bajas){
+		carga_destruir(carga);
+		return false;
+	}
+
+	for(size_t i = 0; i < cantidad; i++){
+		carga->claves[i] = carga->textos + i * LARGO_MAXIMO_CLAVE;
+		carga->ausentes[i] = carga->textos + (cantidad + i) * LARGO_MAXIMO_CLAVE;
+		escribir_clave(carga->claves[i], distribucion, i, semilla);
+		escribir_clave(carga->ausentes[i], distribucion, cantidad + i, semilla);
+	}
+
+	uint64_t estado = semilla;
+
+	if(distribucion == DISTRIBUCION_ZIPF)
+		generar_zipf(carga->accesos, cantidad, &estado);
+	else{
+		for(size_t i = 0; i < cantidad; i++)
+			carga->accesos[i] = distribucion == DISTRIBUCION_SECUENCIAL ? i : (size_t)(aleatorio(&estado) % cantidad);
+	}
+
+	for(size_t i = 0; i < cantidad; i++)
+		carga->bajas[i] = i;
+	if(distribucion != DISTRIBUCION_SECUENCIAL){
+		for(size_t i = cantidad - 1; i > 0; i--){
+			size_t j = (size_t)(aleatorio(&estado) % (i + 1));
+			size_t auxiliar = carga->bajas[i];
+			carga->bajas[i] = carga->bajas[j];
+			carga->bajas[j] = auxiliar;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Libera la memoria de la carga.
+ */
+void carga_destruir(carga_t* carga){
+
+	free(carga->textos);
+	free(carga->claves);
+	free(carga->ausentes);
+	free(carga->accesos);
+	free(carga->bajas);
+	memset(carga, 0, sizeof(carga_t));
+}
+
+/*
+ * Devuelve un instante en nanosegundos de un reloj monotono.
+ */
+uint64_t reloj_ns(){
+
+	struct timespec instante;
+	clock_gettime(CLOCK_MONOTONIC, &instante);
+
+	return (uint64_t)instante.tv_sec * 1000000000ull + (uint64_t)instante.tv_nsec;
+}
+
+/*
+ * Prepara la medicion de operaciones operaciones y empieza a contar el
+ * tiempo.
+ * Devuelve false si no hay memoria.
+ */
+bool medicion_iniciar(medicion_t* medicion, size_t operaciones){
+
+	medicion->operaciones = operaciones;
+	medicion->nanosegundos = 0;
+	medicion->cantidad_muestras = 0;
+	medicion->muestras = malloc((operaciones / MUESTREO_LATENCIA + 1) * sizeof(uint64_t));
+	medicion->inicio = reloj_ns();
+
+	return medicion->muestras != NULL;
+}
+
+/*
+ * Guarda la latencia de una operacion muestreada.
+ */
+void medicion_muestra(medicion_t* medicion, uint64_t nanosegundos){
+
+	medicion->muestras[medicion->cantidad_muestras++] = nanosegundos;
+}
+
+/*
+ * Deja de contar el tiempo de la medicion.
+ */
+void medicion_terminar(medicion_t* medicion){
+
+	medicion->nanosegundos = reloj_ns() - medicion->inicio;
+}
+
+// pre: a y b apuntan a uint64_t
+// pos: compara dos muestras para qsort
+int comparar_muestras(const void* a, const void* b){
+
+	uint64_t x = *(const uint64_t*)a;
+	uint64_t y = *(const uint64_t*)b;
+
+	return (x > y) - (x < y);
+}
+
+// pre: las muestras estan ordenadas
+// pos: devuelve el percentil de las muestras, o 0 si no hay muestras
+uint64_t percentil(const medicion_t* medicion, double fraccion){
+
+	if(medicion->cantidad_muestras == 0)
+		return 0;
+
+	return medicion->muestras[(size_t)(fraccion * (double)(medicion->cantidad_muestras - 1))];
+}
+
+/*
+ * Imprime el encabezado de las lineas CSV.
+ */
+void informar_encabezado(){
+
+	printf("motor,distribucion,cantidad,operacion,ops_por_segundo,ns_por_op,p50_ns,p99_ns,p999_ns\n");
+}
+
+/*
+ * Imprime una linea CSV con el resultado y libera las muestras:
+ * motor,distribucion,cantidad,operacion,ops_por_segundo,ns_por_op,p50_ns,p99_ns,p999_ns
+ */
+void medicion_informar(medicion_t* medicion, const char* motor, distribucion_t distribucion, size_t cantidad, const char* operacion){
+
+	qsort(medicion->muestras, medicion->cantidad_muestras, sizeof(uint64_t), comparar_muestras);
+
+	double segundos = (double)medicion->nanosegundos / 1e9;
+	double por_segundo = segundos > 0 ? (double)medicion->operaciones / segundos : 0;
+	double por_operacion = medicion->operaciones ? (double)medicion->nanosegundos / (double)medicion->operaciones : 0;
+
+	printf("%s,%s,%zu,%s,%.0f,%.1f,%llu,%llu,%llu\n", motor, nombre_distribucion(distribucion), cantidad, operacion, por_segundo, por_operacion,
+		(unsigned long long)percentil(medicion, 0.50), (unsigned long long)percentil(medicion, 0.99), (unsigned long long)percentil(medicion, 0.999));
+	fflush(stdout);
+
+	free(medicion->muestras);
+	medicion->muestras = NULL;
+}
+
+/*
+ * Lee una lista de cantidades separadas por comas ("1000,1e6,100000000").
+ * Devuelve cuantas leyo, a lo sumo maximo.
+ */
+size_t leer_cantidades(const char* texto, size_t* cantidades, size_t maximo){
+
+	size_t leidas = 0;
+	char* fin;
+
+	while(*texto && leidas < maximo){
+		double valor = strtod(texto, &fin);
+		if(fin == texto || valor < 1)
+			break;
+		cantidades[leidas++] = (size_t)valor;
+		texto = *fin == ',' ? fin + 1 : fin;
+	}
+
+	return leidas;
+}
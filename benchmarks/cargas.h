@@ -0,0 +1,152 @@
+#ifndef __CARGAS_H__
+#define __CARGAS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Cargas de trabajo compartidas por benchmark.c y baseline.cpp, para que
+ * el hash y std::unordered_map midan exactamente las mismas claves en el
+ * mismo orden. Todo se genera a partir de una semilla, asi que dos
+ * corridas con la misma semilla son comparables.
+ */
+
+/*
+ * Distribuciones de claves:
+ * UNIFORME: claves de 16 digitos hexadecimales al azar, accedidas con
+ * probabilidad uniforme.
+ * ZIPF: las mismas claves, pero las busquedas y reemplazos siguen una
+ * distribucion de Zipf (s = 0.99): unas pocas claves concentran la
+ * mayoria de los accesos.
+ * SECUENCIAL: los numeros 0, 1, 2... escritos en decimal y accedidos en
+ * orden.
+ * PATENTES: patentes de formato fijo "AB123CD", como las claves de las
+ * pruebas, accedidas con probabilidad uniforme.
+ */
+typedef enum distribucion{
+	DISTRIBUCION_UNIFORME = 0,
+	DISTRIBUCION_ZIPF,
+	DISTRIBUCION_SECUENCIAL,
+	DISTRIBUCION_PATENTES,
+	CANTIDAD_DISTRIBUCIONES
+}distribucion_t;
+
+/*
+ * Carga de trabajo para una cantidad de claves:
+ * claves[i] son las cantidad claves a insertar, ausentes[i] otras
+ * cantidad claves que no se insertan (para las busquedas fallidas),
+ * accesos[i] el indice de la clave que toca en la i-esima busqueda o
+ * reemplazo y bajas[i] el indice de la i-esima clave a quitar (cada
+ * clave aparece una sola vez).
+ */
+typedef struct carga{
+	size_t cantidad;
+	char** claves;
+	char** ausentes;
+	size_t* accesos;
+	size_t* bajas;
+	char* textos;
+}carga_t;
+
+/*
+ * Resultado de medir una operacion: cuantas se hicieron, cuanto tardaron
+ * en total y los percentiles de la latencia de una operacion, medida en
+ * una de cada MUESTREO_LATENCIA operaciones.
+ */
+#define MUESTREO_LATENCIA 64
+
+typedef struct medicion{
+	size_t operaciones;
+	uint64_t inicio;
+	uint64_t nanosegundos;
+	uint64_t* muestras;
+	size_t cantidad_muestras;
+}medicion_t;
+
+/*
+ * Ejecuta la operacion numero indice de una medicion, midiendo su
+ * latencia si le toca ser muestreada.
+ */
+#define MEDIR_OPERACION(medicion, indice, operacion) do{ \
+	if((indice) % MUESTREO_LATENCIA == 0){ \
+		uint64_t inicio_operacion = reloj_ns(); \
+		operacion; \
+		medicion_muestra((medicion), reloj_ns() - inicio_operacion); \
+	} \
+	else{ \
+		operacion; \
+	} \
+}while(0)
+
+/*
+ * Devuelve el nombre de la distribucion o NULL si no existe.
+ */
+const char* nombre_distribucion(distribucion_t distribucion);
+
+/*
+ * Devuelve la distribucion con ese nombre, o CANTIDAD_DISTRIBUCIONES si
+ * no hay ninguna.
+ */
+distribucion_t distribucion_de_nombre(const char* nombre);
+
+/*
+ * Genera la carga de trabajo de cantidad claves con esa distribucion y
+ * semilla.
+ * Devuelve false si no hay memoria.
+ */
+bool carga_crear(carga_t* carga, distribucion_t distribucion, size_t cantidad, uint64_t semilla);
+
+/*
+ * Libera la memoria de la carga.
+ */
+void carga_destruir(carga_t* carga);
+
+/*
+ * Devuelve un instante en nanosegundos de un reloj monotono.
+ */
+uint64_t reloj_ns();
+
+/*
+ * Prepara la medicion de operaciones operaciones y empieza a contar el
+ * tiempo.
+ * Devuelve false si no hay memoria.
+ */
+bool medicion_iniciar(medicion_t* medicion, size_t operaciones);
+
+/*
+ * Deja de contar el tiempo de la medicion.
+ */
+void medicion_terminar(medicion_t* medicion);
+
+/*
+ * Guarda la latencia de una operacion muestreada.
+ */
+void medicion_muestra(medicion_t* medicion, uint64_t nanosegundos);
+
+/*
+ * Imprime una linea CSV con el resultado y libera las muestras:
+ * motor,distribucion,cantidad,operacion,ops_por_segundo,ns_por_op,p50_ns,p99_ns,p999_ns
+ */
+void medicion_informar(medicion_t* medicion, const char* motor, distribucion_t distribucion, size_t cantidad, const char* operacion);
+
+/*
+ * Imprime el encabezado de las lineas CSV.
+ */
+void informar_encabezado();
+
+/*
+ * Lee una lista de cantidades separadas por comas ("1000,1e6,100000000").
+ * Devuelve cuantas leyo, a lo sumo maximo.
+ */
+size_t leer_cantidades(const char* texto, size_t* cantidades, size_t maximo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CARGAS_H__ */
@@ -0,0 +1,248 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include "epoca.h"
+
+/*
+ * La epoca global solo avanza cuando todos los hilos que estan dentro
+ * de una seccion de lectura ya vieron la epoca actual. Un nodo retirado
+ * en la epoca e deja de ser alcanzable antes de que la epoca llegue a
+ * e + 1, asi que cuando llega a e + 2 ningun lector puede tenerlo.
+ *
+ * El estado de cada hilo guarda la epoca que vio en los bits altos y
+ * si esta leyendo en el bit bajo. Cada hilo guarda sus propios nodos
+ * retirados en orden, de modo que los que ya se pueden liberar estan
+ * siempre al principio.
+ *
+ * Cada registro ocupa sus propias lineas de cache: entrar y salir de
+ * una seccion de lectura escribe estado, y no debe invalidar la linea
+ * del registro de otro hilo.
+ */
+
+#define LEYENDO 1u
+#define RETIROS_POR_RECOLECCION 64
+#define LINEA_CACHE 64
+
+struct epoca_hilo{
+	_Alignas(LINEA_CACHE) _Atomic uint64_t estado;
+	atomic_bool en_uso;
+	epoca_t* epoca;
+	struct epoca_hilo* siguiente;
+	epoca_retiro_t* retirados;
+	epoca_retiro_t* ultimo_retirado;
+	size_t retiros_sin_recolectar;
+};
+
+struct epoca{
+	_Atomic uint64_t global;
+	_Atomic(epoca_hilo_t*) hilos;
+};
+
+/*
+ * Crea un dominio de epocas.
+ * Devuelve un puntero al dominio creado o NULL en caso de error.
+ */
+epoca_t* epoca_crear(){
+
+	epoca_t* epoca = malloc(sizeof(epoca_t));
+	if(!epoca)
+		return NULL;
+
+	atomic_init(&epoca->global, 0);
+	atomic_init(&epoca->hilos, NULL);
+
+	return epoca;
+}
+
+/*
+ * Registra al hilo que la llama en el dominio. El registro devuelto
+ * solo puede usarlo ese hilo.
+ * Devuelve el registro del hilo o NULL en caso de error.
+ */
+epoca_hilo_t* epoca_registrar(epoca_t* epoca){
+
+	if(!epoca)
+		return NULL;
+
+	// Primero intenta reutilizar el registro de un hilo que se dio de baja
+	for(epoca_hilo_t* hilo = atomic_load(&epoca->hilos); hilo; hilo = hilo->siguiente){
+		bool libre = false;
+		if(atomic_compare_exchange_strong(&hilo->en_uso, &libre, true))
+			return hilo;
+	}
+
+	epoca_hilo_t* hilo = aligned_alloc(LINEA_CACHE, sizeof(epoca_hilo_t));
+	if(!hilo)
+		return NULL;
+
+	atomic_init(&hilo->estado, 0);
+	atomic_init(&hilo->en_uso, true);
+	hilo->epoca = epoca;
+	hilo->retirados = NULL;
+	hilo->ultimo_retirado = NULL;
+	hilo->retiros_sin_recolectar = 0;
+
+	epoca_hilo_t* primero = atomic_load(&epoca->hilos);
+	do{
+		hilo->siguiente = primero;
+	}while(!atomic_compare_exchange_weak(&epoca->hilos, &primero, hilo));
+
+	return hilo;
+}
+
+/*
+ * Da de baja el registro del hilo, que no puede estar dentro de una
+ * seccion de lectura. Los nodos que retiro y todavia no se liberaron
+ * se liberan mas adelante o al destruir el dominio.
+ */
+void epoca_desregistrar(epoca_hilo_t* hilo){
+
+	if(!hilo)
+		return;
+
+	epoca_recolectar(hilo);
+	atomic_store(&hilo->en_uso, false);
+}
+
+/*
+ * Empieza una seccion de lectura. Hasta llamar a epoca_salir, ningun
+ * nodo al que el hilo llegue recorriendo la estructura se libera.
+ */
+void epoca_entrar(epoca_hilo_t* hilo){
+
+	uint64_t global = atomic_load_explicit(&hilo->epoca->global, memory_order_relaxed);
+	uint64_t vista;
+
+	// El anuncio tiene que ser visible antes de cualquier lectura de la
+	// estructura; si la epoca avanzo mientras tanto se vuelve a anunciar.
+	do{
+		vista = global;
+		atomic_store_explicit(&hilo->estado, (vista << 1) | LEYENDO, memory_order_relaxed);
+		atomic_thread_fence(memory_order_seq_cst);
+		global = atomic_load_explicit(&hilo->epoca->global, memory_order_relaxed);
+	}while(global != vista);
+}
+
+/*
+ * Termina la seccion de lectura empezada con epoca_entrar.
+ */
+void epoca_salir(epoca_hilo_t* hilo){
+
+	atomic_store_explicit(&hilo->estado, 0, memory_order_release);
+}
+
+// pre: epoca es distinto de NULL
+// pos: avanza la epoca global si todos los hilos que estan leyendo ya vieron la actual. Devuelve la epoca global resultante
+uint64_t epoca_intentar_avanzar(epoca_t* epoca){
+
+	uint64_t global = atomic_load(&epoca->global);
+
+	for(epoca_hilo_t* hilo = atomic_load(&epoca->hilos); hilo; hilo = hilo->siguiente){
+		uint64_t estado = atomic_load(&hilo->estado);
+		if((estado & LEYENDO) && (estado >> 1) != global)
+			return global;
+	}
+
+	if(atomic_compare_exchange_strong(&epoca->global, &global, global + 1))
+		return global + 1;
+
+	return global;
+}
+
+// pre: retiro es distinto de NULL
+// pos: libera los nodos de la lista que empieza en retiro
+void liberar_retirados(epoca_retiro_t* retiro){
+
+	while(retiro){
+		epoca_retiro_t* siguiente = retiro->siguiente;
+		retiro->liberar(retiro);
+		retiro = siguiente;
+	}
+}
+
+/*
+ * Libera los nodos retirados por el hilo que ya no puede estar leyendo
+ * nadie. Tambien lo hace epoca_retirar cada tanto.
+ */
+void epoca_recolectar(epoca_hilo_t* hilo){
+
+	if(!hilo || !hilo->retirados)
+		return;
+
+	uint64_t global = epoca_intentar_avanzar(hilo->epoca);
+
+	while(hilo->retirados && hilo->retirados->epoca + 2 <= global){
+		epoca_retiro_t* retiro = hilo->retirados;
+		hilo->retirados = retiro->siguiente;
+		retiro->liberar(retiro);
+	}
+
+	if(!hilo->retirados)
+		hilo->ultimo_retirado = NULL;
+}
+
+/*
+ * Retira un nodo que ya no es alcanzable desde la estructura. Su
+ * funcion liberar se invoca cuando todos los hilos que estaban leyendo
+ * al retirarlo hayan salido de su seccion de lectura.
+ */
+void epoca_retirar(epoca_hilo_t* hilo, epoca_retiro_t* retiro, void (*liberar)(epoca_retiro_t* retiro)){
+
+	if(!hilo || !retiro || !liberar)
+		return;
+
+	// La epoca se lee despues de que el nodo dejo de ser alcanzable
+	atomic_thread_fence(memory_order_seq_cst);
+
+	retiro->siguiente = NULL;
+	retiro->liberar = liberar;
+	retiro->epoca = atomic_load(&hilo->epoca->global);
+
+	if(hilo->ultimo_retirado)
+		hilo->ultimo_retirado->siguiente = retiro;
+	else
+		hilo->retirados = retiro;
+	hilo->ultimo_retirado = retiro;
+
+	if(++hilo->retiros_sin_recolectar >= RETIROS_POR_RECOLECCION){
+		hilo->retiros_sin_recolectar = 0;
+		epoca_recolectar(hilo);
+	}
+}
+
+/*
+ * Espera a que terminen todas las secciones de lectura que estaban en
+ * curso al llamarla. El hilo no puede estar dentro de una.
+ */
+void epoca_sincronizar(epoca_hilo_t* hilo){
+
+	if(!hilo)
+		return;
+
+	// Para llegar a global + 2 todos los que estan leyendo tienen que haber visto
+	// global + 1, asi que entraron despues de esta llamada
+	uint64_t objetivo = atomic_load(&hilo->epoca->global) + 2;
+	while(epoca_intentar_avanzar(hilo->epoca) < objetivo)
+		sched_yield();
+}
+
+/*
+ * Destruye el dominio, liberando todos los nodos retirados pendientes
+ * y los registros de los hilos. Ningun hilo puede estar usandolo.
+ */
+void epoca_destruir(epoca_t* epoca){
+
+	if(!epoca)
+		return;
+
+	epoca_hilo_t* hilo = atomic_load(&epoca->hilos);
+	while(hilo){
+		epoca_hilo_t* siguiente = hilo->siguiente;
+		liberar_retirados(hilo->retirados);
+		free(hilo);
+		hilo = siguiente;
+	}
+
+	free(epoca);
+}
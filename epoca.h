@@ -0,0 +1,88 @@
+#ifndef __EPOCA_H__
+#define __EPOCA_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Recoleccion por epocas. Permite que varios hilos lean una estructura
+ * enlazada sin candados mientras otro hilo le quita nodos: el nodo
+ * quitado no se libera en el momento sino que se retira, y se libera
+ * recien cuando ningun hilo que pudiera estar leyendolo sigue dentro
+ * de una seccion de lectura.
+ *
+ * Cada hilo que lee o retira nodos se registra una vez y usa su propio
+ * epoca_hilo_t. Entrar y salir de una seccion de lectura solo escribe
+ * en el registro del propio hilo.
+ */
+typedef struct epoca epoca_t;
+typedef struct epoca_hilo epoca_hilo_t;
+
+/*
+ * Encabezado que se agrega dentro de cada nodo que se quiere retirar.
+ * Al retirarlo se le indica la funcion que lo libera, que recibe este
+ * mismo encabezado. Retirar un nodo nunca reserva memoria.
+ */
+typedef struct epoca_retiro{
+	struct epoca_retiro* siguiente;
+	uint64_t epoca;
+	void (*liberar)(struct epoca_retiro* retiro);
+}epoca_retiro_t;
+
+/*
+ * Crea un dominio de epocas.
+ * Devuelve un puntero al dominio creado o NULL en caso de error.
+ */
+epoca_t* epoca_crear();
+
+/*
+ * Registra al hilo que la llama en el dominio. El registro devuelto
+ * solo puede usarlo ese hilo.
+ * Devuelve el registro del hilo o NULL en caso de error.
+ */
+epoca_hilo_t* epoca_registrar(epoca_t* epoca);
+
+/*
+ * Da de baja el registro del hilo, que no puede estar dentro de una
+ * seccion de lectura. Los nodos que retiro y todavia no se liberaron
+ * se liberan mas adelante o al destruir el dominio.
+ */
+void epoca_desregistrar(epoca_hilo_t* hilo);
+
+/*
+ * Empieza una seccion de lectura. Hasta llamar a epoca_salir, ningun
+ * nodo al que el hilo llegue recorriendo la estructura se libera.
+ */
+void epoca_entrar(epoca_hilo_t* hilo);
+
+/*
+ * Termina la seccion de lectura empezada con epoca_entrar.
+ */
+void epoca_salir(epoca_hilo_t* hilo);
+
+/*
+ * Retira un nodo que ya no es alcanzable desde la estructura. Su
+ * funcion liberar se invoca cuando todos los hilos que estaban leyendo
+ * al retirarlo hayan salido de su seccion de lectura.
+ */
+void epoca_retirar(epoca_hilo_t* hilo, epoca_retiro_t* retiro, void (*liberar)(epoca_retiro_t* retiro));
+
+/*
+ * Libera los nodos retirados por el hilo que ya no puede estar leyendo
+ * nadie. Tambien lo hace epoca_retirar cada tanto.
+ */
+void epoca_recolectar(epoca_hilo_t* hilo);
+
+/*
+ * Espera a que terminen todas las secciones de lectura que estaban en
+ * curso al llamarla. El hilo no puede estar dentro de una.
+ */
+void epoca_sincronizar(epoca_hilo_t* hilo);
+
+/*
+ * Destruye el dominio, liberando todos los nodos retirados pendientes
+ * y los registros de los hilos. Ningun hilo puede estar usandolo.
+ */
+void epoca_destruir(epoca_t* epoca);
+
+#endif /* __EPOCA_H__ */
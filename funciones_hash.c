@@ -0,0 +1,191 @@
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <sys/random.h>
+#include "hash_interno.h"
+
+/*
+ * Funciones de hash incluidas. Todas reciben la clave como bytes con su
+ * largo y una semilla de 64 bits, y devuelven un hash de 64 bits.
+ */
+
+#define SECRETO_0 0xa0761d6478bd642fULL
+#define SECRETO_1 0xe7037ed1a0b428dbULL
+#define SECRETO_2 0x8ebc6af09c88c6e3ULL
+#define SECRETO_3 0x589965cc75374cc3ULL
+
+// pre: p apunta a al menos 8 bytes
+// pos: devuelve los 8 bytes leidos como un entero
+uint64_t leer_64(const uint8_t* p){
+
+	uint64_t valor;
+	memcpy(&valor, p, sizeof(valor));
+	return valor;
+}
+
+// pre: p apunta a al menos 4 bytes
+// pos: devuelve los 4 bytes leidos como un entero
+uint64_t leer_32(const uint8_t* p){
+
+	uint32_t valor;
+	memcpy(&valor, p, sizeof(valor));
+	return valor;
+}
+
+// pre:
+// pos: devuelve la parte baja y la parte alta del producto de 128 bits de a y b
+void multiplicar_128(uint64_t* a, uint64_t* b){
+
+#ifdef __SIZEOF_INT128__
+	__uint128_t producto = (__uint128_t)*a * *b;
+	*a = (uint64_t)producto;
+	*b = (uint64_t)(producto >> 64);
+#else
+	uint64_t a_alto = *a >> 32, a_bajo = (uint32_t)*a;
+	uint64_t b_alto = *b >> 32, b_bajo = (uint32_t)*b;
+	uint64_t alto_alto = a_alto * b_alto, alto_bajo = a_alto * b_bajo;
+	uint64_t bajo_alto = a_bajo * b_alto, bajo_bajo = a_bajo * b_bajo;
+	uint64_t medio = alto_bajo + (bajo_bajo >> 32) + (uint32_t)bajo_alto;
+	*a = (medio << 32) | (uint32_t)bajo_bajo;
+	*b = alto_alto + (medio >> 32) + (bajo_alto >> 32);
+#endif
+}
+
+// pre:
+// pos: mezcla a y b en un solo valor de 64 bits
+uint64_t mezclar_128(uint64_t a, uint64_t b){
+
+	multiplicar_128(&a, &b);
+	return a ^ b;
+}
+
+/*
+ * Hash rapido para claves de origen confiable, al estilo de wyhash.
+ * Procesa la clave de a 16 o 48 bytes con multiplicaciones de 128 bits.
+ */
+uint64_t hash_funcion_rapida(const void* clave, size_t largo, uint64_t semilla){
+
+	const uint8_t* p = clave;
+	uint64_t a, b;
+
+	semilla ^= mezclar_128(semilla ^ SECRETO_0, SECRETO_1);
+
+	if(largo <= 16){
+		if(largo >= 4){
+			size_t desplazamiento = (largo >> 3) << 2;
+			a = (leer_32(p) << 32) | leer_32(p + desplazamiento);
+			b = (leer_32(p + largo - 4) << 32) | leer_32(p + largo - 4 - desplazamiento);
+		}
+		else if(largo > 0){
+			a = ((uint64_t)p[0] << 16) | ((uint64_t)p[largo >> 1] << 8) | p[largo - 1];
+			b = 0;
+		}
+		else
+			a = b = 0;
+	}
+	else{
+		size_t restantes = largo;
+		if(restantes > 48){
+			uint64_t semilla_1 = semilla, semilla_2 = semilla;
+			do{
+				semilla = mezclar_128(leer_64(p) ^ SECRETO_1, leer_64(p + 8) ^ semilla);
+				semilla_1 = mezclar_128(leer_64(p + 16) ^ SECRETO_2, leer_64(p + 24) ^ semilla_1);
+				semilla_2 = mezclar_128(leer_64(p + 32) ^ SECRETO_3, leer_64(p + 40) ^ semilla_2);
+				p += 48;
+				restantes -= 48;
+			}while(restantes > 48);
+			semilla ^= semilla_1 ^ semilla_2;
+		}
+		while(restantes > 16){
+			semilla = mezclar_128(leer_64(p) ^ SECRETO_1, leer_64(p + 8) ^ semilla);
+			p += 16;
+			restantes -= 16;
+		}
+		a = leer_64(p + restantes - 16);
+		b = leer_64(p + restantes - 8);
+	}
+
+	a ^= SECRETO_1;
+	b ^= semilla;
+	multiplicar_128(&a, &b);
+
+	return mezclar_128(a ^ SECRETO_0 ^ (uint64_t)largo, b ^ SECRETO_1);
+}
+
+#define ROTAR(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define RONDA_SIP(v0, v1, v2, v3) do{ \
+	v0 += v1; v1 = ROTAR(v1, 13); v1 ^= v0; v0 = ROTAR(v0, 32); \
+	v2 += v3; v3 = ROTAR(v3, 16); v3 ^= v2; \
+	v0 += v3; v3 = ROTAR(v3, 21); v3 ^= v0; \
+	v2 += v1; v1 = ROTAR(v1, 17); v1 ^= v2; v2 = ROTAR(v2, 32); \
+}while(0)
+
+// pre: clave apunta a al menos largo bytes
+// pos: devuelve el SipHash-2-4 de la clave con la clave secreta de 128 bits formada por k0 (bytes 0 a 7) y k1 (bytes 8 a 15)
+uint64_t siphash_2_4(const void* clave, size_t largo, uint64_t k0, uint64_t k1){
+
+	const uint8_t* p = clave;
+
+	uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+	uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+	uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+	uint64_t v3 = 0x7465646279746573ULL ^ k1;
+
+	const uint8_t* fin = p + (largo - largo % 8);
+	for(; p != fin; p += 8){
+		uint64_t m = leer_64(p);
+		v3 ^= m;
+		RONDA_SIP(v0, v1, v2, v3);
+		RONDA_SIP(v0, v1, v2, v3);
+		v0 ^= m;
+	}
+
+	uint64_t ultimo = (uint64_t)largo << 56;
+	for(size_t i = 0; i < largo % 8; i++)
+		ultimo |= (uint64_t)p[i] << (8 * i);
+
+	v3 ^= ultimo;
+	RONDA_SIP(v0, v1, v2, v3);
+	RONDA_SIP(v0, v1, v2, v3);
+	v0 ^= ultimo;
+
+	v2 ^= 0xff;
+	for(int i = 0; i < 4; i++)
+		RONDA_SIP(v0, v1, v2, v3);
+
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/*
+ * SipHash-2-4 para claves que pueden venir de un atacante. La clave
+ * secreta de 128 bits se deriva de la semilla.
+ */
+uint64_t hash_funcion_siphash(const void* clave, size_t largo, uint64_t semilla){
+
+	uint64_t k0 = semilla;
+	uint64_t k1 = mezclar_128(semilla ^ SECRETO_2, SECRETO_3);
+
+	return siphash_2_4(clave, largo, k0, k1);
+}
+
+// pre:
+// pos: devuelve una semilla impredecible, pedida al sistema con getrandom si esta disponible
+uint64_t semilla_aleatoria(){
+
+	static _Atomic uint64_t contador = 0;
+	uint64_t semilla = 0;
+
+	// Una sola llamada al sistema, sin abrir archivos; nunca se bloquea esperando entropia
+	if(getrandom(&semilla, sizeof(semilla), GRND_NONBLOCK) != (ssize_t)sizeof(semilla))
+		semilla = 0;
+
+	// Varios hilos pueden crear hashes a la vez: cada uno se lleva un valor distinto del contador
+	if(semilla == 0){
+		uint64_t propio = atomic_fetch_add(&contador, 1) + 1;
+		semilla = (uint64_t)time(NULL) ^ (uint64_t)clock() ^ (uint64_t)(uintptr_t)&contador ^ (propio << 32);
+		semilla = mezclar_128(semilla ^ SECRETO_0, SECRETO_1);
+	}
+
+	return semilla;
+}
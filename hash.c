@@ -1,59 +1,28 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
 #include <stdio.h>
-#include <stdio.h>
-#include "hash.h"
-#include "lista.h"
 #include <string.h>
+#include <time.h>
+#include "hash.h"
 #include "hash_iterador.h"
+#include "hash_interno.h"
 
-#define SIN_ELEMENTOS 0
-#define ERROR -1
-#define EXITO 0
-#define FACTOR_REHASH 3
-
-struct hash{
-	lista_t** index;
-	hash_destruir_dato_t destructor;
-	size_t cantidad_elementos;
-	size_t capacidad;
-	size_t factor_carga;
-};
-
-typedef struct elemento{
-	char* clave;
-	void* elemento;
-}elemento_t;
-
-extern char* strdup(const char*);
-
-// pre: 
-// pos: devuelve TRUE si pudo inicializar todas las listas correctamente, FALSE en caso contrario
-bool inicializar_listas(lista_t** index, size_t pos_inicial, size_t capacidad){
-
-	if(!index)
-		return false;
-
-	size_t cantidad_inicializadas = 0;
-	size_t i = pos_inicial;
-	bool inicializa_correctamente = true;
-
-	while(i < capacidad && inicializa_correctamente){
+#define BLOQUE_LOTE 16
 
-		index[i] = lista_crear();
-		if(!index[i])
-			inicializa_correctamente = false;
-		else{
-			i++;
-			cantidad_inicializadas++;
-		}
-	}
-
-	if(!inicializa_correctamente){
-		for (size_t i = pos_inicial; i < cantidad_inicializadas + pos_inicial; i++)
-			lista_destruir(index[i]);
+// pre:
+// pos: devuelve las operaciones del motor pedido o NULL si el motor no existe
+const hash_operaciones_t* operaciones_del_motor(hash_motor_t motor){
+
+	switch(motor){
+		case HASH_MOTOR_LISTAS:
+			return &OPERACIONES_LISTAS;
+		case HASH_MOTOR_ABIERTO:
+			return &OPERACIONES_ABIERTO;
+		case HASH_MOTOR_ENCADENADO:
+			return &OPERACIONES_ENCADENADO;
 	}
 
-	return inicializa_correctamente;
+	return NULL;
 }
 
 /*
@@ -65,23 +34,54 @@ bool inicializar_listas(lista_t** index, size_t pos_inicial, size_t capacidad){
  */
 hash_t* hash_crear(hash_destruir_dato_t destruir_elemento, size_t capacidad){
 
-	hash_t* hash = malloc(sizeof(hash_t));
+	return hash_crear_con_opciones(destruir_elemento, capacidad, NULL);
+}
+
+/*
+ * Crea el hash igual que hash_crear pero permitiendo elegir como se
+ * almacenan los elementos. Si opciones es NULL se usan las opciones
+ * por defecto.
+ * Devuelve un puntero al hash creado o NULL en caso de no poder crearlo.
+ */
+hash_t* hash_crear_con_opciones(hash_destruir_dato_t destruir_elemento, size_t capacidad, const hash_opciones_t* opciones){
+
+	hash_opciones_t por_defecto = {0};
+	if(!opciones)
+		opciones = &por_defecto;
+
+	const hash_operaciones_t* operaciones = operaciones_del_motor(opciones->motor);
+	if(!operaciones)
+		return NULL;
+
+	hash_funcion_t funcion = opciones->funcion ? opciones->funcion : hash_funcion_rapida;
+	uint64_t semilla = opciones->semilla_fija ? opciones->semilla : semilla_aleatoria();
+	hash_t* hash = hash_nuevo(operaciones, funcion, semilla, capacidad, destruir_elemento);
 	if(!hash)
 		return NULL;
 
-	hash->capacidad = capacidad;
-	hash->cantidad_elementos = SIN_ELEMENTOS;
-	hash->destructor = destruir_elemento;
-	hash->factor_carga = 0;
+	hash->rehash_incremental = opciones->rehash_incremental;
+	hash->hilos_rehash = opciones->hilos_rehash;
 
-	hash->index = malloc(sizeof(void*) * capacidad);
-	if(!hash->index){
-		free(hash);
-		return NULL;
+	if(opciones->asignacion == HASH_ASIGNACION_SLAB){
+		hash->slab = slab_crear();
+		if(!hash->slab){
+			free(hash);
+			return NULL;
+		}
+	}
+
+	if(opciones->muestreo_latencia > 0){
+		hash->instrumentacion = instrumentacion_crear(opciones->muestreo_latencia, opciones->contadores_hardware);
+		if(!hash->instrumentacion){
+			slab_destruir(hash->slab);
+			free(hash);
+			return NULL;
+		}
 	}
 
-	if(!inicializar_listas(hash->index, 0, hash->capacidad)){
-		free(hash->index);
+	if(!hash->operaciones->crear(hash, capacidad)){
+		instrumentacion_destruir(hash->instrumentacion);
+		slab_destruir(hash->slab);
 		free(hash);
 		return NULL;
 	}
@@ -89,128 +89,147 @@ hash_t* hash_crear(hash_destruir_dato_t destruir_elemento, size_t capacidad){
 	return hash;
 }
 
-// pre: clave es distinto de NULL
-// pos: devuelve un entero que representa la posicion a insertar en el hash
-int determinar_posicion_hash(const char* clave){
+// pre: operaciones es distinto de NULL
+// pos: reserva un hash con esas operaciones, funcion, semilla, capacidad y destructor, sin slab, arena ni instrumentacion y con los demas campos en cero. La memoria propia del motor todavia no se reserva. Devuelve NULL si no hay memoria
+hash_t* hash_nuevo(const hash_operaciones_t* operaciones, hash_funcion_t funcion, uint64_t semilla, size_t capacidad, hash_destruir_dato_t destructor){
 
-	if(!clave)
-		return ERROR;
+	hash_t* hash = malloc(sizeof(hash_t));
+	if(!hash)
+		return NULL;
 
-	size_t tamanio_clave = strlen(clave);
-	int numero = 257;
-	int resultado = 0;
+	*hash = (hash_t){
+		.operaciones = operaciones,
+		.funcion = funcion,
+		.semilla = semilla,
+		.destructor = destructor,
+		.capacidad = capacidad,
+		.cantidad_elementos = SIN_ELEMENTOS
+	};
 
-	for(size_t i = 0; i < tamanio_clave; i++)
-		resultado += (int)clave[i] * numero;
+	return hash;
+}
 
-	return resultado;
+// pre: hash es distinto de NULL
+// pos: reserva tamanio bytes del slab del hash, o con malloc si no usa slab
+void* hash_reservar_memoria(hash_t* hash, size_t tamanio){
+
+	if(hash->slab)
+		return slab_reservar(hash->slab, tamanio);
+
+	return malloc(tamanio);
 }
 
-// pre: clave es distinto de NULL
-// pos: devuelve un puntero a un elemento con dicha clave y elementos
-elemento_t* crear_elemento(char* clave, void* elemento){
+// pre: hash es distinto de NULL y bloque fue reservado con hash_reservar_memoria con el mismo tamanio
+// pos: libera el bloque
+void hash_liberar_memoria(hash_t* hash, void* bloque, size_t tamanio){
 
-	if(!clave)
-		return NULL;
+	if(hash->slab)
+		slab_liberar(hash->slab, bloque, tamanio);
+	else
+		free(bloque);
+}
 
-	elemento_t* elem = malloc(sizeof(elemento_t));
-	if(!elem)
+// pre: hash y clave son distintos de NULL
+// pos: devuelve una copia de los largo bytes de clave, seguida de un '\0', reservada con hash_reservar_memoria o NULL si no hay memoria
+char* hash_copiar_clave(hash_t* hash, const void* clave, size_t largo){
+
+	char* copia = hash_reservar_memoria(hash, largo + 1);
+	if(!copia)
 		return NULL;
 
-	elem->clave = strdup(clave);
-	elem->elemento = elemento;
+	memcpy(copia, clave, largo);
+	copia[largo] = '\0';
 
-	return elem;
+	return copia;
 }
 
-// pre: 
-// pos: devuelve TRUE si el numero es primo, FALSE caso contrario.
-bool es_primo(size_t numero){
+// pre: hash es distinto de NULL y clave fue copiada con hash_copiar_clave con el mismo largo
+// pos: libera la copia de la clave
+void hash_liberar_clave(hash_t* hash, char* clave, size_t largo){
 
-	if(numero <= 2)
-		return false;
+	hash_liberar_memoria(hash, clave, largo + 1);
+}
+
+// pre: hash y muestra son distintos de NULL
+// pos: devuelve true si el hash mide latencias y le toca a esta operacion, que empieza a medirse
+bool empezar_medicion(hash_t* hash, muestra_t* muestra){
+
+	return hash->instrumentacion && instrumentacion_empezar(hash->instrumentacion, muestra);
+}
+
+// pre: hash es distinto de NULL y medir es lo que devolvio empezar_medicion con muestra
+// pos: si medir es true, registra la latencia de la operacion
+void terminar_medicion(hash_t* hash, bool medir, hash_operacion_t operacion, const muestra_t* muestra){
 
-	size_t i = 2;
-	bool es_primo = true;
+	if(medir)
+		instrumentacion_terminar(hash->instrumentacion, operacion, muestra);
+}
 
-	while(es_primo && i < numero){
+// pre: hash y clave son distintos de NULL y valor_hash es el hash de la clave
+// pos: inserta o reemplaza el elemento con una sola busqueda. Si anterior no es NULL guarda en el el elemento reemplazado en vez de destruirlo. Devuelve 0 si pudo o -1 si no
+int insertar_o_reemplazar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash, void* elemento, void** anterior){
 
-		if(numero % i == 0)
-			es_primo = false;
+	muestra_t muestra;
+	bool medir = empezar_medicion(hash, &muestra);
 
-		i++;
+	bool insertado;
+	void** lugar = hash->operaciones->buscar_o_insertar(hash, clave, largo, valor_hash, &insertado);
+	if(lugar){
+		if(anterior)
+			*anterior = insertado ? NULL : *lugar;
+		else if(!insertado && hash->destructor && *lugar != elemento)
+			hash->destructor(*lugar);
+
+		*lugar = elemento;
 	}
 
-	return es_primo;
+	terminar_medicion(hash, medir, HASH_OPERACION_INSERTAR, &muestra);
+
+	return lugar ? EXITO : ERROR;
 }
 
-// pre:
-// pos: devuelve el numero primo mas cercano a numero
-size_t numero_primo_mas_cercano(size_t numero){
+// pre: hash, clave e insertado son distintos de NULL y valor_hash es el hash de la clave
+// pos: devuelve el lugar del elemento de la clave, insertandola con elemento NULL si no estaba, o NULL si no pudo. Se mide como una insercion
+void** obtener_o_insertar_clave(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash, bool* insertado){
 
-	bool primo = false;
-	size_t i = numero;
+	muestra_t muestra;
+	bool medir = empezar_medicion(hash, &muestra);
 
-	while(!primo){
+	void** lugar = hash->operaciones->buscar_o_insertar(hash, clave, largo, valor_hash, insertado);
 
-		if(es_primo(i))
-			primo = true;
-		else
-			i++;
-	}
+	terminar_medicion(hash, medir, HASH_OPERACION_INSERTAR, &muestra);
 
-	return i;
+	return lugar;
 }
 
-// pre:
-// pos: agranda el tamaño del arreglo de listas. vuelve a insertar todos los elementos. Devuelve 0 si se ejecuto correctamente, -1 caso contrario
-int hash_rehashear(hash_t* hash){
+// pre: hash y clave son distintos de NULL y valor_hash es el hash de la clave
+// pos: quita la clave invocando al destructor con su elemento. Devuelve 0 si pudo o -1 si no estaba
+int quitar_clave(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash){
 
-	if(!hash)
-		return ERROR;
-	
-	size_t nueva_capacidad = numero_primo_mas_cercano(2 * hash->capacidad);
+	muestra_t muestra;
+	bool medir = empezar_medicion(hash, &muestra);
 
-	void* aux = realloc(hash->index, nueva_capacidad* sizeof(void*));
-	if(!aux)
-		return ERROR;
+	int resultado = hash->operaciones->quitar(hash, clave, largo, valor_hash);
 
-	size_t cantidad_aux = hash->capacidad;
-	hash->capacidad = nueva_capacidad;
-	hash->index = aux;
+	terminar_medicion(hash, medir, HASH_OPERACION_QUITAR, &muestra);
 
-	if(!inicializar_listas(aux, cantidad_aux, hash->capacidad)){
-		hash->capacidad = cantidad_aux;
-		return ERROR;
-	}
+	return resultado;
+}
 
-	elemento_t* elem[hash->cantidad_elementos];
-	int tope_elem = 0;
-
-	for(int i = 0; i < cantidad_aux; i++){
-
-		while(!lista_vacia(hash->index[i])){
-			lista_iterador_t* iter = lista_iterador_crear(hash->index[i]);
-			elemento_t* aux = lista_iterador_siguiente(iter);
-			if(aux){	
-				elem[tope_elem] = aux;
-				tope_elem++;
-				lista_borrar_de_posicion(hash->index[i], 0);
-				hash->cantidad_elementos--;
-			}
-			lista_iterador_destruir(iter);
-		}
-	}
+// pre: hash y clave son distintos de NULL y valor_hash es el hash de la clave
+// pos: devuelve true si la clave esta, dejando su elemento en elemento si no es NULL
+bool buscar_clave(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash, void** elemento){
 
-	for(int j = 0; j < tope_elem; j++){
+	muestra_t muestra;
+	bool medir = empezar_medicion(hash, &muestra);
 
-		size_t posicion_hash = (size_t) determinar_posicion_hash(elem[j]->clave) % hash->capacidad;
-		lista_insertar(hash->index[posicion_hash], elem[j]);
-		hash->cantidad_elementos++;
-	}
+	bool encontrada = hash->operaciones->buscar(hash, clave, largo, valor_hash, elemento);
 
-	return EXITO;
+	terminar_medicion(hash, medir, HASH_OPERACION_OBTENER, &muestra);
+
+	return encontrada;
 }
+
 /*
  * Inserta un elemento reservando la memoria necesaria para el mismo.
  * Devuelve 0 si pudo guardarlo o -1 si no pudo.
@@ -220,25 +239,43 @@ int hash_insertar(hash_t* hash, const char* clave, void* elemento){
 	if(!hash || !clave)
 		return ERROR;
 
-	if(hash_contiene(hash, clave))
-		hash_quitar(hash, clave);
+	return hash_insertar_n(hash, clave, strlen(clave), elemento);
+}
 
+/*
+ * Inserta el elemento o, si la clave ya existia, reemplaza su elemento,
+ * buscando la clave una sola vez.
+ * Si anterior no es NULL, guarda en el el elemento reemplazado (o NULL
+ * si la clave no existia) y no se invoca al destructor; si anterior es
+ * NULL el elemento reemplazado se destruye igual que en hash_insertar.
+ * Devuelve 0 si pudo guardarlo o -1 si no pudo.
+ */
+int hash_insertar_o_reemplazar(hash_t* hash, const char* clave, void* elemento, void** anterior){
 
-	hash->cantidad_elementos++;
-	hash->factor_carga = hash->cantidad_elementos/hash->capacidad;
+	if(!hash || !clave)
+		return ERROR;
 
-	if(hash->factor_carga >= FACTOR_REHASH){
-		if(hash_rehashear(hash) == ERROR)
-				return ERROR;
-	}
+	size_t largo = strlen(clave);
 
-	elemento_t* elemento_a_insertar = crear_elemento((char*)clave, elemento);
-	if(!elemento_a_insertar)
-		return ERROR;
+	return insertar_o_reemplazar(hash, clave, largo, hash_calcular(hash, clave, largo), elemento, anterior);
+}
+
+/*
+ * Busca la clave y, si no existe, la inserta con elemento NULL, todo
+ * con una sola busqueda. Devuelve un puntero al lugar donde el hash
+ * guarda el elemento de esa clave, para leerlo o modificarlo en el
+ * lugar, o NULL si no pudo insertar la clave.
+ * Si insertado no es NULL, guarda en el true si la clave fue insertada
+ * o false si ya existia.
+ * El puntero devuelto deja de ser valido con la proxima insercion o
+ * borrado en el hash.
+ */
+void** hash_obtener_o_insertar(hash_t* hash, const char* clave, bool* insertado){
 
-	size_t posicion_hash = (size_t) determinar_posicion_hash(clave) % hash->capacidad;
+	if(!hash || !clave)
+		return NULL;
 
-	return lista_insertar(hash->index[posicion_hash], elemento_a_insertar);
+	return hash_obtener_o_insertar_n(hash, clave, strlen(clave), insertado);
 }
 
 /*
@@ -251,97 +288,105 @@ int hash_quitar(hash_t* hash, const char* clave){
 	if(!hash || !clave)
 		return ERROR;
 
-	size_t posicion_hash = (size_t) determinar_posicion_hash(clave) % hash->capacidad;
+	return hash_quitar_n(hash, clave, strlen(clave));
+}
 
-	lista_iterador_t* iter = lista_iterador_crear(hash->index[posicion_hash]);
-	if(!iter)
-		return ERROR;
+/*
+ * Devuelve un elemento del hash con la clave dada o NULL si dicho
+ * elemento no existe.
+ */
+void* hash_obtener(hash_t* hash, const char* clave){
 
-	elemento_t* elem;
-	size_t posicion_a_borrar = 0;
-	bool encontro = false;
+	if(!hash || !clave)
+		return NULL;
 
-	while(lista_iterador_tiene_siguiente(iter) && !encontro){
-		elem = lista_iterador_siguiente(iter);
+	return hash_obtener_n(hash, clave, strlen(clave));
+}
 
-		if(strcmp(elem->clave, clave) == 0)
-			encontro = true;
-		else
-			posicion_a_borrar++;
-	}
+/*
+ * Devuelve true si el hash contiene un elemento almacenado con la
+ * clave dada o false en caso contrario.
+ */
+bool hash_contiene(hash_t* hash, const char* clave){
+
+	if(!hash || !clave)
+		return false;
 
-	lista_iterador_destruir(iter);
+	return hash_contiene_n(hash, clave, strlen(clave));
+}
 
-	if(encontro){
-		if(hash->destructor)
-			hash->destructor(elem->elemento);
-		free(elem->clave);
-		free(elem);
-		hash->cantidad_elementos--;
-		return lista_borrar_de_posicion(hash->index[posicion_hash], posicion_a_borrar);
-	}
-	else
+/*
+ * Versiones de hash_insertar, hash_obtener_o_insertar, hash_quitar,
+ * hash_obtener y hash_contiene cuya clave son los largo bytes a partir
+ * de clave, sin '\0' final. La clave puede contener bytes en cero y se
+ * compara byte a byte con memcmp, asi que puede apuntar directamente a
+ * un buffer de entrada sin copiarla antes; el hash solo copia la clave
+ * cuando la inserta.
+ * Las claves insertadas asi se guardan con un '\0' agregado al final,
+ * de modo que el iterador las devuelve igual que a las demas. Una clave
+ * insertada con hash_insertar es la misma que sus bytes sin el '\0'
+ * insertada con hash_insertar_n.
+ */
+int hash_insertar_n(hash_t* hash, const void* clave, size_t largo, void* elemento){
+
+	if(!hash || !clave)
 		return ERROR;
+
+	return insertar_o_reemplazar(hash, clave, largo, hash_calcular(hash, clave, largo), elemento, NULL);
 }
 
 /*
- * Devuelve un elemento del hash con la clave dada o NULL si dicho
- * elemento no existe.
+ * Igual que hash_obtener_o_insertar pero con una clave de largo bytes.
  */
-void* hash_obtener(hash_t* hash, const char* clave){
+void** hash_obtener_o_insertar_n(hash_t* hash, const void* clave, size_t largo, bool* insertado){
 
 	if(!hash || !clave)
 		return NULL;
 
-	size_t posicion_hash = (size_t) determinar_posicion_hash(clave) % hash->capacidad;
-	lista_iterador_t* iter = lista_iterador_crear(hash->index[posicion_hash]);
-	if(!iter)
-		return NULL;
+	bool fue_insertado;
+	void** lugar = obtener_o_insertar_clave(hash, clave, largo, hash_calcular(hash, clave, largo), &fue_insertado);
 
-	bool encontro = false;
-	elemento_t* elem;
+	if(lugar && insertado)
+		*insertado = fue_insertado;
 
-	while(lista_iterador_tiene_siguiente(iter) && !encontro){
-		elem = lista_iterador_siguiente(iter);
-		if(strcmp(clave, elem->clave) == 0)
-			encontro = true;
-	}
+	return lugar;
+}
+
+/*
+ * Igual que hash_quitar pero con una clave de largo bytes.
+ */
+int hash_quitar_n(hash_t* hash, const void* clave, size_t largo){
 
-	lista_iterador_destruir(iter);
+	if(!hash || !clave)
+		return ERROR;
 
-	if(encontro)
-		return elem->elemento;
-	else
-		return NULL;
+	return quitar_clave(hash, clave, largo, hash_calcular(hash, clave, largo));
 }
 
 /*
- * Devuelve true si el hash contiene un elemento almacenado con la
- * clave dada o false en caso contrario.
+ * Igual que hash_obtener pero con una clave de largo bytes.
  */
-bool hash_contiene(hash_t* hash, const char* clave){
+void* hash_obtener_n(hash_t* hash, const void* clave, size_t largo){
 
 	if(!hash || !clave)
-		return false;
-
-	size_t posicion_hash = (size_t) determinar_posicion_hash(clave) % hash->capacidad;
-	lista_iterador_t* iter = lista_iterador_crear(hash->index[posicion_hash]);
-	if(!iter)
-		return false;
+		return NULL;
 
-	bool encontro = false;
-	elemento_t* elem;
+	void* elemento;
+	if(!buscar_clave(hash, clave, largo, hash_calcular(hash, clave, largo), &elemento))
+		return NULL;
 
-	while(lista_iterador_tiene_siguiente(iter) && !encontro){
+	return elemento;
+}
 
-		elem = lista_iterador_siguiente(iter);
-		if(strcmp(clave, elem->clave) == 0)
-			encontro = true;
-	}
+/*
+ * Igual que hash_contiene pero con una clave de largo bytes.
+ */
+bool hash_contiene_n(hash_t* hash, const void* clave, size_t largo){
 
-	lista_iterador_destruir(iter);
+	if(!hash || !clave)
+		return false;
 
-	return encontro;
+	return buscar_clave(hash, clave, largo, hash_calcular(hash, clave, largo), NULL);
 }
 
 /*
@@ -355,34 +400,283 @@ size_t hash_cantidad(hash_t* hash){
 	return hash->cantidad_elementos;
 }
 
+/*
+ * Completa estadisticas con el estado actual del hash. Recorre todos los
+ * baldes, asi que cuesta O(capacidad + cantidad de elementos); los
+ * contadores de rehash se mantienen en cada redimension y no tienen
+ * costo en las demas operaciones.
+ * Devuelve 0 si pudo o -1 si el hash o estadisticas son NULL.
+ */
+int hash_estadisticas(hash_t* hash, hash_estadisticas_t* estadisticas){
+
+	if(!hash || !estadisticas)
+		return ERROR;
+
+	memset(estadisticas, 0, sizeof(hash_estadisticas_t));
+	estadisticas->cantidad = hash->cantidad_elementos;
+	estadisticas->capacidad = hash->capacidad;
+	estadisticas->factor_carga = hash->capacidad ? (double)hash->cantidad_elementos / (double)hash->capacidad : 0;
+	estadisticas->rehashes = hash->rehashes;
+	estadisticas->nanosegundos_rehash = hash->nanosegundos_rehash;
+
+	hash->operaciones->estadisticas(hash, estadisticas);
+
+	if(hash->cantidad_elementos)
+		estadisticas->sondeo_medio /= (double)hash->cantidad_elementos;
+
+	return EXITO;
+}
+
 // pre:
-// pos: borra todos los elementos del hash
-void borrar_todos_los_elementos(hash_t* hash){
+// pos: devuelve un instante en nanosegundos de un reloj monotono
+uint64_t hash_reloj_ns(){
+
+	struct timespec instante;
+	clock_gettime(CLOCK_MONOTONIC, &instante);
+
+	return (uint64_t)instante.tv_sec * 1000000000ull + (uint64_t)instante.tv_nsec;
+}
+
+// pre: hash es distinto de NULL e inicio fue devuelto por hash_reloj_ns
+// pos: suma el tiempo transcurrido desde inicio al tiempo de rehash del hash
+void hash_sumar_tiempo_rehash(hash_t* hash, uint64_t inicio){
+
+	hash->nanosegundos_rehash += hash_reloj_ns() - inicio;
+}
+
+// pre: estadisticas es distinto de NULL
+// pos: agrega a las estadisticas un balde con largo elementos, que una busqueda exitosa recorre en orden
+void hash_contar_cadena(hash_estadisticas_t* estadisticas, size_t largo){
+
+	estadisticas->histograma_cadenas[largo < HASH_LARGOS_CADENA ? largo : HASH_LARGOS_CADENA - 1]++;
+	if(largo == 0)
+		estadisticas->baldes_vacios++;
+	if(largo > estadisticas->cadena_maxima)
+		estadisticas->cadena_maxima = largo;
+	if(largo > estadisticas->sondeo_maximo)
+		estadisticas->sondeo_maximo = largo;
+	estadisticas->sondeo_medio += (double)largo * (double)(largo + 1) / 2;
+}
+
+/*
+ * Devuelve el hash de los largo bytes de clave calculado con la funcion
+ * y la semilla del hash, para usarlo con las funciones _con_hash.
+ * El valor sirve para cualquier tabla creada con la misma funcion y la
+ * misma semilla (ver semilla_fija en hash_opciones_t), de modo que una
+ * clave se calcula una sola vez aunque se busque en varias tablas.
+ */
+uint64_t hash_calcular(const hash_t* hash, const void* clave, size_t largo){
+
+	if(!hash || (!clave && largo > 0))
+		return 0;
+
+	return hash->funcion(clave, largo, hash->semilla);
+}
+
+/*
+ * Versiones de hash_insertar, hash_quitar, hash_obtener y hash_contiene
+ * que reciben el hash de la clave ya calculado con hash_calcular sobre
+ * la clave sin su '\0'. Si valor_hash no es el hash de la clave en esta
+ * tabla, el resultado no esta definido.
+ */
+int hash_insertar_con_hash(hash_t* hash, const char* clave, uint64_t valor_hash, void* elemento){
+
+	if(!hash || !clave)
+		return ERROR;
+
+	return insertar_o_reemplazar(hash, clave, strlen(clave), valor_hash, elemento, NULL);
+}
+
+/*
+ * Igual que hash_quitar pero con el hash de la clave ya calculado.
+ */
+int hash_quitar_con_hash(hash_t* hash, const char* clave, uint64_t valor_hash){
+
+	if(!hash || !clave)
+		return ERROR;
+
+	return quitar_clave(hash, clave, strlen(clave), valor_hash);
+}
+
+/*
+ * Igual que hash_obtener pero con el hash de la clave ya calculado.
+ */
+void* hash_obtener_con_hash(hash_t* hash, const char* clave, uint64_t valor_hash){
+
+	if(!hash || !clave)
+		return NULL;
+
+	void* elemento;
+	if(!buscar_clave(hash, clave, strlen(clave), valor_hash, &elemento))
+		return NULL;
+
+	return elemento;
+}
+
+/*
+ * Igual que hash_contiene pero con el hash de la clave ya calculado.
+ */
+bool hash_contiene_con_hash(hash_t* hash, const char* clave, uint64_t valor_hash){
+
+	if(!hash || !clave)
+		return false;
+
+	return buscar_clave(hash, clave, strlen(clave), valor_hash, NULL);
+}
+
+/*
+ * Prepara el hash para guardar cantidad elementos en total sin tener
+ * que agrandarse, haciendo de una sola vez la redimension que harian
+ * las inserciones a medida que la tabla se llena. Nunca achica la
+ * tabla.
+ * Devuelve 0 si pudo o -1 si no pudo.
+ */
+int hash_reservar(hash_t* hash, size_t cantidad){
 
 	if(!hash)
-		return;
+		return ERROR;
+
+	return hash->operaciones->reservar(hash, cantidad);
+}
 
-	elemento_t* elem;
-	for(int i = 0; i < hash->capacidad; i++){
+// pre: hash y claves son distintos de NULL y cantidad es a lo sumo BLOQUE_LOTE
+// pos: guarda el largo y el hash de cada clave no NULL y pide a cache, para todas juntas, primero sus baldes y despues sus primeros elementos
+void preparar_bloque(hash_t* hash, const char* const* claves, size_t cantidad, size_t* largos, uint64_t* valores_hash){
+
+	for(size_t i = 0; i < cantidad; i++){
+		if(!claves[i])
+			continue;
+		largos[i] = strlen(claves[i]);
+		valores_hash[i] = hash_calcular(hash, claves[i], largos[i]);
+		hash->operaciones->anticipar_balde(hash, valores_hash[i]);
+	}
+
+	for(size_t i = 0; i < cantidad; i++){
+		if(claves[i])
+			hash->operaciones->anticipar_elemento(hash, valores_hash[i]);
+	}
+}
 
-		while(!lista_vacia(hash->index[i])){
+// pre: hash y claves son distintos de NULL
+// pos: busca las claves por bloques y guarda en elementos (si no es NULL) cada elemento encontrado o NULL, y en presentes (si no es NULL) si cada clave esta. Devuelve la cantidad de claves encontradas
+size_t buscar_lote(hash_t* hash, const char* const* claves, size_t cantidad, void** elementos, bool* presentes){
 
-			lista_iterador_t* iter = lista_iterador_crear(hash->index[i]);
-			elem = lista_iterador_siguiente(iter);
+	size_t largos[BLOQUE_LOTE];
+	uint64_t valores_hash[BLOQUE_LOTE];
+	size_t encontradas = 0;
 
-			if(elem){
-				if(hash->destructor)
-					hash->destructor(elem->elemento);
-				free(elem->clave);
-				free(elem);
-				hash->cantidad_elementos--;
-				lista_borrar_de_posicion(hash->index[i], 0);
-			}
+	for(size_t inicio = 0; inicio < cantidad; inicio += BLOQUE_LOTE){
 
-			lista_iterador_destruir(iter);
+		size_t en_bloque = cantidad - inicio < BLOQUE_LOTE ? cantidad - inicio : BLOQUE_LOTE;
+		preparar_bloque(hash, claves + inicio, en_bloque, largos, valores_hash);
+
+		for(size_t i = 0; i < en_bloque; i++){
+			const char* clave = claves[inicio + i];
+			void* elemento = NULL;
+			bool presente = clave && buscar_clave(hash, clave, largos[i], valores_hash[i], &elemento);
+
+			if(elementos)
+				elementos[inicio + i] = presente ? elemento : NULL;
+			if(presentes)
+				presentes[inicio + i] = presente;
+			if(presente)
+				encontradas++;
 		}
 	}
 
+	return encontradas;
+}
+
+/*
+ * Inserta cantidad claves con sus elementos (claves[i] con
+ * elementos[i]) igual que hash_insertar. Antes de empezar reserva lugar
+ * para todas con hash_reservar, asi la tabla no se redimensiona en el
+ * medio de la carga. Despues las procesa por bloques:
+ * calcula los hashes del bloque, pide a cache todos sus baldes y
+ * despues todos sus primeros elementos, y recien entonces las inserta,
+ * de modo que las esperas a memoria de las distintas claves se
+ * superponen en vez de sumarse.
+ * Devuelve 0 si pudo guardarlas todas o -1 si alguna clave es NULL o
+ * no pudo guardarse; las claves anteriores a esa quedan insertadas.
+ */
+int hash_insertar_lote(hash_t* hash, const char* const* claves, void* const* elementos, size_t cantidad){
+
+	if(!hash || (cantidad > 0 && (!claves || !elementos)))
+		return ERROR;
+
+	if(hash_reservar(hash, hash->cantidad_elementos + cantidad) == ERROR)
+		return ERROR;
+
+	size_t largos[BLOQUE_LOTE];
+	uint64_t valores_hash[BLOQUE_LOTE];
+
+	for(size_t inicio = 0; inicio < cantidad; inicio += BLOQUE_LOTE){
+
+		size_t en_bloque = cantidad - inicio < BLOQUE_LOTE ? cantidad - inicio : BLOQUE_LOTE;
+		preparar_bloque(hash, claves + inicio, en_bloque, largos, valores_hash);
+
+		for(size_t i = 0; i < en_bloque; i++){
+			const char* clave = claves[inicio + i];
+			if(!clave || insertar_o_reemplazar(hash, clave, largos[i], valores_hash[i], elementos[inicio + i], NULL) == ERROR)
+				return ERROR;
+		}
+	}
+
+	return EXITO;
+}
+
+/*
+ * Busca cantidad claves igual que hash_obtener, procesandolas por
+ * bloques como hash_insertar_lote. Guarda en resultados[i] el elemento
+ * de claves[i], o NULL si no existe o si claves[i] es NULL.
+ * Devuelve la cantidad de claves encontradas.
+ */
+size_t hash_obtener_lote(hash_t* hash, const char* const* claves, size_t cantidad, void** resultados){
+
+	if(!hash || !claves || !resultados)
+		return 0;
+
+	return buscar_lote(hash, claves, cantidad, resultados, NULL);
+}
+
+/*
+ * Igual que hash_obtener_lote pero guardando en resultados[i] si el
+ * hash contiene claves[i].
+ * Devuelve la cantidad de claves encontradas.
+ */
+size_t hash_contiene_lote(hash_t* hash, const char* const* claves, size_t cantidad, bool* resultados){
+
+	if(!hash || !claves || !resultados)
+		return 0;
+
+	return buscar_lote(hash, claves, cantidad, NULL, resultados);
+}
+
+/*
+ * Quita del hash, en una sola pasada, cada clave para la que predicado
+ * devuelve true, invocando al destructor con su elemento. predicado
+ * recibe la clave, el elemento y el contexto.
+ * El predicado no debe modificar el hash.
+ * Devuelve la cantidad de claves quitadas.
+ */
+size_t hash_quitar_si(hash_t* hash, hash_predicado_t predicado, void* contexto){
+
+	if(!hash || !predicado)
+		return 0;
+
+	hash_cursor_t cursor;
+	hash_cursor_iniciar(&cursor, hash);
+
+	const char* clave;
+	void* elemento;
+	size_t quitadas = 0;
+
+	while(hash_cursor_siguiente(&cursor, &clave, NULL, &elemento)){
+		if(predicado(clave, elemento, contexto) && hash_cursor_quitar(&cursor) == EXITO)
+			quitadas++;
+	}
+
+	return quitadas;
 }
 
 /*
@@ -395,13 +689,10 @@ void hash_destruir(hash_t* hash){
 	if(!hash)
 		return;
 
-	if(hash_cantidad(hash) != 0)
-		borrar_todos_los_elementos(hash);
-
-	for(int i = 0; i < hash->capacidad; i++)
-		lista_destruir(hash->index[i]);
-
-	free(hash->index);
+	hash->operaciones->destruir(hash);
+	slab_destruir(hash->slab);
+	hash_liberar_arena(hash);
+	instrumentacion_destruir(hash->instrumentacion);
 	free(hash);
 }
 
@@ -412,17 +703,14 @@ void hash_destruir(hash_t* hash){
 ################################################################################################################
 */
 
-struct hash_iter{
-	hash_t* hash;
-	lista_iterador_t* lista_iterador;
-	size_t lista_actual;
-};
-
 /*
  * Crea un iterador de claves para el hash reservando la memoria
  * necesaria para el mismo. El iterador creado es válido desde su
  * creación hasta que se modifique la tabla de hash (insertando o
- * removiendo elementos);
+ * removiendo elementos), salvo que se quiten con
+ * hash_iterador_quitar_actual;
+ * Si la tabla tiene un rehash incremental en curso, crear el iterador
+ * lo termina.
  *
  * Devuelve el puntero al iterador creado o NULL en caso de error.
  */
@@ -435,13 +723,7 @@ hash_iterador_t* hash_iterador_crear(hash_t* hash){
 	if(!iter)
 		return NULL;
 
-	iter->hash = hash;
-	iter->lista_actual = 0;
-	iter->lista_iterador = lista_iterador_crear(hash->index[iter->lista_actual]);
-	if(!iter->lista_iterador){
-		free(iter);
-		return NULL;
-	}
+	hash_cursor_iniciar(&iter->cursor, hash);
 
 	return iter;
 }
@@ -452,29 +734,11 @@ hash_iterador_t* hash_iterador_crear(hash_t* hash){
  */
 void* hash_iterador_siguiente(hash_iterador_t* iterador){
 
-	if(!iterador || !iterador->hash)
-		return NULL;
-
-	if(!lista_iterador_tiene_siguiente(iterador->lista_iterador) && iterador->lista_actual == iterador->hash->capacidad - 1)
+	const char* clave;
+	if(!iterador || !hash_cursor_siguiente(&iterador->cursor, &clave, NULL, NULL))
 		return NULL;
 
-	if(lista_iterador_tiene_siguiente(iterador->lista_iterador)){
-		elemento_t* elem = lista_iterador_siguiente(iterador->lista_iterador);
-		return elem->clave;
-	}
-
-	if(!lista_iterador_tiene_siguiente(iterador->lista_iterador) && iterador->lista_actual < iterador->hash->capacidad - 1){
-
-		lista_iterador_destruir(iterador->lista_iterador);
-		iterador->lista_actual++;
-		iterador->lista_iterador = lista_iterador_crear(iterador->hash->index[iterador->lista_actual]);
-		if(!iterador->lista_iterador)
-			return NULL;
-
-		return hash_iterador_siguiente(iterador);
-	}
-
-	return NULL;
+	return (void*)clave;
 }
 
 /*
@@ -483,30 +747,28 @@ void* hash_iterador_siguiente(hash_iterador_t* iterador){
  */
 bool hash_iterador_tiene_siguiente(hash_iterador_t* iterador){
 
-	if(!iterador || !iterador->hash)
+	if(!iterador)
 		return false;
 
-	if(!lista_iterador_tiene_siguiente(iterador->lista_iterador) && iterador->lista_actual == iterador->hash->capacidad - 1)
-		return false;
+	// Avanza una copia para no perder la clave actual
+	hash_cursor_t copia = iterador->cursor;
 
-	if(lista_iterador_tiene_siguiente(iterador->lista_iterador))
-		return true;
-	
-
-	if(!lista_iterador_tiene_siguiente(iterador->lista_iterador) && iterador->lista_actual < iterador->hash->capacidad - 1){
-		
-		bool tiene_siguiente = false;
-		size_t lista_actual = iterador->lista_actual + 1;
-		
-		while(!tiene_siguiente && lista_actual <= iterador->hash->capacidad - 1){		
-			tiene_siguiente = !lista_vacia(iterador->hash->index[lista_actual]);
-			lista_actual++;
-		}
+	return hash_cursor_siguiente(&copia, NULL, NULL, NULL);
+}
 
-		return tiene_siguiente;
-	}
+/*
+ * Quita del hash la ultima clave devuelta por hash_iterador_siguiente,
+ * invocando al destructor con su elemento, sin volver a buscarla. La
+ * clave devuelta deja de ser valida y el iterador continua por la
+ * siguiente.
+ * Devuelve 0 si pudo quitarla o -1 si no habia clave para quitar.
+ */
+int hash_iterador_quitar_actual(hash_iterador_t* iterador){
 
-	return false;
+	if(!iterador)
+		return ERROR;
+
+	return hash_cursor_quitar(&iterador->cursor);
 }
 
 /*
@@ -517,10 +779,77 @@ void hash_iterador_destruir(hash_iterador_t* iterador){
 	if(!iterador)
 		return;
 
-	if(iterador->lista_iterador)
-		lista_iterador_destruir(iterador->lista_iterador);
-
 	free(iterador);
 }
 
+/*
+ * Inicia un cursor para recorrer el hash. El cursor no reserva memoria:
+ * se declara donde se lo use (por ejemplo en la pila) y no hace falta
+ * destruirlo. Es valido mientras no se modifique la tabla, salvo con
+ * hash_cursor_quitar. Recorrer toda la tabla cuesta
+ * O(capacidad + cantidad de elementos).
+ * Si la tabla tiene un rehash incremental en curso, iniciar el cursor
+ * lo termina.
+ *
+ * Devuelve false si el cursor o el hash son NULL.
+ */
+bool hash_cursor_iniciar(hash_cursor_t* cursor, hash_t* hash){
+
+	if(!cursor)
+		return false;
+
+	cursor->hash = hash;
+	cursor->posicion = 0;
+	cursor->anterior = NULL;
+	cursor->actual = NULL;
+	cursor->valor_hash = 0;
+
+	if(!hash)
+		return false;
+
+	hash->operaciones->cursor_iniciar(cursor);
 
+	return true;
+}
+
+/*
+ * Avanza el cursor al proximo elemento del hash y devuelve su clave, el
+ * largo de la clave y el elemento en clave, largo y elemento (cualquiera
+ * de ellos puede ser NULL si no interesa).
+ * Devuelve false si no habia mas elementos.
+ */
+bool hash_cursor_siguiente(hash_cursor_t* cursor, const char** clave, size_t* largo, void** elemento){
+
+	if(!cursor || !cursor->hash)
+		return false;
+
+	const char* clave_actual;
+	size_t largo_actual;
+	void* elemento_actual;
+
+	if(!cursor->hash->operaciones->cursor_siguiente(cursor, &clave_actual, &largo_actual, &elemento_actual))
+		return false;
+
+	if(clave)
+		*clave = clave_actual;
+	if(largo)
+		*largo = largo_actual;
+	if(elemento)
+		*elemento = elemento_actual;
+
+	return true;
+}
+
+/*
+ * Quita del hash el ultimo elemento devuelto por hash_cursor_siguiente
+ * en O(1), invocando al destructor con el elemento. La clave devuelta
+ * deja de ser valida y el cursor continua por el elemento siguiente.
+ * Devuelve 0 si pudo quitarlo o -1 si no habia elemento para quitar.
+ */
+int hash_cursor_quitar(hash_cursor_t* cursor){
+
+	if(!cursor || !cursor->hash || !cursor->actual)
+		return ERROR;
+
+	return cursor->hash->operaciones->cursor_quitar(cursor);
+}
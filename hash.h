@@ -3,10 +3,174 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 
 typedef struct hash hash_t;
 typedef void (*hash_destruir_dato_t)(void*);
+typedef bool (*hash_predicado_t)(const char* clave, void* elemento, void* contexto);
+typedef size_t (*hash_tamanio_dato_t)(const void* elemento);
 
+/*
+ * Funcion de hash: recibe la clave como bytes, su largo y la semilla
+ * de la tabla, y devuelve un hash de 64 bits.
+ */
+typedef uint64_t (*hash_funcion_t)(const void* clave, size_t largo, uint64_t semilla);
+
+/*
+ * Hash rapido (estilo wyhash). Es la funcion por defecto y es adecuada
+ * para claves de origen confiable.
+ */
+uint64_t hash_funcion_rapida(const void* clave, size_t largo, uint64_t semilla);
+
+/*
+ * SipHash-2-4. Mas lenta que hash_funcion_rapida pero resistente a
+ * claves elegidas por un atacante para provocar colisiones, siempre que
+ * la semilla sea secreta.
+ */
+uint64_t hash_funcion_siphash(const void* clave, size_t largo, uint64_t semilla);
+
+/*
+ * Motores de almacenamiento disponibles.
+ * HASH_MOTOR_LISTAS guarda los elementos en un arreglo de listas
+ * enlazadas (es el motor por defecto).
+ * HASH_MOTOR_ABIERTO usa direccionamiento abierto sobre una tabla
+ * plana con un byte de control por ranura, comparando 16 ranuras por
+ * vez. Una busqueda fallida casi nunca sale del arreglo de control.
+ * HASH_MOTOR_ENCADENADO guarda en el arreglo de baldes el primer
+ * elemento de cada cadena. Cada elemento se reserva de una sola vez
+ * junto con su clave y el enlace al siguiente.
+ */
+typedef enum hash_motor{
+	HASH_MOTOR_LISTAS = 0,
+	HASH_MOTOR_ABIERTO,
+	HASH_MOTOR_ENCADENADO
+}hash_motor_t;
+
+/*
+ * Origen de la memoria de los elementos, nodos y claves del hash.
+ * HASH_ASIGNACION_MALLOC pide cada uno por separado a malloc (por
+ * defecto).
+ * HASH_ASIGNACION_SLAB los toma de paginas propias de la tabla y
+ * reutiliza los que se liberan. Si la tabla no tiene destructor,
+ * hash_destruir libera todo de una vez sin recorrer los elementos.
+ */
+typedef enum hash_asignacion{
+	HASH_ASIGNACION_MALLOC = 0,
+	HASH_ASIGNACION_SLAB
+}hash_asignacion_t;
+
+/*
+ * Formato de los archivos que carga hash_cargar_archivo: un registro
+ * por linea terminada en fin_de_registro, con la clave y el elemento
+ * separados por separador. Una estructura inicializada en cero equivale
+ * al formato por defecto: separador '\t' y fin_de_registro '\n'.
+ */
+typedef struct hash_formato{
+	char separador;
+	char fin_de_registro;
+}hash_formato_t;
+
+/*
+ * Opciones de creacion del hash. Una estructura inicializada en cero
+ * equivale a las opciones por defecto que usa hash_crear.
+ *
+ * funcion es la funcion de hash a utilizar; si es NULL se usa
+ * hash_funcion_rapida. Puede ser una de las funciones incluidas o una
+ * propia del usuario.
+ * Si semilla_fija es true se usa semilla como semilla de la tabla; en
+ * caso contrario cada tabla recibe una semilla aleatoria.
+ * Si rehash_incremental es true, al agrandarse la tabla los elementos
+ * se mudan de a pocos baldes en cada insercion, busqueda o borrado en
+ * vez de todos juntos, acotando la demora de cada operacion. Solo lo
+ * aprovecha HASH_MOTOR_ENCADENADO; los demas motores lo ignoran.
+ * Si hilos_rehash es mayor a 1, cuando HASH_MOTOR_ENCADENADO muda de
+ * una vez una tabla grande reparte la mudanza entre esa cantidad de
+ * hilos. Los demas motores lo ignoran.
+ * Si muestreo_latencia es mayor a 0, la tabla mide la latencia de una
+ * de cada muestreo_latencia busquedas, inserciones y borrados (ver
+ * hash_exportar_latencias). Con 0 no se mide nada y las operaciones no
+ * pagan ningun costo extra. El muestreo y los histogramas son atomicos,
+ * asi que tambien miden bien las busquedas simultaneas de varios hilos,
+ * como las de hash_concurrente.
+ * Si ademas contadores_hardware es true, en Linux las operaciones
+ * medidas tambien cuentan ciclos, fallos de cache y fallos de
+ * prediccion de saltos con perf_event_open. Los contadores son del hilo
+ * que crea la tabla: las operaciones medidas en otros hilos solo miden
+ * su latencia. Si el sistema no permite abrir los contadores, la tabla
+ * se crea igual sin ellos.
+ */
+typedef struct hash_opciones{
+	hash_motor_t motor;
+	hash_asignacion_t asignacion;
+	hash_funcion_t funcion;
+	uint64_t semilla;
+	bool semilla_fija;
+	bool rehash_incremental;
+	size_t hilos_rehash;
+	size_t muestreo_latencia;
+	bool contadores_hardware;
+}hash_opciones_t;
+
+/*
+ * Operaciones cuya latencia se mide con muestreo_latencia.
+ * HASH_OPERACION_OBTENER incluye a hash_obtener y hash_contiene,
+ * HASH_OPERACION_INSERTAR a hash_insertar, hash_insertar_o_reemplazar y
+ * hash_obtener_o_insertar, y HASH_OPERACION_QUITAR a hash_quitar, cada
+ * una con sus versiones _n y _con_hash. Los lotes miden cada clave como
+ * la operacion individual que le corresponde.
+ */
+typedef enum hash_operacion{
+	HASH_OPERACION_OBTENER = 0,
+	HASH_OPERACION_INSERTAR,
+	HASH_OPERACION_QUITAR,
+	HASH_CANTIDAD_OPERACIONES
+}hash_operacion_t;
+
+/* Formatos de hash_exportar_latencias. */
+typedef enum hash_formato_exportacion{
+	HASH_EXPORTAR_TEXTO = 0,
+	HASH_EXPORTAR_JSON
+}hash_formato_exportacion_t;
+
+/*
+ * Estadisticas de la tabla que completa hash_estadisticas.
+ *
+ * factor_carga es cantidad / capacidad sin redondear.
+ * Un balde es la lista de LISTAS, la cadena de ENCADENADO o del
+ * snapshot, y el grupo de 16 ranuras que se compara de una vez en
+ * ABIERTO. histograma_cadenas[i] es la cantidad de baldes
+ * con i elementos; el ultimo cuenta tambien los mas largos.
+ * sondeo_medio y sondeo_maximo miden lo que recorre una busqueda
+ * exitosa: los elementos comparados en las cadenas, o los grupos
+ * revisados en ABIERTO.
+ * rehashes y nanosegundos_rehash cuentan las veces que la tabla se
+ * agrando y el tiempo total que llevo mudar sus elementos desde que se
+ * creo. Con rehash_incremental, el tiempo de los pasos que se hacen
+ * dentro de cada operacion solo se cuenta si la tabla se creo con
+ * muestreo_latencia; sin eso se cuenta solo lo que se muda de una vez.
+ * bytes_baldes, bytes_entradas y bytes_claves son la memoria del arreglo
+ * de baldes (con las listas y sus nodos en LISTAS, y las ranuras en
+ * ABIERTO), de las entradas sin sus claves, y de las claves con su '\0'.
+ */
+#define HASH_LARGOS_CADENA 17
+
+typedef struct hash_estadisticas{
+	size_t cantidad;
+	size_t capacidad;
+	double factor_carga;
+	size_t baldes_vacios;
+	size_t histograma_cadenas[HASH_LARGOS_CADENA];
+	size_t cadena_maxima;
+	size_t ranuras_borradas;
+	double sondeo_medio;
+	size_t sondeo_maximo;
+	size_t rehashes;
+	uint64_t nanosegundos_rehash;
+	size_t bytes_baldes;
+	size_t bytes_entradas;
+	size_t bytes_claves;
+}hash_estadisticas_t;
 
 
 /*
@@ -18,12 +182,42 @@ typedef void (*hash_destruir_dato_t)(void*);
  */
 hash_t* hash_crear(hash_destruir_dato_t destruir_elemento, size_t capacidad);
 
+/*
+ * Crea el hash igual que hash_crear pero permitiendo elegir como se
+ * almacenan los elementos. Si opciones es NULL se usan las opciones
+ * por defecto.
+ * Devuelve un puntero al hash creado o NULL en caso de no poder crearlo.
+ */
+hash_t* hash_crear_con_opciones(hash_destruir_dato_t destruir_elemento, size_t capacidad, const hash_opciones_t* opciones);
+
 /*
  * Inserta un elemento reservando la memoria necesaria para el mismo.
  * Devuelve 0 si pudo guardarlo o -1 si no pudo.
  */
 int hash_insertar(hash_t* hash, const char* clave, void* elemento);
 
+/*
+ * Inserta el elemento o, si la clave ya existia, reemplaza su elemento,
+ * buscando la clave una sola vez.
+ * Si anterior no es NULL, guarda en el el elemento reemplazado (o NULL
+ * si la clave no existia) y no se invoca al destructor; si anterior es
+ * NULL el elemento reemplazado se destruye igual que en hash_insertar.
+ * Devuelve 0 si pudo guardarlo o -1 si no pudo.
+ */
+int hash_insertar_o_reemplazar(hash_t* hash, const char* clave, void* elemento, void** anterior);
+
+/*
+ * Busca la clave y, si no existe, la inserta con elemento NULL, todo
+ * con una sola busqueda. Devuelve un puntero al lugar donde el hash
+ * guarda el elemento de esa clave, para leerlo o modificarlo en el
+ * lugar, o NULL si no pudo insertar la clave.
+ * Si insertado no es NULL, guarda en el true si la clave fue insertada
+ * o false si ya existia.
+ * El puntero devuelto deja de ser valido con la proxima insercion o
+ * borrado en el hash.
+ */
+void** hash_obtener_o_insertar(hash_t* hash, const char* clave, bool* insertado);
+
 /*
  * Quita un elemento del hash e invoca la funcion destructora
  * pasandole dicho elemento.
@@ -43,11 +237,194 @@ void* hash_obtener(hash_t* hash, const char* clave);
  */
 bool hash_contiene(hash_t* hash, const char* clave);
 
+/*
+ * Versiones de hash_insertar, hash_obtener_o_insertar, hash_quitar,
+ * hash_obtener y hash_contiene cuya clave son los largo bytes a partir
+ * de clave, sin '\0' final. La clave puede contener bytes en cero y se
+ * compara byte a byte con memcmp, asi que puede apuntar directamente a
+ * un buffer de entrada sin copiarla antes; el hash solo copia la clave
+ * cuando la inserta.
+ * Las claves insertadas asi se guardan con un '\0' agregado al final,
+ * de modo que el iterador las devuelve igual que a las demas. Una clave
+ * insertada con hash_insertar es la misma que sus bytes sin el '\0'
+ * insertada con hash_insertar_n.
+ */
+int hash_insertar_n(hash_t* hash, const void* clave, size_t largo, void* elemento);
+void** hash_obtener_o_insertar_n(hash_t* hash, const void* clave, size_t largo, bool* insertado);
+int hash_quitar_n(hash_t* hash, const void* clave, size_t largo);
+void* hash_obtener_n(hash_t* hash, const void* clave, size_t largo);
+bool hash_contiene_n(hash_t* hash, const void* clave, size_t largo);
+
 /*
  * Devuelve la cantidad de elementos almacenados en el hash.
  */
 size_t hash_cantidad(hash_t* hash);
 
+/*
+ * Completa estadisticas con el estado actual del hash. Recorre todos los
+ * baldes, asi que cuesta O(capacidad + cantidad de elementos); los
+ * contadores de rehash se mantienen en cada redimension y no tienen
+ * costo en las demas operaciones.
+ * Devuelve 0 si pudo o -1 si el hash o estadisticas son NULL.
+ */
+int hash_estadisticas(hash_t* hash, hash_estadisticas_t* estadisticas);
+
+/*
+ * Devuelve la latencia en nanosegundos por debajo de la cual quedan el
+ * percentil por ciento (entre 0 y 100) de las operaciones medidas de
+ * ese tipo, con un error relativo menor al 4%.
+ * Devuelve 0 si la tabla no mide latencias o todavia no midio ninguna
+ * operacion de ese tipo.
+ */
+uint64_t hash_latencia_percentil(hash_t* hash, hash_operacion_t operacion, double percentil);
+
+/*
+ * Escribe en archivo las latencias medidas, como texto con una linea por
+ * operacion o como un objeto JSON que ademas incluye el histograma
+ * completo de cada operacion. Ambos formatos incluyen la cantidad de
+ * muestras, la media, los percentiles 50, 90, 99 y 99.9 y el maximo, el
+ * promedio de los contadores de hardware si se usan, y la cantidad,
+ * capacidad y rehashes de la tabla.
+ * Devuelve 0 si pudo o -1 si la tabla no mide latencias o no pudo
+ * escribir.
+ */
+int hash_exportar_latencias(hash_t* hash, FILE* archivo, hash_formato_exportacion_t formato);
+
+/*
+ * Devuelve el hash de los largo bytes de clave calculado con la funcion
+ * y la semilla del hash, para usarlo con las funciones _con_hash.
+ * El valor sirve para cualquier tabla creada con la misma funcion y la
+ * misma semilla (ver semilla_fija en hash_opciones_t), de modo que una
+ * clave se calcula una sola vez aunque se busque en varias tablas.
+ */
+uint64_t hash_calcular(const hash_t* hash, const void* clave, size_t largo);
+
+/*
+ * Versiones de hash_insertar, hash_quitar, hash_obtener y hash_contiene
+ * que reciben el hash de la clave ya calculado con hash_calcular sobre
+ * la clave sin su '\0'. Si valor_hash no es el hash de la clave en esta
+ * tabla, el resultado no esta definido.
+ */
+int hash_insertar_con_hash(hash_t* hash, const char* clave, uint64_t valor_hash, void* elemento);
+int hash_quitar_con_hash(hash_t* hash, const char* clave, uint64_t valor_hash);
+void* hash_obtener_con_hash(hash_t* hash, const char* clave, uint64_t valor_hash);
+bool hash_contiene_con_hash(hash_t* hash, const char* clave, uint64_t valor_hash);
+
+/*
+ * Prepara el hash para guardar cantidad elementos en total sin tener
+ * que agrandarse, haciendo de una sola vez la redimension que harian
+ * las inserciones a medida que la tabla se llena. Nunca achica la
+ * tabla.
+ * Devuelve 0 si pudo o -1 si no pudo.
+ */
+int hash_reservar(hash_t* hash, size_t cantidad);
+
+/*
+ * Inserta cantidad claves con sus elementos (claves[i] con
+ * elementos[i]) igual que hash_insertar. Antes de empezar reserva lugar
+ * para todas con hash_reservar, asi la tabla no se redimensiona en el
+ * medio de la carga. Despues las procesa por bloques:
+ * calcula los hashes del bloque, pide a cache todos sus baldes y
+ * despues todos sus primeros elementos, y recien entonces las inserta,
+ * de modo que las esperas a memoria de las distintas claves se
+ * superponen en vez de sumarse.
+ * Devuelve 0 si pudo guardarlas todas o -1 si alguna clave es NULL o
+ * no pudo guardarse; las claves anteriores a esa quedan insertadas.
+ */
+int hash_insertar_lote(hash_t* hash, const char* const* claves, void* const* elementos, size_t cantidad);
+
+/*
+ * Busca cantidad claves igual que hash_obtener, procesandolas por
+ * bloques como hash_insertar_lote. Guarda en resultados[i] el elemento
+ * de claves[i], o NULL si no existe o si claves[i] es NULL.
+ * Devuelve la cantidad de claves encontradas.
+ */
+size_t hash_obtener_lote(hash_t* hash, const char* const* claves, size_t cantidad, void** resultados);
+
+/*
+ * Igual que hash_obtener_lote pero guardando en resultados[i] si el
+ * hash contiene claves[i].
+ * Devuelve la cantidad de claves encontradas.
+ */
+size_t hash_contiene_lote(hash_t* hash, const char* const* claves, size_t cantidad, bool* resultados);
+
+/*
+ * Quita del hash, en una sola pasada, cada clave para la que predicado
+ * devuelve true, invocando al destructor con su elemento. predicado
+ * recibe la clave, el elemento y el contexto.
+ * El predicado no debe modificar el hash.
+ * Devuelve la cantidad de claves quitadas.
+ */
+size_t hash_quitar_si(hash_t* hash, hash_predicado_t predicado, void* contexto);
+
+/*
+ * Crea un hash con cantidad claves y sus elementos (claves[i] con
+ * elementos[i]) usando cantidad_hilos hilos, incluido el que llama (a
+ * lo sumo uno por procesador en linea y uno por clave).
+ * El resultado es un hash comun, igual al que se obtiene creandolo con
+ * hash_crear_con_opciones e insertando las claves en orden con
+ * hash_insertar: si una clave se repite queda su ultimo elemento y los
+ * anteriores se destruyen.
+ * Los hilos calculan en paralelo los hashes y las entradas de su parte
+ * de la entrada, las reparten segun los bits altos de su balde y
+ * despues cada hilo enlaza por su cuenta un rango de baldes distinto,
+ * sin ninguna sincronizacion. Esto solo lo hace HASH_MOTOR_ENCADENADO
+ * con HASH_ASIGNACION_MALLOC; con otras opciones las claves se insertan
+ * con hash_insertar_lote.
+ * Devuelve el hash creado o NULL si alguna clave es NULL o no pudo
+ * crearlo.
+ */
+hash_t* hash_construir_paralelo(hash_destruir_dato_t destruir_elemento, const char* const* claves, void* const* elementos, size_t cantidad, size_t cantidad_hilos, const hash_opciones_t* opciones);
+
+/*
+ * Carga en el hash los registros del archivo ruta, con el formato dado
+ * (o el formato por defecto si formato es NULL). Cada registro inserta
+ * su clave con un string con el resto de la linea como elemento; si una
+ * clave se repite queda el ultimo. Las lineas vacias se ignoran.
+ * El archivo se proyecta en memoria con mmap y se recorre una sola vez.
+ * Antes de insertar se reserva lugar segun el tamanio del archivo y el
+ * largo de sus primeros registros. Cada elemento se copia una sola vez a
+ * una arena del hash que se libera con hash_destruir, por lo que el hash
+ * no debe tener destructor; los elementos cargados no deben liberarse.
+ * Devuelve 0 si pudo cargar todos los registros o -1 si no pudo abrir
+ * el archivo, el hash tiene destructor, un registro no tiene separador o
+ * no hubo memoria. Los registros anteriores al error quedan cargados.
+ */
+int hash_cargar_archivo(hash_t* hash, const char* ruta, const hash_formato_t* formato);
+
+/*
+ * Guarda en el archivo ruta una copia del hash que hash_abrir_snapshot
+ * puede usar sin reconstruirla: en lugar de punteros guarda
+ * desplazamientos dentro del archivo, y cada clave se guarda junto con
+ * los bytes de su elemento.
+ * tamanio_elemento devuelve cuantos bytes del elemento guardar; si es
+ * NULL los elementos se guardan como strings (incluyendo el '\0'). Un
+ * elemento NULL o de 0 bytes se lee como NULL.
+ * El archivo se escribe aparte y reemplaza a ruta recien cuando esta
+ * completo. Solo puede leerse en maquinas con el mismo orden de bytes.
+ * Los registros se arman en memoria de a partes de 1 MiB o de un octavo
+ * del archivo (la mayor), recorriendo el hash una vez por parte; nunca
+ * se arma el archivo entero en memoria.
+ * Devuelve 0 si pudo guardarlo o -1 si no pudo.
+ */
+int hash_guardar_snapshot(hash_t* hash, const char* ruta, hash_tamanio_dato_t tamanio_elemento);
+
+/*
+ * Abre un snapshot guardado con hash_guardar_snapshot proyectandolo en
+ * memoria con mmap: no lee el archivo ni inserta ninguna clave, y las
+ * paginas se cargan recien cuando una busqueda las necesita.
+ * El hash devuelto es de solo lectura: hash_obtener, hash_contiene, los
+ * lotes de consulta, el iterador y el cursor funcionan igual que con
+ * cualquier hash, pero insertar, quitar o reservar devuelven error. Los
+ * elementos que devuelve apuntan dentro del archivo proyectado, no deben
+ * modificarse y son validos hasta destruir el hash con hash_destruir.
+ * funcion solo se usa si el snapshot se guardo con una funcion de hash
+ * propia, y debe ser esa misma funcion.
+ * Devuelve el hash o NULL si no pudo abrir el archivo o no es un
+ * snapshot valido.
+ */
+hash_t* hash_abrir_snapshot(const char* ruta, hash_funcion_t funcion);
+
 /*
  * Destruye el hash liberando la memoria reservada y asegurandose de
  * invocar la funcion destructora con cada elemento almacenado en el
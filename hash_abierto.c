@@ -0,0 +1,454 @@
+#include <stdlib.h>
+#include <string.h>
+#include "hash_interno.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Motor de direccionamiento abierto. Cada ranura tiene un byte de
+ * control: los 7 bits bajos del hash si esta ocupada, o CONTROL_VACIO /
+ * CONTROL_BORRADO (ambos con el bit alto encendido) si no lo esta.
+ * Las ranuras se agrupan de a TAMANIO_GRUPO y cada grupo se compara de
+ * una sola vez contra la etiqueta buscada, de modo que casi nunca se
+ * lee la clave de una ranura que no coincide.
+ */
+
+#define TAMANIO_GRUPO 16
+#define CONTROL_VACIO ((uint8_t)0x80)
+#define CONTROL_BORRADO ((uint8_t)0xFE)
+#define NO_ENCONTRADO ((size_t)-1)
+
+// pre: mascara es distinto de 0
+// pos: devuelve la posicion del bit encendido menos significativo
+size_t primer_bit(uint32_t mascara){
+
+#if defined(__GNUC__)
+	return (size_t)__builtin_ctz(mascara);
+#else
+	size_t posicion = 0;
+	while(!(mascara & 1)){
+		mascara >>= 1;
+		posicion++;
+	}
+	return posicion;
+#endif
+}
+
+// pre: grupo apunta a TAMANIO_GRUPO bytes de control
+// pos: devuelve una mascara con un bit encendido por cada byte del grupo igual a valor
+uint32_t grupo_coincidencias(const uint8_t* grupo, uint8_t valor){
+
+#ifdef __SSE2__
+	__m128i control = _mm_loadu_si128((const __m128i*)grupo);
+	return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8((char)valor)));
+#else
+	uint32_t mascara = 0;
+	for(uint32_t i = 0; i < TAMANIO_GRUPO; i++){
+		if(grupo[i] == valor)
+			mascara |= 1u << i;
+	}
+	return mascara;
+#endif
+}
+
+// pre: grupo apunta a TAMANIO_GRUPO bytes de control
+// pos: devuelve una mascara con un bit encendido por cada ranura libre (vacia o borrada) del grupo
+uint32_t grupo_libres(const uint8_t* grupo){
+
+#ifdef __SSE2__
+	return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)grupo));
+#else
+	uint32_t mascara = 0;
+	for(uint32_t i = 0; i < TAMANIO_GRUPO; i++){
+		if(grupo[i] & 0x80)
+			mascara |= 1u << i;
+	}
+	return mascara;
+#endif
+}
+
+// pre:
+// pos: devuelve la cantidad de ranuras (multiplo de TAMANIO_GRUPO y potencia de 2) necesaria para guardar cantidad elementos
+size_t abierto_capacidad_para(size_t cantidad){
+
+	size_t necesarias = cantidad + cantidad / 7 + 1;
+	size_t capacidad = TAMANIO_GRUPO;
+
+	while(capacidad < necesarias)
+		capacidad *= 2;
+
+	return capacidad;
+}
+
+// pre:
+// pos: devuelve la cantidad maxima de ranuras ocupadas o borradas que admite la tabla antes de agrandarse
+size_t abierto_limite_carga(size_t capacidad){
+
+	return capacidad - capacidad / 8;
+}
+
+// pre: hash es distinto de NULL
+// pos: reserva las ranuras y los bytes de control. Devuelve TRUE si pudo, FALSE en caso contrario
+bool abierto_reservar_tabla(hash_t* hash, size_t capacidad){
+
+	uint8_t* control = malloc(capacidad);
+	if(!control)
+		return false;
+
+	ranura_t* ranuras = malloc(capacidad * sizeof(ranura_t));
+	if(!ranuras){
+		free(control);
+		return false;
+	}
+
+	memset(control, CONTROL_VACIO, capacidad);
+
+	hash->control = control;
+	hash->ranuras = ranuras;
+	hash->capacidad = capacidad;
+	hash->borrados = 0;
+
+	return true;
+}
+
+// pre: hash es distinto de NULL
+// pos: crea la tabla vacia con lugar para al menos capacidad elementos
+bool abierto_crear(hash_t* hash, size_t capacidad){
+
+	return abierto_reservar_tabla(hash, abierto_capacidad_para(capacidad));
+}
+
+// pre: hash y clave son distintos de NULL
+// pos: devuelve la ranura que contiene la clave o NO_ENCONTRADO
+size_t abierto_ubicar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash){
+
+	size_t mascara_grupos = hash->capacidad / TAMANIO_GRUPO - 1;
+	size_t grupo = (size_t)(valor_hash >> 7) & mascara_grupos;
+	uint8_t etiqueta = (uint8_t)(valor_hash & 0x7F);
+	size_t salto = 0;
+
+	while(true){
+
+		const uint8_t* control = hash->control + grupo * TAMANIO_GRUPO;
+		uint32_t coincidencias = grupo_coincidencias(control, etiqueta);
+
+		while(coincidencias){
+			size_t ranura = grupo * TAMANIO_GRUPO + primer_bit(coincidencias);
+			ranura_t* candidata = &hash->ranuras[ranura];
+			if(candidata->hash == valor_hash && candidata->largo == largo && memcmp(candidata->clave, clave, largo) == 0)
+				return ranura;
+			coincidencias &= coincidencias - 1;
+		}
+
+		if(grupo_coincidencias(control, CONTROL_VACIO))
+			return NO_ENCONTRADO;
+
+		salto++;
+		grupo = (grupo + salto) & mascara_grupos;
+	}
+}
+
+// pre: hash es distinto de NULL y la tabla tiene al menos una ranura libre
+// pos: devuelve la primera ranura libre de la secuencia de sondeo de valor_hash
+size_t abierto_ranura_libre(hash_t* hash, uint64_t valor_hash){
+
+	size_t mascara_grupos = hash->capacidad / TAMANIO_GRUPO - 1;
+	size_t grupo = (size_t)(valor_hash >> 7) & mascara_grupos;
+	size_t salto = 0;
+	uint32_t libres;
+
+	while(!(libres = grupo_libres(hash->control + grupo * TAMANIO_GRUPO))){
+		salto++;
+		grupo = (grupo + salto) & mascara_grupos;
+	}
+
+	return grupo * TAMANIO_GRUPO + primer_bit(libres);
+}
+
+// pre: hash es distinto de NULL
+// pos: reubica todas las ranuras ocupadas en una tabla de nueva_capacidad ranuras, descartando las borradas. Devuelve 0 si pudo o -1 si no
+int abierto_redimensionar(hash_t* hash, size_t nueva_capacidad){
+
+	uint64_t inicio = hash_reloj_ns();
+	uint8_t* control_viejo = hash->control;
+	ranura_t* ranuras_viejas = hash->ranuras;
+	size_t capacidad_vieja = hash->capacidad;
+
+	if(!abierto_reservar_tabla(hash, nueva_capacidad))
+		return ERROR;
+
+	for(size_t i = 0; i < capacidad_vieja; i++){
+
+		if(control_viejo[i] & 0x80)
+			continue;
+
+		size_t ranura = abierto_ranura_libre(hash, ranuras_viejas[i].hash);
+		hash->control[ranura] = (uint8_t)(ranuras_viejas[i].hash & 0x7F);
+		hash->ranuras[ranura] = ranuras_viejas[i];
+	}
+
+	free(control_viejo);
+	free(ranuras_viejas);
+
+	hash->rehashes++;
+	hash_sumar_tiempo_rehash(hash, inicio);
+
+	return EXITO;
+}
+
+// pre: hash, clave e insertado son distintos de NULL y valor_hash es el hash de la clave
+// pos: devuelve el lugar del elemento con dicha clave, insertandola con elemento NULL si no existia. Devuelve NULL si no pudo insertarla
+void** abierto_buscar_o_insertar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash, bool* insertado){
+
+	size_t ranura = abierto_ubicar(hash, clave, largo, valor_hash);
+
+	if(ranura != NO_ENCONTRADO){
+		*insertado = false;
+		return &hash->ranuras[ranura].elemento;
+	}
+
+	if(hash->cantidad_elementos + hash->borrados + 1 > abierto_limite_carga(hash->capacidad)){
+
+		size_t nueva_capacidad = hash->capacidad;
+		if(hash->cantidad_elementos + 1 > abierto_limite_carga(hash->capacidad) / 2)
+			nueva_capacidad *= 2;
+
+		if(abierto_redimensionar(hash, nueva_capacidad) == ERROR)
+			return NULL;
+	}
+
+	char* copia = hash_copiar_clave(hash, clave, largo);
+	if(!copia)
+		return NULL;
+
+	ranura = abierto_ranura_libre(hash, valor_hash);
+	if(hash->control[ranura] == CONTROL_BORRADO)
+		hash->borrados--;
+
+	hash->control[ranura] = (uint8_t)(valor_hash & 0x7F);
+	hash->ranuras[ranura].hash = valor_hash;
+	hash->ranuras[ranura].clave = copia;
+	hash->ranuras[ranura].largo = largo;
+	hash->ranuras[ranura].elemento = NULL;
+	hash->cantidad_elementos++;
+	*insertado = true;
+
+	return &hash->ranuras[ranura].elemento;
+}
+
+// pre: hash es distinto de NULL y la ranura esta ocupada
+// pos: libera la clave de la ranura, invoca al destructor con su elemento y la marca vacia o borrada
+void abierto_vaciar_ranura(hash_t* hash, size_t ranura){
+
+	if(hash->destructor)
+		hash->destructor(hash->ranuras[ranura].elemento);
+	hash_liberar_clave(hash, hash->ranuras[ranura].clave, hash->ranuras[ranura].largo);
+
+	// Si el grupo todavia tiene una ranura vacia ninguna busqueda pasa de largo por
+	// este grupo, asi que la ranura puede volver a quedar vacia en vez de borrada.
+	const uint8_t* grupo = hash->control + (ranura / TAMANIO_GRUPO) * TAMANIO_GRUPO;
+	if(grupo_coincidencias(grupo, CONTROL_VACIO))
+		hash->control[ranura] = CONTROL_VACIO;
+	else{
+		hash->control[ranura] = CONTROL_BORRADO;
+		hash->borrados++;
+	}
+
+	hash->cantidad_elementos--;
+}
+
+// pre: hash y clave son distintos de NULL y valor_hash es el hash de la clave
+// pos: quita el elemento e invoca al destructor. Devuelve 0 si pudo eliminarlo o -1 si no pudo.
+int abierto_quitar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash){
+
+	size_t ranura = abierto_ubicar(hash, clave, largo, valor_hash);
+	if(ranura == NO_ENCONTRADO)
+		return ERROR;
+
+	abierto_vaciar_ranura(hash, ranura);
+
+	return EXITO;
+}
+
+// pre: hash y clave son distintos de NULL y valor_hash es el hash de la clave
+// pos: devuelve true si la clave esta, dejando su elemento en elemento si no es NULL
+bool abierto_buscar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash, void** elemento){
+
+	size_t ranura = abierto_ubicar(hash, clave, largo, valor_hash);
+	if(ranura == NO_ENCONTRADO)
+		return false;
+
+	if(elemento)
+		*elemento = hash->ranuras[ranura].elemento;
+
+	return true;
+}
+
+// pre: hash es distinto de NULL
+// pos: agranda la tabla, si hace falta, para que guardar cantidad elementos no provoque ninguna redimension. Devuelve 0 si pudo o -1 si no
+int abierto_reservar(hash_t* hash, size_t cantidad){
+
+	if(cantidad < hash->cantidad_elementos)
+		cantidad = hash->cantidad_elementos;
+
+	if(cantidad + hash->borrados <= abierto_limite_carga(hash->capacidad))
+		return EXITO;
+
+	size_t nueva_capacidad = abierto_capacidad_para(cantidad);
+	if(nueva_capacidad < hash->capacidad)
+		nueva_capacidad = hash->capacidad;
+
+	return abierto_redimensionar(hash, nueva_capacidad);
+}
+
+// pre: hash es distinto de NULL
+// pos: pide a cache el grupo de control donde empieza la busqueda de valor_hash
+void abierto_anticipar_balde(const hash_t* hash, uint64_t valor_hash){
+
+	size_t grupo = (size_t)(valor_hash >> 7) & (hash->capacidad / TAMANIO_GRUPO - 1);
+
+	ANTICIPAR(hash->control + grupo * TAMANIO_GRUPO);
+}
+
+// pre: hash es distinto de NULL
+// pos: pide a cache la primera ranura del grupo inicial cuya etiqueta coincide con valor_hash, si hay alguna
+void abierto_anticipar_elemento(const hash_t* hash, uint64_t valor_hash){
+
+	size_t grupo = (size_t)(valor_hash >> 7) & (hash->capacidad / TAMANIO_GRUPO - 1);
+	uint32_t coincidencias = grupo_coincidencias(hash->control + grupo * TAMANIO_GRUPO, (uint8_t)(valor_hash & 0x7F));
+
+	if(coincidencias)
+		ANTICIPAR(&hash->ranuras[grupo * TAMANIO_GRUPO + primer_bit(coincidencias)]);
+}
+
+// pre: hash es distinto de NULL
+// pos: libera todas las claves y la tabla, invocando al destructor con cada elemento
+void abierto_destruir(hash_t* hash){
+
+	// Las claves se liberan junto con el slab
+	bool recorrer = hash->destructor || !hash->slab;
+
+	for(size_t i = 0; recorrer && i < hash->capacidad; i++){
+
+		if(hash->control[i] & 0x80)
+			continue;
+
+		if(hash->destructor)
+			hash->destructor(hash->ranuras[i].elemento);
+		hash_liberar_clave(hash, hash->ranuras[i].clave, hash->ranuras[i].largo);
+	}
+
+	free(hash->control);
+	free(hash->ranuras);
+}
+
+// pre: hash es distinto de NULL
+// pos: devuelve la primera ranura ocupada a partir de desde o la capacidad si no hay ninguna
+size_t abierto_proxima_ocupada(hash_t* hash, size_t desde){
+
+	while(desde < hash->capacidad && (hash->control[desde] & 0x80))
+		desde++;
+
+	return desde;
+}
+
+// pre: cursor es distinto de NULL
+// pos: no hace nada, el cursor ya empieza en la primera ranura
+void abierto_cursor_iniciar(hash_cursor_t* cursor){
+
+	(void)cursor;
+}
+
+// pre: cursor, clave, largo y elemento son distintos de NULL
+// pos: devuelve el elemento de la proxima ranura ocupada y avanza el cursor, o false si no habia mas
+bool abierto_cursor_siguiente(hash_cursor_t* cursor, const char** clave, size_t* largo, void** elemento){
+
+	size_t ranura = abierto_proxima_ocupada(cursor->hash, cursor->posicion);
+	if(ranura == cursor->hash->capacidad){
+		cursor->posicion = ranura;
+		cursor->actual = NULL;
+		return false;
+	}
+
+	cursor->posicion = ranura + 1;
+	cursor->actual = &cursor->hash->ranuras[ranura];
+
+	*clave = cursor->hash->ranuras[ranura].clave;
+	*largo = cursor->hash->ranuras[ranura].largo;
+	*elemento = cursor->hash->ranuras[ranura].elemento;
+	cursor->valor_hash = cursor->hash->ranuras[ranura].hash;
+
+	return true;
+}
+
+// pre: cursor es distinto de NULL y tiene un elemento actual
+// pos: vacia la ranura del elemento actual. Devuelve 0
+int abierto_cursor_quitar(hash_cursor_t* cursor){
+
+	abierto_vaciar_ranura(cursor->hash, cursor->posicion - 1);
+	cursor->actual = NULL;
+
+	return EXITO;
+}
+
+// pre: hash es distinto de NULL y la ranura esta ocupada
+// pos: devuelve cuantos grupos revisa una busqueda hasta llegar al grupo de la ranura
+size_t abierto_grupos_sondeados(const hash_t* hash, size_t ranura){
+
+	size_t mascara_grupos = hash->capacidad / TAMANIO_GRUPO - 1;
+	size_t grupo = (size_t)(hash->ranuras[ranura].hash >> 7) & mascara_grupos;
+	size_t salto = 0;
+
+	while(grupo != ranura / TAMANIO_GRUPO){
+		salto++;
+		grupo = (grupo + salto) & mascara_grupos;
+	}
+
+	return salto + 1;
+}
+
+// pre: hash y estadisticas son distintos de NULL
+// pos: agrega a las estadisticas la ocupacion de cada grupo, los grupos que revisa la busqueda de cada elemento y la memoria de la tabla y las claves
+void abierto_estadisticas(hash_t* hash, hash_estadisticas_t* estadisticas){
+
+	estadisticas->ranuras_borradas = hash->borrados;
+	estadisticas->bytes_baldes = hash->capacidad * (sizeof(uint8_t) + sizeof(ranura_t));
+
+	for(size_t grupo = 0; grupo < hash->capacidad; grupo += TAMANIO_GRUPO){
+
+		size_t ocupadas = 0;
+		for(size_t ranura = grupo; ranura < grupo + TAMANIO_GRUPO; ranura++){
+			if(hash->control[ranura] & 0x80)
+				continue;
+
+			ocupadas++;
+			size_t sondeo = abierto_grupos_sondeados(hash, ranura);
+			estadisticas->sondeo_medio += (double)sondeo;
+			if(sondeo > estadisticas->sondeo_maximo)
+				estadisticas->sondeo_maximo = sondeo;
+			estadisticas->bytes_claves += hash->ranuras[ranura].largo + 1;
+		}
+
+		estadisticas->histograma_cadenas[ocupadas < HASH_LARGOS_CADENA ? ocupadas : HASH_LARGOS_CADENA - 1]++;
+		if(ocupadas == 0)
+			estadisticas->baldes_vacios++;
+		if(ocupadas > estadisticas->cadena_maxima)
+			estadisticas->cadena_maxima = ocupadas;
+	}
+}
+
+const hash_operaciones_t OPERACIONES_ABIERTO = {
+	.crear = abierto_crear,
+	.buscar_o_insertar = abierto_buscar_o_insertar,
+	.quitar = abierto_quitar,
+	.buscar = abierto_buscar,
+	.reservar = abierto_reservar,
+	.destruir = abierto_destruir,
+	.anticipar_balde = abierto_anticipar_balde,
+	.anticipar_elemento = abierto_anticipar_elemento,
+	.cursor_iniciar = abierto_cursor_iniciar,
+	.cursor_siguiente = abierto_cursor_siguiente,
+	.cursor_quitar = abierto_cursor_quitar,
+	.estadisticas = abierto_estadisticas
+};
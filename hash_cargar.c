@@ -0,0 +1,175 @@
+#define _DEFAULT_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hash_interno.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define TAMANIO_BLOQUE_ARENA (1024 * 1024)
+#define BYTES_MUESTRA (64 * 1024)
+
+// pre: desde y fin son punteros al mismo arreglo, con desde <= fin
+// pos: devuelve el primer byte en [desde, fin) igual a primero o a segundo, o fin si no hay ninguno. Compara de a 16 bytes por vez
+const char* proximo_delimitador(const char* desde, const char* fin, char primero, char segundo){
+
+#ifdef __SSE2__
+	__m128i buscado_primero = _mm_set1_epi8(primero);
+	__m128i buscado_segundo = _mm_set1_epi8(segundo);
+	while(fin - desde >= 16){
+		__m128i bytes = _mm_loadu_si128((const __m128i*)desde);
+		uint32_t mascara = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, buscado_primero), _mm_cmpeq_epi8(bytes, buscado_segundo)));
+		if(mascara)
+			return desde + primer_bit(mascara);
+		desde += 16;
+	}
+#endif
+
+	while(desde < fin && *desde != primero && *desde != segundo)
+		desde++;
+
+	return desde;
+}
+
+// pre: hash es distinto de NULL
+// pos: devuelve una copia en la arena del hash de los largo bytes de origen seguidos de un '\0', o NULL si no hay memoria
+char* copiar_en_arena(hash_t* hash, const char* origen, size_t largo){
+
+	bloque_arena_t* bloque = hash->arena;
+	if(!bloque || bloque->tamanio - bloque->usado < largo + 1){
+		size_t tamanio = largo + 1 > TAMANIO_BLOQUE_ARENA ? largo + 1 : TAMANIO_BLOQUE_ARENA;
+		bloque = malloc(sizeof(bloque_arena_t) + tamanio);
+		if(!bloque)
+			return NULL;
+		bloque->siguiente = hash->arena;
+		bloque->usado = 0;
+		bloque->tamanio = tamanio;
+		hash->arena = bloque;
+	}
+
+	char* copia = bloque->datos + bloque->usado;
+	memcpy(copia, origen, largo);
+	copia[largo] = '\0';
+	bloque->usado += largo + 1;
+
+	return copia;
+}
+
+// pre: hash es distinto de NULL
+// pos: libera todos los bloques de la arena del hash
+void hash_liberar_arena(hash_t* hash){
+
+	while(hash->arena){
+		bloque_arena_t* siguiente = hash->arena->siguiente;
+		free(hash->arena);
+		hash->arena = siguiente;
+	}
+}
+
+// pre: datos tiene tamanio bytes
+// pos: estima cuantos registros tiene el archivo a partir de cuantos hay en sus primeros BYTES_MUESTRA bytes
+size_t estimar_registros(const char* datos, size_t tamanio, char fin_de_registro){
+
+	size_t muestra = tamanio < BYTES_MUESTRA ? tamanio : BYTES_MUESTRA;
+	size_t registros = 0;
+	const char* fin = datos + muestra;
+
+	for(const char* actual = datos; (actual = memchr(actual, fin_de_registro, (size_t)(fin - actual))); actual++)
+		registros++;
+
+	if(registros == 0)
+		return 1;
+
+	return (size_t)((double)registros * ((double)tamanio / (double)muestra));
+}
+
+// pre: hash, datos y formato son distintos de NULL
+// pos: inserta los registros de los tamanio bytes de datos. Devuelve 0 si pudo o -1 si un registro no tiene separador o no hubo memoria
+int cargar_registros(hash_t* hash, const char* datos, size_t tamanio, const hash_formato_t* formato){
+
+	const char* actual = datos;
+	const char* fin = datos + tamanio;
+
+	while(actual < fin){
+
+		const char* separador = proximo_delimitador(actual, fin, formato->separador, formato->fin_de_registro);
+		if(separador == fin || *separador != formato->separador){
+			// Una linea vacia se ignora; cualquier otra necesita el separador
+			if(separador != actual)
+				return ERROR;
+			actual = separador + 1;
+			continue;
+		}
+
+		const char* fin_linea = proximo_delimitador(separador + 1, fin, formato->fin_de_registro, formato->fin_de_registro);
+
+		char* elemento = copiar_en_arena(hash, separador + 1, (size_t)(fin_linea - separador - 1));
+		if(!elemento || hash_insertar_n(hash, actual, (size_t)(separador - actual), elemento) == ERROR)
+			return ERROR;
+
+		actual = fin_linea + 1;
+	}
+
+	return EXITO;
+}
+
+/*
+ * Carga en el hash los registros del archivo ruta, con el formato dado
+ * (o el formato por defecto si formato es NULL). Cada registro inserta
+ * su clave con un string con el resto de la linea como elemento; si una
+ * clave se repite queda el ultimo. Las lineas vacias se ignoran.
+ * El archivo se proyecta en memoria con mmap y se recorre una sola vez.
+ * Antes de insertar se reserva lugar segun el tamanio del archivo y el
+ * largo de sus primeros registros. Cada elemento se copia una sola vez a
+ * una arena del hash que se libera con hash_destruir, por lo que el hash
+ * no debe tener destructor; los elementos cargados no deben liberarse.
+ * Devuelve 0 si pudo cargar todos los registros o -1 si no pudo abrir
+ * el archivo, el hash tiene destructor, un registro no tiene separador o
+ * no hubo memoria. Los registros anteriores al error quedan cargados.
+ */
+int hash_cargar_archivo(hash_t* hash, const char* ruta, const hash_formato_t* formato){
+
+	if(!hash || !ruta || hash->destructor)
+		return ERROR;
+
+	hash_formato_t elegido = {'\t', '\n'};
+	if(formato && formato->separador)
+		elegido.separador = formato->separador;
+	if(formato && formato->fin_de_registro)
+		elegido.fin_de_registro = formato->fin_de_registro;
+
+	int descriptor = open(ruta, O_RDONLY);
+	if(descriptor < 0)
+		return ERROR;
+
+	struct stat estado;
+	if(fstat(descriptor, &estado) != 0){
+		close(descriptor);
+		return ERROR;
+	}
+
+	size_t tamanio = (size_t)estado.st_size;
+	if(tamanio == 0){
+		close(descriptor);
+		return EXITO;
+	}
+
+	void* mapa = mmap(NULL, tamanio, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+	if(mapa == MAP_FAILED)
+		return ERROR;
+
+	madvise(mapa, tamanio, MADV_SEQUENTIAL);
+
+	int resultado = hash_reservar(hash, hash->cantidad_elementos + estimar_registros(mapa, tamanio, elegido.fin_de_registro));
+	if(resultado == EXITO)
+		resultado = cargar_registros(hash, mapa, tamanio, &elegido);
+
+	munmap(mapa, tamanio);
+
+	return resultado;
+}
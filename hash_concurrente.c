@@ -0,0 +1,216 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "hash_concurrente.h"
+#include "hash_interno.h"
+
+#define FRAGMENTOS_POR_DEFECTO 16
+#define LINEA_CACHE 64
+
+/*
+ * Cada fragmento ocupa sus propias lineas de cache, para que tomar el
+ * candado de un fragmento no invalide la linea de sus vecinos.
+ */
+typedef struct fragmento{
+	_Alignas(LINEA_CACHE) pthread_rwlock_t candado;
+	hash_t* hash;
+}fragmento_t;
+
+struct hash_concurrente{
+	fragmento_t* fragmentos;
+	size_t cantidad_fragmentos;
+	unsigned bits_fragmento;
+};
+
+// pre: hash es distinto de NULL
+// pos: destruye los primeros cantidad fragmentos y libera el arreglo
+void destruir_fragmentos(hash_concurrente_t* hash, size_t cantidad){
+
+	for(size_t i = 0; i < cantidad; i++){
+		pthread_rwlock_destroy(&hash->fragmentos[i].candado);
+		hash_destruir(hash->fragmentos[i].hash);
+	}
+
+	free(hash->fragmentos);
+}
+
+/*
+ * Crea el hash concurrente con cantidad_fragmentos fragmentos
+ * (redondeado a la siguiente potencia de 2; si es 0 se usan 16).
+ * Destruir_elemento y capacidad son iguales que en hash_crear; la
+ * capacidad se reparte entre los fragmentos.
+ * Opciones se aplica a cada fragmento igual que en
+ * hash_crear_con_opciones (puede ser NULL). Todos los fragmentos usan
+ * la misma funcion y semilla, y rehash_incremental se ignora, porque
+ * las busquedas de distintos hilos no pueden modificar el fragmento.
+ * Devuelve un puntero al hash creado o NULL en caso de no poder crearlo.
+ */
+hash_concurrente_t* hash_concurrente_crear(hash_destruir_dato_t destruir_elemento, size_t capacidad, size_t cantidad_fragmentos, const hash_opciones_t* opciones){
+
+	if(cantidad_fragmentos == 0)
+		cantidad_fragmentos = FRAGMENTOS_POR_DEFECTO;
+
+	hash_concurrente_t* hash = malloc(sizeof(hash_concurrente_t));
+	if(!hash)
+		return NULL;
+
+	hash->cantidad_fragmentos = 1;
+	hash->bits_fragmento = 0;
+	while(hash->cantidad_fragmentos < cantidad_fragmentos){
+		hash->cantidad_fragmentos *= 2;
+		hash->bits_fragmento++;
+	}
+
+	hash->fragmentos = aligned_alloc(LINEA_CACHE, hash->cantidad_fragmentos * sizeof(fragmento_t));
+	if(!hash->fragmentos){
+		free(hash);
+		return NULL;
+	}
+
+	hash_opciones_t opciones_fragmento = {0};
+	if(opciones)
+		opciones_fragmento = *opciones;
+	if(!opciones_fragmento.semilla_fija){
+		opciones_fragmento.semilla = semilla_aleatoria();
+		opciones_fragmento.semilla_fija = true;
+	}
+	opciones_fragmento.rehash_incremental = false;
+
+	size_t capacidad_fragmento = capacidad / hash->cantidad_fragmentos + 1;
+
+	for(size_t i = 0; i < hash->cantidad_fragmentos; i++){
+
+		hash->fragmentos[i].hash = hash_crear_con_opciones(destruir_elemento, capacidad_fragmento, &opciones_fragmento);
+		if(!hash->fragmentos[i].hash || pthread_rwlock_init(&hash->fragmentos[i].candado, NULL) != 0){
+			hash_destruir(hash->fragmentos[i].hash);
+			destruir_fragmentos(hash, i);
+			free(hash);
+			return NULL;
+		}
+	}
+
+	return hash;
+}
+
+// pre: hash y clave son distintos de NULL
+// pos: calcula el hash de la clave y devuelve el fragmento que le corresponde segun sus bits altos
+fragmento_t* fragmento_de_clave(hash_concurrente_t* hash, const char* clave, uint64_t* valor_hash){
+
+	// Todos los fragmentos comparten funcion y semilla, asi que cualquiera sirve para calcularlo
+	*valor_hash = hash_calcular(hash->fragmentos[0].hash, clave, strlen(clave));
+
+	if(hash->bits_fragmento == 0)
+		return &hash->fragmentos[0];
+
+	return &hash->fragmentos[*valor_hash >> (64 - hash->bits_fragmento)];
+}
+
+/*
+ * Igual que hash_insertar. Solo bloquea el fragmento de la clave.
+ * Devuelve 0 si pudo guardarlo o -1 si no pudo.
+ */
+int hash_concurrente_insertar(hash_concurrente_t* hash, const char* clave, void* elemento){
+
+	if(!hash || !clave)
+		return ERROR;
+
+	uint64_t valor_hash;
+	fragmento_t* fragmento = fragmento_de_clave(hash, clave, &valor_hash);
+
+	pthread_rwlock_wrlock(&fragmento->candado);
+	int resultado = hash_insertar_con_hash(fragmento->hash, clave, valor_hash, elemento);
+	pthread_rwlock_unlock(&fragmento->candado);
+
+	return resultado;
+}
+
+/*
+ * Igual que hash_quitar. Solo bloquea el fragmento de la clave.
+ * Devuelve 0 si pudo eliminar el elemento o -1 si no pudo.
+ */
+int hash_concurrente_quitar(hash_concurrente_t* hash, const char* clave){
+
+	if(!hash || !clave)
+		return ERROR;
+
+	uint64_t valor_hash;
+	fragmento_t* fragmento = fragmento_de_clave(hash, clave, &valor_hash);
+
+	pthread_rwlock_wrlock(&fragmento->candado);
+	int resultado = hash_quitar_con_hash(fragmento->hash, clave, valor_hash);
+	pthread_rwlock_unlock(&fragmento->candado);
+
+	return resultado;
+}
+
+/*
+ * Igual que hash_obtener. Varias busquedas sobre un mismo fragmento
+ * pueden hacerse a la vez.
+ * Si otro hilo quita o reemplaza la clave, el elemento devuelto puede
+ * ser destruido; mantenerlo vivo queda a cargo del usuario.
+ */
+void* hash_concurrente_obtener(hash_concurrente_t* hash, const char* clave){
+
+	if(!hash || !clave)
+		return NULL;
+
+	uint64_t valor_hash;
+	fragmento_t* fragmento = fragmento_de_clave(hash, clave, &valor_hash);
+
+	pthread_rwlock_rdlock(&fragmento->candado);
+	void* elemento = hash_obtener_con_hash(fragmento->hash, clave, valor_hash);
+	pthread_rwlock_unlock(&fragmento->candado);
+
+	return elemento;
+}
+
+/*
+ * Igual que hash_contiene.
+ */
+bool hash_concurrente_contiene(hash_concurrente_t* hash, const char* clave){
+
+	if(!hash || !clave)
+		return false;
+
+	uint64_t valor_hash;
+	fragmento_t* fragmento = fragmento_de_clave(hash, clave, &valor_hash);
+
+	pthread_rwlock_rdlock(&fragmento->candado);
+	bool contiene = hash_contiene_con_hash(fragmento->hash, clave, valor_hash);
+	pthread_rwlock_unlock(&fragmento->candado);
+
+	return contiene;
+}
+
+/*
+ * Devuelve la cantidad de elementos almacenados. Si otros hilos estan
+ * modificando el hash, es solo una aproximacion.
+ */
+size_t hash_concurrente_cantidad(hash_concurrente_t* hash){
+
+	if(!hash)
+		return SIN_ELEMENTOS;
+
+	size_t cantidad = 0;
+	for(size_t i = 0; i < hash->cantidad_fragmentos; i++){
+		pthread_rwlock_rdlock(&hash->fragmentos[i].candado);
+		cantidad += hash_cantidad(hash->fragmentos[i].hash);
+		pthread_rwlock_unlock(&hash->fragmentos[i].candado);
+	}
+
+	return cantidad;
+}
+
+/*
+ * Destruye el hash y todos sus fragmentos igual que hash_destruir.
+ * Ningun otro hilo puede estar usando el hash.
+ */
+void hash_concurrente_destruir(hash_concurrente_t* hash){
+
+	if(!hash)
+		return;
+
+	destruir_fragmentos(hash, hash->cantidad_fragmentos);
+	free(hash);
+}
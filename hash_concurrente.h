@@ -0,0 +1,68 @@
+#ifndef __HASH_CONCURRENTE_H__
+#define __HASH_CONCURRENTE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "hash.h"
+
+/*
+ * Hash para usar desde varios hilos a la vez. Las claves se reparten
+ * entre fragmentos segun los bits altos de su hash; cada fragmento es
+ * un hash_t independiente con su propio candado de lectura/escritura y
+ * se agranda por su cuenta, asi que las operaciones sobre fragmentos
+ * distintos nunca compiten entre si y agrandar un fragmento no frena a
+ * los demas.
+ */
+typedef struct hash_concurrente hash_concurrente_t;
+
+/*
+ * Crea el hash concurrente con cantidad_fragmentos fragmentos
+ * (redondeado a la siguiente potencia de 2; si es 0 se usan 16).
+ * Destruir_elemento y capacidad son iguales que en hash_crear; la
+ * capacidad se reparte entre los fragmentos.
+ * Opciones se aplica a cada fragmento igual que en
+ * hash_crear_con_opciones (puede ser NULL). Todos los fragmentos usan
+ * la misma funcion y semilla, y rehash_incremental se ignora, porque
+ * las busquedas de distintos hilos no pueden modificar el fragmento.
+ * Devuelve un puntero al hash creado o NULL en caso de no poder crearlo.
+ */
+hash_concurrente_t* hash_concurrente_crear(hash_destruir_dato_t destruir_elemento, size_t capacidad, size_t cantidad_fragmentos, const hash_opciones_t* opciones);
+
+/*
+ * Igual que hash_insertar. Solo bloquea el fragmento de la clave.
+ * Devuelve 0 si pudo guardarlo o -1 si no pudo.
+ */
+int hash_concurrente_insertar(hash_concurrente_t* hash, const char* clave, void* elemento);
+
+/*
+ * Igual que hash_quitar. Solo bloquea el fragmento de la clave.
+ * Devuelve 0 si pudo eliminar el elemento o -1 si no pudo.
+ */
+int hash_concurrente_quitar(hash_concurrente_t* hash, const char* clave);
+
+/*
+ * Igual que hash_obtener. Varias busquedas sobre un mismo fragmento
+ * pueden hacerse a la vez.
+ * Si otro hilo quita o reemplaza la clave, el elemento devuelto puede
+ * ser destruido; mantenerlo vivo queda a cargo del usuario.
+ */
+void* hash_concurrente_obtener(hash_concurrente_t* hash, const char* clave);
+
+/*
+ * Igual que hash_contiene.
+ */
+bool hash_concurrente_contiene(hash_concurrente_t* hash, const char* clave);
+
+/*
+ * Devuelve la cantidad de elementos almacenados. Si otros hilos estan
+ * modificando el hash, es solo una aproximacion.
+ */
+size_t hash_concurrente_cantidad(hash_concurrente_t* hash);
+
+/*
+ * Destruye el hash y todos sus fragmentos igual que hash_destruir.
+ * Ningun otro hilo puede estar usando el hash.
+ */
+void hash_concurrente_destruir(hash_concurrente_t* hash);
+
+#endif /* __HASH_CONCURRENTE_H__ */
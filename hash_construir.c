@@ -0,0 +1,319 @@
+#define _DEFAULT_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "hash.h"
+#include "hash_interno.h"
+
+/*
+ * Construccion en paralelo de un hash encadenado, en tres etapas
+ * separadas por la espera a todos los hilos:
+ *   1. Cada hilo calcula el hash y crea la entrada de cada clave de su
+ *      parte, y cuenta cuantas caen en cada particion (las particiones
+ *      son rangos contiguos de baldes, segun los bits altos del balde).
+ *   2. Con esas cuentas cada hilo sabe donde escribir sus entradas de
+ *      cada particion en un unico arreglo ordenado por particion, y las
+ *      copia ahi. Dentro de una particion el orden es el de la entrada.
+ *   3. Cada hilo enlaza las entradas de sus particiones en los baldes.
+ *      Como ningun otro hilo toca esos baldes no hace falta
+ *      sincronizarlos.
+ */
+
+#define PARTICIONES_POR_HILO 8
+
+typedef struct construccion{
+	hash_t* hash;
+	const char* const* claves;
+	void* const* elementos;
+	size_t cantidad;
+	size_t cantidad_hilos;
+	size_t cantidad_particiones;
+	unsigned desplazamiento_particion;
+	entrada_t** entradas;
+	entrada_t** particionadas;
+	size_t* cuentas;
+	size_t* insertadas;
+	atomic_bool sin_memoria;
+}construccion_t;
+
+typedef struct obrero{
+	construccion_t* construccion;
+	size_t numero;
+	void (*etapa)(construccion_t* construccion, size_t numero);
+}obrero_t;
+
+// pre: construccion es distinto de NULL
+// pos: devuelve la particion a la que pertenece la entrada
+size_t particion_de(const construccion_t* construccion, const entrada_t* entrada){
+
+	return (size_t)(entrada->hash & (construccion->hash->capacidad - 1)) >> construccion->desplazamiento_particion;
+}
+
+// pre: construccion es distinto de NULL y numero es menor a la cantidad de hilos
+// pos: devuelve en inicio y fin la parte de la entrada que le toca al hilo numero
+void parte_del_hilo(const construccion_t* construccion, size_t numero, size_t* inicio, size_t* fin){
+
+	*inicio = construccion->cantidad * numero / construccion->cantidad_hilos;
+	*fin = construccion->cantidad * (numero + 1) / construccion->cantidad_hilos;
+}
+
+// pre: construccion es distinto de NULL
+// pos: crea las entradas de la parte del hilo y cuenta cuantas van a cada particion
+void etapa_crear_entradas(construccion_t* construccion, size_t numero){
+
+	hash_t* hash = construccion->hash;
+	size_t* cuentas = construccion->cuentas + numero * construccion->cantidad_particiones;
+	size_t inicio, fin;
+	parte_del_hilo(construccion, numero, &inicio, &fin);
+
+	for(size_t i = inicio; i < fin; i++){
+
+		size_t largo = strlen(construccion->claves[i]);
+		entrada_t* entrada = malloc(encadenado_tamanio_entrada(largo));
+		construccion->entradas[i] = entrada;
+		if(!entrada){
+			atomic_store(&construccion->sin_memoria, true);
+			continue;
+		}
+
+		entrada->hash = hash->funcion(construccion->claves[i], largo, hash->semilla);
+		entrada->largo = largo;
+		entrada->elemento = construccion->elementos[i];
+		entrada->siguiente = NULL;
+		memcpy(entrada->clave, construccion->claves[i], largo + 1);
+
+		cuentas[particion_de(construccion, entrada)]++;
+	}
+}
+
+// pre: construccion es distinto de NULL y las cuentas ya son las posiciones de escritura del hilo
+// pos: copia las entradas de la parte del hilo a su lugar en el arreglo particionado
+void etapa_repartir(construccion_t* construccion, size_t numero){
+
+	size_t* posiciones = construccion->cuentas + numero * construccion->cantidad_particiones;
+	size_t inicio, fin;
+	parte_del_hilo(construccion, numero, &inicio, &fin);
+
+	for(size_t i = inicio; i < fin; i++){
+		entrada_t* entrada = construccion->entradas[i];
+		construccion->particionadas[posiciones[particion_de(construccion, entrada)]++] = entrada;
+	}
+}
+
+// pre: construccion es distinto de NULL y el arreglo esta particionado
+// pos: enlaza en sus baldes las entradas de las particiones del hilo. Si una clave se repite, la entrada posterior reemplaza el elemento de la anterior
+void etapa_enlazar(construccion_t* construccion, size_t numero){
+
+	hash_t* hash = construccion->hash;
+	size_t insertadas = 0;
+
+	for(size_t particion = numero; particion < construccion->cantidad_particiones; particion += construccion->cantidad_hilos){
+
+		// Al terminar la etapa anterior cada posicion quedo en el comienzo de la particion siguiente
+		size_t ultimo_hilo = (construccion->cantidad_hilos - 1) * construccion->cantidad_particiones;
+		size_t fin = construccion->cuentas[ultimo_hilo + particion];
+		size_t inicio = particion == 0 ? 0 : construccion->cuentas[ultimo_hilo + particion - 1];
+
+		for(size_t i = inicio; i < fin; i++){
+
+			entrada_t* entrada = construccion->particionadas[i];
+			entrada_t** enlace = &hash->baldes[entrada->hash & (hash->capacidad - 1)];
+			while(*enlace && ((*enlace)->hash != entrada->hash || (*enlace)->largo != entrada->largo || memcmp((*enlace)->clave, entrada->clave, entrada->largo) != 0))
+				enlace = &(*enlace)->siguiente;
+
+			if(*enlace){
+				if(hash->destructor && (*enlace)->elemento != entrada->elemento)
+					hash->destructor((*enlace)->elemento);
+				(*enlace)->elemento = entrada->elemento;
+				free(entrada);
+			}
+			else{
+				*enlace = entrada;
+				insertadas++;
+			}
+		}
+	}
+
+	construccion->insertadas[numero] = insertadas;
+}
+
+// pre: argumento es un obrero_t
+// pos: ejecuta la etapa del obrero
+void* trabajar_etapa(void* argumento){
+
+	obrero_t* obrero = argumento;
+	obrero->etapa(obrero->construccion, obrero->numero);
+
+	return NULL;
+}
+
+// pre: construccion, obreros, hilos y creados son distintos de NULL y tienen lugar para cada hilo
+// pos: ejecuta la etapa en todos los hilos (el que llama hace la parte 0) y espera a que terminen. Si no puede crear un hilo, hace su parte el que llama
+void ejecutar_etapa(construccion_t* construccion, obrero_t* obreros, pthread_t* hilos, bool* creados, void (*etapa)(construccion_t*, size_t)){
+
+	for(size_t i = 0; i < construccion->cantidad_hilos; i++)
+		obreros[i] = (obrero_t){construccion, i, etapa};
+
+	for(size_t i = 1; i < construccion->cantidad_hilos; i++)
+		creados[i] = pthread_create(&hilos[i], NULL, trabajar_etapa, &obreros[i]) == 0;
+
+	etapa(construccion, 0);
+
+	for(size_t i = 1; i < construccion->cantidad_hilos; i++){
+		if(creados[i])
+			pthread_join(hilos[i], NULL);
+		else
+			etapa(construccion, i);
+	}
+}
+
+// pre: construccion es distinto de NULL
+// pos: elige la cantidad de particiones (potencia de 2, a lo sumo la cantidad de baldes) y el desplazamiento para obtener la particion de un balde
+void elegir_particiones(construccion_t* construccion){
+
+	size_t bits_capacidad = 0;
+	while(((size_t)1 << bits_capacidad) < construccion->hash->capacidad)
+		bits_capacidad++;
+
+	size_t bits_particion = 0;
+	while(bits_particion < bits_capacidad && ((size_t)1 << bits_particion) < construccion->cantidad_hilos * PARTICIONES_POR_HILO)
+		bits_particion++;
+
+	construccion->cantidad_particiones = (size_t)1 << bits_particion;
+	construccion->desplazamiento_particion = (unsigned)(bits_capacidad - bits_particion);
+}
+
+// pre: construccion es distinto de NULL y las entradas estan creadas
+// pos: convierte las cuentas por hilo y particion en la posicion donde cada hilo empieza a escribir cada particion
+void calcular_posiciones(construccion_t* construccion){
+
+	size_t posicion = 0;
+
+	for(size_t particion = 0; particion < construccion->cantidad_particiones; particion++){
+		for(size_t hilo = 0; hilo < construccion->cantidad_hilos; hilo++){
+			size_t* cuenta = &construccion->cuentas[hilo * construccion->cantidad_particiones + particion];
+			size_t cantidad = *cuenta;
+			*cuenta = posicion;
+			posicion += cantidad;
+		}
+	}
+}
+
+// pre: construccion es distinto de NULL
+// pos: libera los arreglos auxiliares de la construccion
+void liberar_construccion(construccion_t* construccion){
+
+	free(construccion->entradas);
+	free(construccion->particionadas);
+	free(construccion->cuentas);
+	free(construccion->insertadas);
+}
+
+/*
+ * Crea un hash con cantidad claves y sus elementos (claves[i] con
+ * elementos[i]) usando cantidad_hilos hilos, incluido el que llama (a
+ * lo sumo uno por procesador en linea y uno por clave).
+ * El resultado es un hash comun, igual al que se obtiene creandolo con
+ * hash_crear_con_opciones e insertando las claves en orden con
+ * hash_insertar: si una clave se repite queda su ultimo elemento y los
+ * anteriores se destruyen.
+ * Los hilos calculan en paralelo los hashes y las entradas de su parte
+ * de la entrada, las reparten segun los bits altos de su balde y
+ * despues cada hilo enlaza por su cuenta un rango de baldes distinto,
+ * sin ninguna sincronizacion. Esto solo lo hace HASH_MOTOR_ENCADENADO
+ * con HASH_ASIGNACION_MALLOC; con otras opciones las claves se insertan
+ * con hash_insertar_lote.
+ * Devuelve el hash creado o NULL si alguna clave es NULL o no pudo
+ * crearlo.
+ */
+hash_t* hash_construir_paralelo(hash_destruir_dato_t destruir_elemento, const char* const* claves, void* const* elementos, size_t cantidad, size_t cantidad_hilos, const hash_opciones_t* opciones){
+
+	if(cantidad > 0 && (!claves || !elementos))
+		return NULL;
+
+	for(size_t i = 0; i < cantidad; i++){
+		if(!claves[i])
+			return NULL;
+	}
+
+	hash_t* hash = hash_crear_con_opciones(destruir_elemento, cantidad, opciones);
+	if(!hash || cantidad == 0)
+		return hash;
+
+	if(cantidad > SIZE_MAX / sizeof(entrada_t*)){
+		hash_destruir(hash);
+		return NULL;
+	}
+
+	// Mas hilos que procesadores o que claves no aceleran nada
+	long procesadores = sysconf(_SC_NPROCESSORS_ONLN);
+	if(procesadores > 0 && cantidad_hilos > (size_t)procesadores)
+		cantidad_hilos = (size_t)procesadores;
+	if(cantidad_hilos > cantidad)
+		cantidad_hilos = cantidad;
+
+	if(hash->operaciones != &OPERACIONES_ENCADENADO || hash->slab || cantidad_hilos < 2){
+		if(hash_insertar_lote(hash, claves, elementos, cantidad) == ERROR){
+			hash_destruir(hash);
+			return NULL;
+		}
+		return hash;
+	}
+
+	construccion_t construccion = {
+		.hash = hash,
+		.claves = claves,
+		.elementos = elementos,
+		.cantidad = cantidad,
+		.cantidad_hilos = cantidad_hilos
+	};
+	atomic_init(&construccion.sin_memoria, false);
+	elegir_particiones(&construccion);
+
+	construccion.entradas = malloc(cantidad * sizeof(entrada_t*));
+	construccion.particionadas = malloc(cantidad * sizeof(entrada_t*));
+	construccion.cuentas = calloc(cantidad_hilos * construccion.cantidad_particiones, sizeof(size_t));
+	construccion.insertadas = calloc(cantidad_hilos, sizeof(size_t));
+	obrero_t* obreros = malloc(cantidad_hilos * sizeof(obrero_t));
+	pthread_t* hilos = malloc(cantidad_hilos * sizeof(pthread_t));
+	bool* creados = calloc(cantidad_hilos, sizeof(bool));
+
+	if(!construccion.entradas || !construccion.particionadas || !construccion.cuentas || !construccion.insertadas || !obreros || !hilos || !creados){
+		liberar_construccion(&construccion);
+		free(obreros);
+		free(hilos);
+		free(creados);
+		hash_destruir(hash);
+		return NULL;
+	}
+
+	ejecutar_etapa(&construccion, obreros, hilos, creados, etapa_crear_entradas);
+
+	bool sin_memoria = atomic_load(&construccion.sin_memoria);
+	if(!sin_memoria){
+		calcular_posiciones(&construccion);
+		ejecutar_etapa(&construccion, obreros, hilos, creados, etapa_repartir);
+		ejecutar_etapa(&construccion, obreros, hilos, creados, etapa_enlazar);
+		for(size_t i = 0; i < cantidad_hilos; i++)
+			hash->cantidad_elementos += construccion.insertadas[i];
+	}
+	else{
+		for(size_t i = 0; i < cantidad; i++)
+			free(construccion.entradas[i]);
+	}
+
+	liberar_construccion(&construccion);
+	free(obreros);
+	free(hilos);
+	free(creados);
+
+	if(sin_memoria){
+		hash_destruir(hash);
+		return NULL;
+	}
+
+	return hash;
+}
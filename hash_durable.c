@@ -0,0 +1,653 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "hash_durable.h"
+#include "hash_interno.h"
+
+#define BYTES_POR_COMMIT_POR_DEFECTO (1024 * 1024)
+#define MILISEGUNDOS_POR_COMMIT_POR_DEFECTO 5
+#define CAPACIDAD_INICIAL 16
+#define TIPO_INSERTAR 1
+#define TIPO_QUITAR 2
+
+/* Elemento guardado en el hash: sus bytes precedidos por su tamanio. */
+typedef struct dato_durable{
+	uint64_t tamanio;
+	char bytes[];
+}dato_durable_t;
+
+/*
+ * Registro del log, seguido de la clave y de los bytes del elemento.
+ * suma es el hash de todo lo que sigue, para reconocer un registro que
+ * quedo escrito a medias.
+ */
+typedef struct registro_log{
+	uint64_t suma;
+	uint32_t tipo;
+	uint32_t largo_clave;
+	uint64_t largo_elemento;
+}registro_log_t;
+
+typedef struct buffer_log{
+	char* datos;
+	size_t usado;
+	size_t capacidad;
+}buffer_log_t;
+
+/*
+ * agregados cuenta los bytes que se agregaron al log desde que se abrio
+ * y durables hasta cual de ellos ya esta en disco. Mientras el escritor
+ * baja un grupo lo hace desde escribiendo, y los nuevos registros se
+ * siguen agregando a pendiente.
+ * tabla protege al hash en memoria y candado al log: los cambios toman
+ * tabla para escribir y despues candado, y las consultas y el
+ * checkpoint solo toman tabla para leer, asi un checkpoint no frena las
+ * consultas mientras escribe el snapshot. Los checkpoints se hacen de a
+ * uno tomando antes checkpoint, porque escriben el mismo snapshot y
+ * vacian el mismo log.
+ */
+struct hash_durable{
+	hash_t* hash;
+	char* ruta_snapshot;
+	int log;
+	size_t bytes_por_commit;
+	size_t milisegundos_por_commit;
+	bool esperar_commit;
+
+	pthread_mutex_t checkpoint;
+	pthread_rwlock_t tabla;
+	pthread_mutex_t candado;
+	pthread_cond_t hay_pendientes;
+	pthread_cond_t hubo_commit;
+	pthread_t escritor;
+
+	buffer_log_t pendiente;
+	buffer_log_t escribiendo;
+	struct timespec primer_pendiente;
+	uint64_t agregados;
+	uint64_t durables;
+	bool escritor_ocupado;
+	bool urgente;
+	bool terminar;
+	bool fallo;
+};
+
+// pre: elemento es un dato_durable_t
+// pos: devuelve cuantos bytes ocupa el dato en un snapshot
+size_t tamanio_dato(const void* elemento){
+
+	const dato_durable_t* dato = elemento;
+
+	return sizeof(dato_durable_t) + (size_t)dato->tamanio;
+}
+
+// pre: hash y clave son distintos de NULL
+// pos: guarda en el hash una copia de los bytes con esa clave. Devuelve 0 si pudo o -1 si no
+int aplicar_insercion(hash_t* hash, const void* clave, size_t largo, const void* bytes, size_t tamanio){
+
+	dato_durable_t* dato = malloc(sizeof(dato_durable_t) + tamanio);
+	if(!dato)
+		return ERROR;
+
+	dato->tamanio = tamanio;
+	if(tamanio > 0)
+		memcpy(dato->bytes, bytes, tamanio);
+
+	if(hash_insertar_n(hash, clave, largo, dato) == ERROR){
+		free(dato);
+		return ERROR;
+	}
+
+	return EXITO;
+}
+
+// pre: buffer es distinto de NULL
+// pos: agranda el buffer para que entren cantidad bytes mas. Devuelve false si no hay memoria
+bool asegurar_lugar(buffer_log_t* buffer, size_t cantidad){
+
+	if(buffer->capacidad - buffer->usado >= cantidad)
+		return true;
+
+	size_t capacidad = buffer->capacidad ? buffer->capacidad : 4096;
+	while(capacidad - buffer->usado < cantidad)
+		capacidad *= 2;
+
+	char* datos = realloc(buffer->datos, capacidad);
+	if(!datos)
+		return false;
+
+	buffer->datos = datos;
+	buffer->capacidad = capacidad;
+
+	return true;
+}
+
+// pre: buffer tiene lugar para el registro completo
+// pos: agrega al buffer el registro con la clave y el elemento, calculando su suma
+void escribir_registro(buffer_log_t* buffer, uint32_t tipo, const char* clave, size_t largo_clave, const void* elemento, size_t largo_elemento){
+
+	registro_log_t registro = {0, tipo, (uint32_t)largo_clave, largo_elemento};
+	char* inicio = buffer->datos + buffer->usado;
+
+	memcpy(inicio, &registro, sizeof(registro));
+	memcpy(inicio + sizeof(registro), clave, largo_clave);
+	if(largo_elemento > 0)
+		memcpy(inicio + sizeof(registro) + largo_clave, elemento, largo_elemento);
+
+	size_t tamanio = sizeof(registro) + largo_clave + largo_elemento;
+	registro.suma = hash_funcion_rapida(inicio + sizeof(uint64_t), tamanio - sizeof(uint64_t), 0);
+	memcpy(inicio, &registro.suma, sizeof(registro.suma));
+
+	buffer->usado += tamanio;
+}
+
+// pre: descriptor es un archivo abierto
+// pos: escribe los tamanio bytes de datos aunque write los acepte de a partes. Devuelve false si no pudo
+bool escribir_todo(int descriptor, const char* datos, size_t tamanio){
+
+	while(tamanio > 0){
+		ssize_t escritos = write(descriptor, datos, tamanio);
+		if(escritos < 0 && errno == EINTR)
+			continue;
+		if(escritos <= 0)
+			return false;
+		datos += escritos;
+		tamanio -= (size_t)escritos;
+	}
+
+	return true;
+}
+
+// pre: durable es distinto de NULL y se tiene su candado
+// pos: espera a que el escritor termine de bajar a disco el grupo que estuviera escribiendo
+void esperar_escritor(hash_durable_t* durable){
+
+	while(durable->escritor_ocupado)
+		pthread_cond_wait(&durable->hubo_commit, &durable->candado);
+}
+
+// pre: argumento es un hash_durable_t
+// pos: baja a disco los registros pendientes por grupos hasta que se cierre el hash
+void* escribir_log(void* argumento){
+
+	hash_durable_t* durable = argumento;
+
+	pthread_mutex_lock(&durable->candado);
+
+	while(true){
+
+		while(durable->pendiente.usado == 0 && !durable->terminar)
+			pthread_cond_wait(&durable->hay_pendientes, &durable->candado);
+
+		if(durable->pendiente.usado == 0)
+			break;
+
+		// Junta registros hasta llenar el grupo o cumplir el plazo del primero
+		struct timespec plazo = durable->primer_pendiente;
+		plazo.tv_nsec += (long)(durable->milisegundos_por_commit % 1000) * 1000000;
+		plazo.tv_sec += (time_t)(durable->milisegundos_por_commit / 1000) + plazo.tv_nsec / 1000000000;
+		plazo.tv_nsec %= 1000000000;
+
+		while(!durable->urgente && !durable->terminar && durable->pendiente.usado > 0 && durable->pendiente.usado < durable->bytes_por_commit){
+			if(pthread_cond_timedwait(&durable->hay_pendientes, &durable->candado, &plazo) == ETIMEDOUT)
+				break;
+		}
+
+		// Un checkpoint pudo haberlos bajado mientras esperaba
+		if(durable->pendiente.usado == 0)
+			continue;
+
+		// Despues de un fallo no se baja nada mas: un grupo posterior no puede quedar
+		// en disco sin el que se perdio. Quienes esperaban su commit vuelven con error
+		if(durable->fallo){
+			durable->pendiente.usado = 0;
+			pthread_cond_broadcast(&durable->hubo_commit);
+			continue;
+		}
+
+		buffer_log_t grupo = durable->pendiente;
+		durable->pendiente = durable->escribiendo;
+		durable->escribiendo = grupo;
+		uint64_t objetivo = durable->agregados;
+		durable->urgente = false;
+		durable->escritor_ocupado = true;
+
+		pthread_mutex_unlock(&durable->candado);
+		bool escrito = escribir_todo(durable->log, grupo.datos, grupo.usado) && fdatasync(durable->log) == 0;
+		pthread_mutex_lock(&durable->candado);
+
+		durable->escribiendo.usado = 0;
+		durable->escritor_ocupado = false;
+		if(escrito)
+			durable->durables = objetivo;
+		else
+			durable->fallo = true;
+		pthread_cond_broadcast(&durable->hubo_commit);
+	}
+
+	pthread_mutex_unlock(&durable->candado);
+
+	return NULL;
+}
+
+// pre: durable es distinto de NULL y se tiene su candado. El registro ya esta en pendiente
+// pos: avisa al escritor y, si hay que esperar el commit, espera a que el registro este en disco. Devuelve 0 si pudo o -1 si no
+int confirmar_registro(hash_durable_t* durable, bool estaba_vacio){
+
+	uint64_t propio = durable->agregados;
+
+	if(estaba_vacio)
+		clock_gettime(CLOCK_REALTIME, &durable->primer_pendiente);
+
+	if(durable->esperar_commit)
+		durable->urgente = true;
+
+	if(estaba_vacio || durable->urgente || durable->pendiente.usado >= durable->bytes_por_commit)
+		pthread_cond_signal(&durable->hay_pendientes);
+
+	while(durable->esperar_commit && durable->durables < propio && !durable->fallo)
+		pthread_cond_wait(&durable->hubo_commit, &durable->candado);
+
+	return durable->fallo ? ERROR : EXITO;
+}
+
+// pre: hash es distinto de NULL y la ruta existe
+// pos: carga en hash una copia de cada elemento del snapshot. Devuelve 0 si pudo o -1 si no
+int cargar_snapshot(hash_t* hash, const char* ruta){
+
+	hash_t* snapshot = hash_abrir_snapshot(ruta, hash->funcion);
+	if(!snapshot)
+		return ERROR;
+
+	int resultado = hash_reservar(hash, hash_cantidad(snapshot));
+
+	hash_cursor_t cursor;
+	const char* clave;
+	size_t largo;
+	void* elemento;
+	hash_cursor_iniciar(&cursor, snapshot);
+	while(resultado == EXITO && hash_cursor_siguiente(&cursor, &clave, &largo, &elemento)){
+		const dato_durable_t* dato = elemento;
+		resultado = aplicar_insercion(hash, clave, largo, dato->bytes, (size_t)dato->tamanio);
+	}
+
+	hash_destruir(snapshot);
+
+	return resultado;
+}
+
+// pre: hash es distinto de NULL y descriptor es el log abierto
+// pos: aplica al hash los registros del log y corta el log despues del ultimo registro completo. Devuelve 0 si pudo o -1 si no
+int reproducir_log(hash_t* hash, int descriptor){
+
+	struct stat estado;
+	if(fstat(descriptor, &estado) != 0)
+		return ERROR;
+
+	size_t tamanio = (size_t)estado.st_size;
+	char* datos = malloc(tamanio + 1);
+	if(!datos)
+		return ERROR;
+
+	size_t leidos = 0;
+	while(leidos < tamanio){
+		ssize_t leido = pread(descriptor, datos + leidos, tamanio - leidos, (off_t)leidos);
+		if(leido < 0 && errno == EINTR)
+			continue;
+		if(leido <= 0){
+			free(datos);
+			return ERROR;
+		}
+		leidos += (size_t)leido;
+	}
+
+	size_t posicion = 0;
+	int resultado = EXITO;
+
+	while(resultado == EXITO && tamanio - posicion >= sizeof(registro_log_t)){
+
+		registro_log_t registro;
+		memcpy(&registro, datos + posicion, sizeof(registro));
+		size_t restante = tamanio - posicion - sizeof(registro);
+		if(registro.largo_clave > restante || registro.largo_elemento > restante - registro.largo_clave)
+			break;
+
+		size_t largo_registro = sizeof(registro) + registro.largo_clave + (size_t)registro.largo_elemento;
+		if(hash_funcion_rapida(datos + posicion + sizeof(uint64_t), largo_registro - sizeof(uint64_t), 0) != registro.suma)
+			break;
+
+		const char* clave = datos + posicion + sizeof(registro);
+		if(registro.tipo == TIPO_INSERTAR)
+			resultado = aplicar_insercion(hash, clave, registro.largo_clave, clave + registro.largo_clave, (size_t)registro.largo_elemento);
+		else
+			hash_quitar_n(hash, clave, registro.largo_clave);
+
+		posicion += largo_registro;
+	}
+
+	free(datos);
+
+	if(resultado == EXITO && posicion < tamanio && ftruncate(descriptor, (off_t)posicion) != 0)
+		resultado = ERROR;
+
+	return resultado;
+}
+
+// pre: ruta y sufijo son distintos de NULL
+// pos: devuelve un string nuevo con la ruta seguida del sufijo, o NULL si no hay memoria
+char* ruta_con_sufijo(const char* ruta, const char* sufijo){
+
+	char* resultado = malloc(strlen(ruta) + strlen(sufijo) + 1);
+	if(resultado)
+		sprintf(resultado, "%s%s", ruta, sufijo);
+
+	return resultado;
+}
+
+/*
+ * Abre el hash durable guardado en ruta (usa los archivos ruta.snapshot
+ * y ruta.log, creandolos si no existen), cargando el snapshot y
+ * aplicando el log. Un registro incompleto al final del log (de un corte
+ * en medio de una escritura) se descarta.
+ * Opciones se usa para crear el hash en memoria igual que en
+ * hash_crear_con_opciones, salvo rehash_incremental que se ignora
+ * porque las consultas de distintos hilos no pueden modificar el hash.
+ * Durabilidad puede ser NULL.
+ * Devuelve el hash o NULL si no pudo abrirlo.
+ */
+hash_durable_t* hash_durable_abrir(const char* ruta, const hash_opciones_t* opciones, const hash_durable_opciones_t* durabilidad){
+
+	if(!ruta)
+		return NULL;
+
+	hash_durable_t* durable = calloc(1, sizeof(hash_durable_t));
+	if(!durable)
+		return NULL;
+
+	hash_durable_opciones_t por_defecto = {0};
+	if(!durabilidad)
+		durabilidad = &por_defecto;
+	durable->bytes_por_commit = durabilidad->bytes_por_commit ? durabilidad->bytes_por_commit : BYTES_POR_COMMIT_POR_DEFECTO;
+	durable->milisegundos_por_commit = durabilidad->milisegundos_por_commit ? durabilidad->milisegundos_por_commit : MILISEGUNDOS_POR_COMMIT_POR_DEFECTO;
+	durable->esperar_commit = durabilidad->esperar_commit;
+	durable->log = -1;
+
+	char* ruta_log = ruta_con_sufijo(ruta, ".log");
+	durable->ruta_snapshot = ruta_con_sufijo(ruta, ".snapshot");
+	hash_opciones_t opciones_hash = {0};
+	if(opciones)
+		opciones_hash = *opciones;
+	opciones_hash.rehash_incremental = false;
+	durable->hash = hash_crear_con_opciones(free, CAPACIDAD_INICIAL, &opciones_hash);
+
+	bool abierto = ruta_log && durable->ruta_snapshot && durable->hash;
+	if(abierto && access(durable->ruta_snapshot, F_OK) == 0)
+		abierto = cargar_snapshot(durable->hash, durable->ruta_snapshot) == EXITO;
+	if(abierto){
+		// El log puede haberse creado recien: sin sincronizar el directorio un corte
+		// de luz podria hacerlo desaparecer junto con los commits que se le escriban
+		durable->log = open(ruta_log, O_RDWR | O_CREAT | O_APPEND, 0644);
+		abierto = durable->log >= 0 && sincronizar_directorio(ruta_log) == EXITO && reproducir_log(durable->hash, durable->log) == EXITO;
+	}
+	free(ruta_log);
+
+	if(abierto){
+		pthread_mutex_init(&durable->checkpoint, NULL);
+		pthread_rwlock_init(&durable->tabla, NULL);
+		pthread_mutex_init(&durable->candado, NULL);
+		pthread_cond_init(&durable->hay_pendientes, NULL);
+		pthread_cond_init(&durable->hubo_commit, NULL);
+		abierto = pthread_create(&durable->escritor, NULL, escribir_log, durable) == 0;
+		if(!abierto){
+			pthread_cond_destroy(&durable->hubo_commit);
+			pthread_cond_destroy(&durable->hay_pendientes);
+			pthread_mutex_destroy(&durable->candado);
+			pthread_rwlock_destroy(&durable->tabla);
+			pthread_mutex_destroy(&durable->checkpoint);
+		}
+	}
+
+	if(!abierto){
+		if(durable->log >= 0)
+			close(durable->log);
+		hash_destruir(durable->hash);
+		free(durable->ruta_snapshot);
+		free(durable);
+		return NULL;
+	}
+
+	return durable;
+}
+
+/*
+ * Guarda una copia de los tamanio bytes de elemento con esa clave,
+ * reemplazando el elemento anterior si la clave ya estaba.
+ * Devuelve 0 si pudo guardarlo o -1 si no pudo. Si el -1 viene de un
+ * fallo al escribir el log, el elemento queda igual en memoria (ver
+ * hash_durable.h).
+ */
+int hash_durable_insertar(hash_durable_t* hash, const char* clave, const void* elemento, size_t tamanio){
+
+	if(!hash || !clave || (tamanio > 0 && !elemento))
+		return ERROR;
+
+	size_t largo = strlen(clave);
+	if(largo > UINT32_MAX)
+		return ERROR;
+
+	pthread_rwlock_wrlock(&hash->tabla);
+	pthread_mutex_lock(&hash->candado);
+
+	bool estaba_vacio = hash->pendiente.usado == 0;
+	size_t largo_registro = sizeof(registro_log_t) + largo + tamanio;
+	if(hash->fallo || !asegurar_lugar(&hash->pendiente, largo_registro) || aplicar_insercion(hash->hash, clave, largo, elemento, tamanio) == ERROR){
+		pthread_mutex_unlock(&hash->candado);
+		pthread_rwlock_unlock(&hash->tabla);
+		return ERROR;
+	}
+
+	escribir_registro(&hash->pendiente, TIPO_INSERTAR, clave, largo, elemento, tamanio);
+	hash->agregados += largo_registro;
+
+	// La tabla se suelta antes de esperar el commit, para que otros cambios compartan el fsync
+	pthread_rwlock_unlock(&hash->tabla);
+
+	int resultado = confirmar_registro(hash, estaba_vacio);
+	pthread_mutex_unlock(&hash->candado);
+
+	return resultado;
+}
+
+/*
+ * Quita la clave y su elemento.
+ * Devuelve 0 si pudo eliminarla o -1 si no estaba o no pudo. Si el -1
+ * viene de un fallo al escribir el log, la clave queda igual quitada en
+ * memoria.
+ */
+int hash_durable_quitar(hash_durable_t* hash, const char* clave){
+
+	if(!hash || !clave)
+		return ERROR;
+
+	size_t largo = strlen(clave);
+	if(largo > UINT32_MAX)
+		return ERROR;
+
+	pthread_rwlock_wrlock(&hash->tabla);
+	pthread_mutex_lock(&hash->candado);
+
+	bool estaba_vacio = hash->pendiente.usado == 0;
+	size_t largo_registro = sizeof(registro_log_t) + largo;
+	if(hash->fallo || !asegurar_lugar(&hash->pendiente, largo_registro) || hash_quitar_n(hash->hash, clave, largo) == ERROR){
+		pthread_mutex_unlock(&hash->candado);
+		pthread_rwlock_unlock(&hash->tabla);
+		return ERROR;
+	}
+
+	escribir_registro(&hash->pendiente, TIPO_QUITAR, clave, largo, NULL, 0);
+	hash->agregados += largo_registro;
+
+	pthread_rwlock_unlock(&hash->tabla);
+
+	int resultado = confirmar_registro(hash, estaba_vacio);
+	pthread_mutex_unlock(&hash->candado);
+
+	return resultado;
+}
+
+/*
+ * Busca la clave. Si esta, copia hasta capacidad bytes de su elemento en
+ * destino (si no es NULL) y deja en tamanio (si no es NULL) el tamanio
+ * completo del elemento.
+ * Devuelve true si la clave esta o false en caso contrario.
+ */
+bool hash_durable_obtener(hash_durable_t* hash, const char* clave, void* destino, size_t capacidad, size_t* tamanio){
+
+	if(!hash || !clave)
+		return false;
+
+	pthread_rwlock_rdlock(&hash->tabla);
+
+	dato_durable_t* dato = hash_obtener(hash->hash, clave);
+	if(dato){
+		if(destino)
+			memcpy(destino, dato->bytes, capacidad < dato->tamanio ? capacidad : (size_t)dato->tamanio);
+		if(tamanio)
+			*tamanio = (size_t)dato->tamanio;
+	}
+
+	pthread_rwlock_unlock(&hash->tabla);
+
+	return dato != NULL;
+}
+
+/*
+ * Devuelve true si la clave esta en el hash.
+ */
+bool hash_durable_contiene(hash_durable_t* hash, const char* clave){
+
+	return hash_durable_obtener(hash, clave, NULL, 0, NULL);
+}
+
+/*
+ * Devuelve la cantidad de claves del hash.
+ */
+size_t hash_durable_cantidad(hash_durable_t* hash){
+
+	if(!hash)
+		return 0;
+
+	pthread_rwlock_rdlock(&hash->tabla);
+	size_t cantidad = hash_cantidad(hash->hash);
+	pthread_rwlock_unlock(&hash->tabla);
+
+	return cantidad;
+}
+
+/*
+ * Espera a que todos los cambios hechos hasta ahora esten en disco.
+ * Devuelve 0 si lo estan o -1 si no pudo escribirlos.
+ */
+int hash_durable_sincronizar(hash_durable_t* hash){
+
+	if(!hash)
+		return ERROR;
+
+	pthread_mutex_lock(&hash->candado);
+
+	uint64_t objetivo = hash->agregados;
+	if(hash->durables < objetivo){
+		hash->urgente = true;
+		pthread_cond_signal(&hash->hay_pendientes);
+	}
+	while(hash->durables < objetivo && !hash->fallo)
+		pthread_cond_wait(&hash->hubo_commit, &hash->candado);
+
+	int resultado = hash->fallo ? ERROR : EXITO;
+	pthread_mutex_unlock(&hash->candado);
+
+	return resultado;
+}
+
+/*
+ * Guarda un snapshot del hash y vacia el log, para que abrirlo no tenga
+ * que volver a aplicar todos los cambios. Mientras se escribe el
+ * snapshot las consultas y hash_durable_sincronizar siguen funcionando;
+ * solo las inserciones y los borrados esperan a que termine. Si varios
+ * hilos piden un checkpoint a la vez, se hacen de a uno.
+ * Devuelve 0 si pudo o -1 si no pudo; en ese caso el log no se vacia.
+ */
+int hash_durable_checkpoint(hash_durable_t* hash){
+
+	if(!hash)
+		return ERROR;
+
+	// Con la tabla tomada para leer no entran cambios nuevos al hash ni al log hasta el final
+	pthread_mutex_lock(&hash->checkpoint);
+	pthread_rwlock_rdlock(&hash->tabla);
+	pthread_mutex_lock(&hash->candado);
+	esperar_escritor(hash);
+
+	// Lo pendiente se baja aca mismo: el snapshot no puede quedar adelante del log
+	bool escrito = !hash->fallo && escribir_todo(hash->log, hash->pendiente.datos, hash->pendiente.usado) && fdatasync(hash->log) == 0;
+	if(escrito){
+		hash->pendiente.usado = 0;
+		hash->durables = hash->agregados;
+		pthread_cond_broadcast(&hash->hubo_commit);
+	}
+	else
+		hash->fallo = true;
+
+	pthread_mutex_unlock(&hash->candado);
+
+	// Si se corta despues de guardar el snapshot y antes de vaciar el log, al abrir se
+	// vuelven a aplicar cambios que ya estan en el snapshot, con el mismo resultado.
+	// hash_guardar_snapshot sincroniza el directorio despues del renombre, asi que el
+	// log nunca queda vacio con el snapshot anterior en disco
+	escrito = escrito && hash_guardar_snapshot(hash->hash, hash->ruta_snapshot, tamanio_dato) == EXITO;
+
+	pthread_mutex_lock(&hash->candado);
+	escrito = escrito && ftruncate(hash->log, 0) == 0 && fdatasync(hash->log) == 0;
+	pthread_mutex_unlock(&hash->candado);
+
+	pthread_rwlock_unlock(&hash->tabla);
+	pthread_mutex_unlock(&hash->checkpoint);
+
+	return escrito ? EXITO : ERROR;
+}
+
+/*
+ * Baja a disco los cambios pendientes y libera el hash. Ningun otro
+ * hilo puede estar usandolo.
+ */
+void hash_durable_cerrar(hash_durable_t* hash){
+
+	if(!hash)
+		return;
+
+	pthread_mutex_lock(&hash->candado);
+	hash->terminar = true;
+	pthread_cond_signal(&hash->hay_pendientes);
+	pthread_mutex_unlock(&hash->candado);
+
+	pthread_join(hash->escritor, NULL);
+
+	pthread_cond_destroy(&hash->hubo_commit);
+	pthread_cond_destroy(&hash->hay_pendientes);
+	pthread_mutex_destroy(&hash->candado);
+	pthread_rwlock_destroy(&hash->tabla);
+	pthread_mutex_destroy(&hash->checkpoint);
+	close(hash->log);
+	hash_destruir(hash->hash);
+	free(hash->pendiente.datos);
+	free(hash->escribiendo.datos);
+	free(hash->ruta_snapshot);
+	free(hash);
+}
@@ -0,0 +1,118 @@
+#ifndef __HASH_DURABLE_H__
+#define __HASH_DURABLE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "hash.h"
+
+/*
+ * Hash que sobrevive a que el proceso termine. Cada insercion o
+ * borrado se aplica a un hash_t en memoria y se agrega a un log en
+ * disco; un hilo escritor junta los registros pendientes y los baja
+ * con un solo fsync por grupo (cuando se acumulan bytes_por_commit
+ * bytes, pasan milisegundos_por_commit milisegundos o alguien espera
+ * el commit). hash_durable_checkpoint guarda un snapshot y vacia el
+ * log, y al abrir se carga el ultimo snapshot y se le aplica el log.
+ * Todas las funciones pueden usarse desde varios hilos a la vez.
+ *
+ * Los elementos son bytes que el hash copia: insertar guarda una copia
+ * y obtener copia el elemento al lugar que indique el usuario.
+ *
+ * Cada cambio se aplica a la tabla en memoria antes de que su registro
+ * llegue a disco. Si falla una escritura del log, el hash queda en
+ * estado de error: todas las inserciones, borrados, sincronizaciones y
+ * checkpoints siguientes devuelven -1 y nada mas llega a disco, pero los
+ * cambios cuyo registro no se pudo escribir (incluido el de la llamada
+ * que devolvio -1) siguen visibles en memoria para hash_durable_obtener
+ * y hash_durable_contiene hasta cerrar el hash. Al volver a abrirlo solo
+ * se recupera lo que llego a disco.
+ */
+typedef struct hash_durable hash_durable_t;
+
+/*
+ * Opciones de durabilidad. Una estructura inicializada en cero equivale
+ * a las opciones por defecto: 1 MiB por commit y 5 milisegundos.
+ * Si esperar_commit es true, hash_durable_insertar y hash_durable_quitar
+ * vuelven recien cuando su registro esta en disco (los que llegan
+ * mientras se hace un fsync comparten el siguiente). Si es false vuelven
+ * enseguida y un corte puede perder a lo sumo los ultimos
+ * milisegundos_por_commit milisegundos de cambios, salvo los que se
+ * confirmaron con hash_durable_sincronizar.
+ */
+typedef struct hash_durable_opciones{
+	size_t bytes_por_commit;
+	size_t milisegundos_por_commit;
+	bool esperar_commit;
+}hash_durable_opciones_t;
+
+/*
+ * Abre el hash durable guardado en ruta (usa los archivos ruta.snapshot
+ * y ruta.log, creandolos si no existen), cargando el snapshot y
+ * aplicando el log. Un registro incompleto al final del log (de un corte
+ * en medio de una escritura) se descarta.
+ * Opciones se usa para crear el hash en memoria igual que en
+ * hash_crear_con_opciones, salvo rehash_incremental que se ignora
+ * porque las consultas de distintos hilos no pueden modificar el hash.
+ * Durabilidad puede ser NULL.
+ * Devuelve el hash o NULL si no pudo abrirlo.
+ */
+hash_durable_t* hash_durable_abrir(const char* ruta, const hash_opciones_t* opciones, const hash_durable_opciones_t* durabilidad);
+
+/*
+ * Guarda una copia de los tamanio bytes de elemento con esa clave,
+ * reemplazando el elemento anterior si la clave ya estaba.
+ * Devuelve 0 si pudo guardarlo o -1 si no pudo. Si el -1 viene de un
+ * fallo al escribir el log, el elemento queda igual en memoria (ver
+ * arriba).
+ */
+int hash_durable_insertar(hash_durable_t* hash, const char* clave, const void* elemento, size_t tamanio);
+
+/*
+ * Quita la clave y su elemento.
+ * Devuelve 0 si pudo eliminarla o -1 si no estaba o no pudo. Si el -1
+ * viene de un fallo al escribir el log, la clave queda igual quitada en
+ * memoria.
+ */
+int hash_durable_quitar(hash_durable_t* hash, const char* clave);
+
+/*
+ * Busca la clave. Si esta, copia hasta capacidad bytes de su elemento en
+ * destino (si no es NULL) y deja en tamanio (si no es NULL) el tamanio
+ * completo del elemento.
+ * Devuelve true si la clave esta o false en caso contrario.
+ */
+bool hash_durable_obtener(hash_durable_t* hash, const char* clave, void* destino, size_t capacidad, size_t* tamanio);
+
+/*
+ * Devuelve true si la clave esta en el hash.
+ */
+bool hash_durable_contiene(hash_durable_t* hash, const char* clave);
+
+/*
+ * Devuelve la cantidad de claves del hash.
+ */
+size_t hash_durable_cantidad(hash_durable_t* hash);
+
+/*
+ * Espera a que todos los cambios hechos hasta ahora esten en disco.
+ * Devuelve 0 si lo estan o -1 si no pudo escribirlos.
+ */
+int hash_durable_sincronizar(hash_durable_t* hash);
+
+/*
+ * Guarda un snapshot del hash y vacia el log, para que abrirlo no tenga
+ * que volver a aplicar todos los cambios. Mientras se escribe el
+ * snapshot las consultas y hash_durable_sincronizar siguen funcionando;
+ * solo las inserciones y los borrados esperan a que termine. Si varios
+ * hilos piden un checkpoint a la vez, se hacen de a uno.
+ * Devuelve 0 si pudo o -1 si no pudo; en ese caso el log no se vacia.
+ */
+int hash_durable_checkpoint(hash_durable_t* hash);
+
+/*
+ * Baja a disco los cambios pendientes y libera el hash. Ningun otro
+ * hilo puede estar usandolo.
+ */
+void hash_durable_cerrar(hash_durable_t* hash);
+
+#endif /* __HASH_DURABLE_H__ */
@@ -0,0 +1,521 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "hash_interno.h"
+
+/*
+ * Motor encadenado. El arreglo de baldes guarda directamente el primer
+ * elemento de cada cadena y cada elemento lleva su propio enlace al
+ * siguiente, su hash y los bytes de su clave en una unica reserva. Las
+ * busquedas recorren la cadena sin reservar memoria.
+ *
+ * Con rehash incremental, al agrandarse la tabla el arreglo anterior se
+ * conserva en baldes_viejos y cada operacion muda unos pocos baldes al
+ * arreglo nuevo (como el rehash progresivo de Redis). Mientras tanto las
+ * busquedas miran el balde viejo si todavia no fue mudado, y las
+ * inserciones van siempre al arreglo nuevo.
+ *
+ * Como la cantidad de baldes siempre se multiplica por una potencia de
+ * 2, las entradas de un balde viejo solo pueden ir a baldes nuevos que
+ * no recibe ningun otro balde viejo. Por eso, cuando la tabla es grande
+ * y se pidieron hilos_rehash, la mudanza completa se reparte entre
+ * varios hilos sin ninguna sincronizacion sobre los baldes nuevos: cada
+ * hilo tiene su propio tramo de baldes viejos, los toma de a
+ * BALDES_POR_TAREA y al terminarlo roba tareas de los tramos de los
+ * demas.
+ */
+
+#define CAPACIDAD_MINIMA 8
+#define BALDES_POR_PASO 1
+#define VACIOS_POR_PASO 10
+#define UMBRAL_REHASH_PARALELO 4096
+#define BALDES_POR_TAREA 1024
+#define LINEA_CACHE 64
+
+typedef struct tramo{
+	_Alignas(LINEA_CACHE) _Atomic size_t proximo;
+	size_t fin;
+}tramo_t;
+
+typedef struct mudanza{
+	hash_t* hash;
+	tramo_t* tramos;
+	size_t cantidad_tramos;
+}mudanza_t;
+
+typedef struct trabajador{
+	mudanza_t* mudanza;
+	size_t tramo_propio;
+}trabajador_t;
+
+// pre:
+// pos: devuelve la menor potencia de 2 mayor o igual a capacidad (y a CAPACIDAD_MINIMA)
+size_t encadenado_capacidad_para(size_t capacidad){
+
+	size_t potencia = CAPACIDAD_MINIMA;
+
+	while(potencia < capacidad)
+		potencia *= 2;
+
+	return potencia;
+}
+
+// pre: hash es distinto de NULL
+// pos: crea el arreglo de baldes vacio. Devuelve TRUE si pudo, FALSE en caso contrario
+bool encadenado_crear(hash_t* hash, size_t capacidad){
+
+	hash->capacidad = encadenado_capacidad_para(capacidad);
+	hash->baldes = calloc(hash->capacidad, sizeof(entrada_t*));
+	hash->baldes_viejos = NULL;
+	hash->capacidad_vieja = 0;
+	hash->migrados = 0;
+
+	return hash->baldes != NULL;
+}
+
+// pre:
+// pos: devuelve la cantidad de bytes que ocupa una entrada con una clave de largo bytes
+size_t encadenado_tamanio_entrada(size_t largo){
+
+	return sizeof(entrada_t) + largo + 1;
+}
+
+// pre: hash es distinto de NULL
+// pos: libera la entrada, invocando al destructor con su elemento si destruir_elemento es true
+void encadenado_liberar_entrada(hash_t* hash, entrada_t* entrada, bool destruir_elemento){
+
+	if(destruir_elemento && hash->destructor)
+		hash->destructor(entrada->elemento);
+
+	hash_liberar_memoria(hash, entrada, encadenado_tamanio_entrada(entrada->largo));
+}
+
+// pre: enlace es distinto de NULL
+// pos: devuelve el enlace de la cadena que apunta a la entrada con esa clave, o al NULL final de la cadena si no esta
+entrada_t** encadenado_buscar_en_cadena(entrada_t** enlace, const void* clave, size_t largo, uint64_t valor_hash){
+
+	while(*enlace && ((*enlace)->hash != valor_hash || (*enlace)->largo != largo || memcmp((*enlace)->clave, clave, largo) != 0))
+		enlace = &(*enlace)->siguiente;
+
+	return enlace;
+}
+
+// pre: hash y clave son distintos de NULL
+// pos: devuelve el enlace (puntero al puntero) que apunta a la entrada con esa clave, o al NULL final de su cadena en el arreglo actual si no esta
+entrada_t** encadenado_ubicar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash){
+
+	if(hash->baldes_viejos){
+		size_t balde_viejo = (size_t)(valor_hash & (hash->capacidad_vieja - 1));
+		if(balde_viejo >= hash->migrados){
+			entrada_t** enlace = encadenado_buscar_en_cadena(&hash->baldes_viejos[balde_viejo], clave, largo, valor_hash);
+			if(*enlace)
+				return enlace;
+		}
+	}
+
+	return encadenado_buscar_en_cadena(&hash->baldes[valor_hash & (hash->capacidad - 1)], clave, largo, valor_hash);
+}
+
+// pre: hash es distinto de NULL
+// pos: mueve las entradas de la cadena al arreglo de baldes actual segun su hash guardado
+void encadenado_mudar_cadena(hash_t* hash, entrada_t* entrada){
+
+	while(entrada){
+		entrada_t* siguiente = entrada->siguiente;
+		size_t balde = (size_t)(entrada->hash & (hash->capacidad - 1));
+		entrada->siguiente = hash->baldes[balde];
+		hash->baldes[balde] = entrada;
+		entrada = siguiente;
+	}
+}
+
+// pre: hash es distinto de NULL
+// pos: muda a lo sumo baldes_a_mudar baldes con entradas (y vacios_a_saltear vacios) del arreglo viejo. Libera el arreglo viejo al terminar
+void encadenado_migrar(hash_t* hash, size_t baldes_a_mudar, size_t vacios_a_saltear){
+
+	while(hash->migrados < hash->capacidad_vieja && baldes_a_mudar > 0){
+
+		entrada_t* cadena = hash->baldes_viejos[hash->migrados];
+		hash->baldes_viejos[hash->migrados] = NULL;
+		hash->migrados++;
+
+		if(cadena){
+			encadenado_mudar_cadena(hash, cadena);
+			baldes_a_mudar--;
+		}
+		else if(vacios_a_saltear-- == 0)
+			break;
+	}
+
+	if(hash->migrados == hash->capacidad_vieja){
+		free(hash->baldes_viejos);
+		hash->baldes_viejos = NULL;
+		hash->capacidad_vieja = 0;
+		hash->migrados = 0;
+	}
+}
+
+// pre: argumento es un trabajador_t
+// pos: muda las tareas de su tramo y despues las que queden en los tramos de los demas trabajadores
+void* encadenado_trabajar_mudanza(void* argumento){
+
+	trabajador_t* trabajador = argumento;
+	mudanza_t* mudanza = trabajador->mudanza;
+	hash_t* hash = mudanza->hash;
+
+	for(size_t i = 0; i < mudanza->cantidad_tramos; i++){
+
+		tramo_t* tramo = &mudanza->tramos[(trabajador->tramo_propio + i) % mudanza->cantidad_tramos];
+		size_t inicio;
+
+		while((inicio = atomic_fetch_add_explicit(&tramo->proximo, BALDES_POR_TAREA, memory_order_relaxed)) < tramo->fin){
+
+			size_t fin = inicio + BALDES_POR_TAREA < tramo->fin ? inicio + BALDES_POR_TAREA : tramo->fin;
+			for(size_t balde = inicio; balde < fin; balde++){
+				encadenado_mudar_cadena(hash, hash->baldes_viejos[balde]);
+				hash->baldes_viejos[balde] = NULL;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+// pre: hash es distinto de NULL y tiene una mudanza en curso
+// pos: muda todos los baldes viejos pendientes repartiendolos entre hilos_rehash hilos, incluido el que llama. Si no puede crear algun hilo, los demas hacen su parte
+void encadenado_migrar_en_paralelo(hash_t* hash){
+
+	size_t cantidad_hilos = hash->hilos_rehash;
+	tramo_t* tramos = aligned_alloc(LINEA_CACHE, cantidad_hilos * sizeof(tramo_t));
+	trabajador_t* trabajadores = malloc(cantidad_hilos * sizeof(trabajador_t));
+	pthread_t* hilos = malloc(cantidad_hilos * sizeof(pthread_t));
+	bool* creados = calloc(cantidad_hilos, sizeof(bool));
+
+	if(!tramos || !trabajadores || !hilos || !creados){
+		free(tramos);
+		free(trabajadores);
+		free(hilos);
+		free(creados);
+		return;
+	}
+
+	mudanza_t mudanza = {hash, tramos, cantidad_hilos};
+	size_t pendientes = hash->capacidad_vieja - hash->migrados;
+
+	for(size_t i = 0; i < cantidad_hilos; i++){
+		atomic_init(&tramos[i].proximo, hash->migrados + pendientes * i / cantidad_hilos);
+		tramos[i].fin = hash->migrados + pendientes * (i + 1) / cantidad_hilos;
+		trabajadores[i] = (trabajador_t){&mudanza, i};
+	}
+
+	for(size_t i = 1; i < cantidad_hilos; i++)
+		creados[i] = pthread_create(&hilos[i], NULL, encadenado_trabajar_mudanza, &trabajadores[i]) == 0;
+
+	encadenado_trabajar_mudanza(&trabajadores[0]);
+
+	for(size_t i = 1; i < cantidad_hilos; i++){
+		if(creados[i])
+			pthread_join(hilos[i], NULL);
+	}
+
+	hash->migrados = hash->capacidad_vieja;
+
+	free(tramos);
+	free(trabajadores);
+	free(hilos);
+	free(creados);
+}
+
+// pre: hash es distinto de NULL
+// pos: si hay un rehash incremental en curso, da un paso acotado del mismo
+void encadenado_paso_migracion(hash_t* hash){
+
+	if(!hash->baldes_viejos)
+		return;
+
+	// Leer el reloj en cada paso encarece todas las operaciones mientras dura la
+	// mudanza, asi que los pasos solo se cronometran si la tabla mide latencias
+	if(!hash->instrumentacion){
+		encadenado_migrar(hash, BALDES_POR_PASO, VACIOS_POR_PASO);
+		return;
+	}
+
+	uint64_t inicio = hash_reloj_ns();
+	encadenado_migrar(hash, BALDES_POR_PASO, VACIOS_POR_PASO);
+	hash_sumar_tiempo_rehash(hash, inicio);
+}
+
+// pre: hash es distinto de NULL
+// pos: si hay una mudanza en curso, la termina (repartida entre hilos si se pidieron y quedan muchos baldes)
+void encadenado_completar_migracion(hash_t* hash){
+
+	if(!hash->baldes_viejos)
+		return;
+
+	uint64_t inicio = hash_reloj_ns();
+
+	if(hash->hilos_rehash > 1 && hash->capacidad_vieja - hash->migrados >= UMBRAL_REHASH_PARALELO)
+		encadenado_migrar_en_paralelo(hash);
+
+	encadenado_migrar(hash, hash->capacidad_vieja, hash->capacidad_vieja);
+	hash_sumar_tiempo_rehash(hash, inicio);
+}
+
+// pre: hash es distinto de NULL y nueva_capacidad es una potencia de 2 mayor a la capacidad actual
+// pos: agranda el arreglo de baldes a nueva_capacidad. Sin rehash incremental reubica todas las entradas; con rehash incremental solo empieza la mudanza. Devuelve 0 si pudo o -1 si no
+int encadenado_redimensionar(hash_t* hash, size_t nueva_capacidad){
+
+	encadenado_completar_migracion(hash);
+
+	entrada_t** nuevos = calloc(nueva_capacidad, sizeof(entrada_t*));
+	if(!nuevos)
+		return ERROR;
+
+	hash->baldes_viejos = hash->baldes;
+	hash->capacidad_vieja = hash->capacidad;
+	hash->migrados = 0;
+	hash->baldes = nuevos;
+	hash->capacidad = nueva_capacidad;
+	hash->rehashes++;
+
+	if(!hash->rehash_incremental)
+		encadenado_completar_migracion(hash);
+
+	return EXITO;
+}
+
+// pre: hash es distinto de NULL
+// pos: agranda el arreglo de baldes, si hace falta, para que guardar cantidad elementos no provoque ninguna redimension. Devuelve 0 si pudo o -1 si no
+int encadenado_reservar(hash_t* hash, size_t cantidad){
+
+	size_t nueva_capacidad = encadenado_capacidad_para(cantidad);
+	if(nueva_capacidad <= hash->capacidad)
+		return EXITO;
+
+	return encadenado_redimensionar(hash, nueva_capacidad);
+}
+
+// pre: hash, clave e insertado son distintos de NULL y valor_hash es el hash de la clave
+// pos: devuelve el lugar del elemento con dicha clave, insertandola con elemento NULL si no existia. Devuelve NULL si no pudo insertarla
+void** encadenado_buscar_o_insertar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash, bool* insertado){
+
+	encadenado_paso_migracion(hash);
+
+	entrada_t** enlace = encadenado_ubicar(hash, clave, largo, valor_hash);
+
+	if(*enlace){
+		*insertado = false;
+		return &(*enlace)->elemento;
+	}
+
+	entrada_t* entrada = hash_reservar_memoria(hash, encadenado_tamanio_entrada(largo));
+	if(!entrada)
+		return NULL;
+
+	// Si no hace falta agrandar la tabla, el enlace encontrado es el final de la
+	// cadena que le corresponde a la clave y se inserta ahi sin volver a recorrerla.
+	if(hash->cantidad_elementos + 1 > hash->capacidad){
+		if(encadenado_redimensionar(hash, hash->capacidad * 2) == ERROR){
+			hash_liberar_memoria(hash, entrada, encadenado_tamanio_entrada(largo));
+			return NULL;
+		}
+		enlace = &hash->baldes[valor_hash & (hash->capacidad - 1)];
+	}
+
+	entrada->hash = valor_hash;
+	entrada->elemento = NULL;
+	entrada->largo = largo;
+	memcpy(entrada->clave, clave, largo);
+	entrada->clave[largo] = '\0';
+	entrada->siguiente = *enlace;
+	*enlace = entrada;
+	hash->cantidad_elementos++;
+	*insertado = true;
+
+	return &entrada->elemento;
+}
+
+// pre: hash y clave son distintos de NULL y valor_hash es el hash de la clave
+// pos: quita el elemento e invoca al destructor. Devuelve 0 si pudo eliminarlo o -1 si no pudo.
+int encadenado_quitar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash){
+
+	encadenado_paso_migracion(hash);
+
+	entrada_t** enlace = encadenado_ubicar(hash, clave, largo, valor_hash);
+	entrada_t* entrada = *enlace;
+	if(!entrada)
+		return ERROR;
+
+	*enlace = entrada->siguiente;
+	encadenado_liberar_entrada(hash, entrada, true);
+	hash->cantidad_elementos--;
+
+	return EXITO;
+}
+
+// pre: hash y clave son distintos de NULL y valor_hash es el hash de la clave
+// pos: devuelve true si la clave esta, dejando su elemento en elemento si no es NULL
+bool encadenado_buscar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash, void** elemento){
+
+	encadenado_paso_migracion(hash);
+
+	entrada_t* entrada = *encadenado_ubicar(hash, clave, largo, valor_hash);
+	if(!entrada)
+		return false;
+
+	if(elemento)
+		*elemento = entrada->elemento;
+
+	return true;
+}
+
+// pre: hash es distinto de NULL
+// pos: libera todas las entradas y los baldes, invocando al destructor con cada elemento
+void encadenado_destruir(hash_t* hash){
+
+	// Las entradas se liberan junto con el slab
+	bool recorrer = hash->destructor || !hash->slab;
+
+	if(recorrer)
+		encadenado_completar_migracion(hash);
+	free(hash->baldes_viejos);
+
+	for(size_t i = 0; recorrer && i < hash->capacidad; i++){
+
+		entrada_t* entrada = hash->baldes[i];
+		while(entrada){
+			entrada_t* siguiente = entrada->siguiente;
+			encadenado_liberar_entrada(hash, entrada, true);
+			entrada = siguiente;
+		}
+	}
+
+	free(hash->baldes);
+}
+
+// pre: hash es distinto de NULL
+// pos: pide a cache el balde del arreglo actual que le corresponde a valor_hash
+void encadenado_anticipar_balde(const hash_t* hash, uint64_t valor_hash){
+
+	ANTICIPAR(&hash->baldes[valor_hash & (hash->capacidad - 1)]);
+}
+
+// pre: hash es distinto de NULL
+// pos: pide a cache la primera entrada del balde que le corresponde a valor_hash
+void encadenado_anticipar_elemento(const hash_t* hash, uint64_t valor_hash){
+
+	ANTICIPAR(hash->baldes[valor_hash & (hash->capacidad - 1)]);
+}
+
+// pre: hash es distinto de NULL
+// pos: devuelve la primera entrada de un balde no vacio a partir de desde, o NULL si no hay. Deja en desde el balde encontrado
+entrada_t* encadenado_proxima_cadena(hash_t* hash, size_t* desde){
+
+	while(*desde < hash->capacidad && !hash->baldes[*desde])
+		(*desde)++;
+
+	return *desde < hash->capacidad ? hash->baldes[*desde] : NULL;
+}
+
+// pre: cursor es distinto de NULL
+// pos: termina el rehash incremental en curso, para que el cursor solo tenga que recorrer los baldes de la tabla nueva
+void encadenado_cursor_iniciar(hash_cursor_t* cursor){
+
+	encadenado_completar_migracion(cursor->hash);
+}
+
+// pre: cursor, clave, largo y elemento son distintos de NULL
+// pos: devuelve la proxima entrada y avanza el cursor, o false si no habia mas. En posicion queda el balde de la entrada devuelta y en anterior la entrada que la precede en la cadena
+bool encadenado_cursor_siguiente(hash_cursor_t* cursor, const char** clave, size_t* largo, void** elemento){
+
+	hash_t* hash = cursor->hash;
+	if(cursor->posicion == hash->capacidad)
+		return false;
+
+	entrada_t* anterior = cursor->actual ? cursor->actual : cursor->anterior;
+	entrada_t* proxima = anterior ? anterior->siguiente : hash->baldes[cursor->posicion];
+
+	if(!proxima){
+		cursor->posicion++;
+		anterior = NULL;
+		proxima = encadenado_proxima_cadena(hash, &cursor->posicion);
+		if(!proxima){
+			cursor->anterior = cursor->actual = NULL;
+			return false;
+		}
+	}
+
+	cursor->anterior = anterior;
+	cursor->actual = proxima;
+
+	*clave = proxima->clave;
+	*largo = proxima->largo;
+	*elemento = proxima->elemento;
+	cursor->valor_hash = proxima->hash;
+
+	return true;
+}
+
+// pre: cursor es distinto de NULL y tiene un elemento actual
+// pos: desenlaza la entrada actual usando la anterior y la libera. Devuelve 0
+int encadenado_cursor_quitar(hash_cursor_t* cursor){
+
+	hash_t* hash = cursor->hash;
+	entrada_t* entrada = cursor->actual;
+	entrada_t* anterior = cursor->anterior;
+
+	if(anterior)
+		anterior->siguiente = entrada->siguiente;
+	else
+		hash->baldes[cursor->posicion] = entrada->siguiente;
+
+	encadenado_liberar_entrada(hash, entrada, true);
+	hash->cantidad_elementos--;
+	cursor->actual = NULL;
+
+	return EXITO;
+}
+
+// pre: estadisticas es distinto de NULL
+// pos: agrega a las estadisticas el largo de cada una de las cadenas y la memoria de sus entradas y claves
+void encadenado_contar_cadenas(entrada_t** baldes, size_t desde, size_t hasta, hash_estadisticas_t* estadisticas){
+
+	for(size_t i = desde; i < hasta; i++){
+
+		size_t largo = 0;
+		for(entrada_t* entrada = baldes[i]; entrada; entrada = entrada->siguiente){
+			largo++;
+			estadisticas->bytes_entradas += encadenado_tamanio_entrada(entrada->largo) - (entrada->largo + 1);
+			estadisticas->bytes_claves += entrada->largo + 1;
+		}
+
+		hash_contar_cadena(estadisticas, largo);
+	}
+}
+
+// pre: hash y estadisticas son distintos de NULL
+// pos: agrega a las estadisticas las cadenas del arreglo actual y, si hay un rehash incremental en curso, las que quedan por mudar del arreglo anterior
+void encadenado_estadisticas(hash_t* hash, hash_estadisticas_t* estadisticas){
+
+	estadisticas->bytes_baldes = (hash->capacidad + hash->capacidad_vieja) * sizeof(entrada_t*);
+
+	encadenado_contar_cadenas(hash->baldes, 0, hash->capacidad, estadisticas);
+	if(hash->baldes_viejos)
+		encadenado_contar_cadenas(hash->baldes_viejos, hash->migrados, hash->capacidad_vieja, estadisticas);
+}
+
+const hash_operaciones_t OPERACIONES_ENCADENADO = {
+	.crear = encadenado_crear,
+	.buscar_o_insertar = encadenado_buscar_o_insertar,
+	.quitar = encadenado_quitar,
+	.buscar = encadenado_buscar,
+	.reservar = encadenado_reservar,
+	.destruir = encadenado_destruir,
+	.anticipar_balde = encadenado_anticipar_balde,
+	.anticipar_elemento = encadenado_anticipar_elemento,
+	.cursor_iniciar = encadenado_cursor_iniciar,
+	.cursor_siguiente = encadenado_cursor_siguiente,
+	.cursor_quitar = encadenado_cursor_quitar,
+	.estadisticas = encadenado_estadisticas
+};
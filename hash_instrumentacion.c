@@ -0,0 +1,394 @@
+#define _DEFAULT_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "hash_interno.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+/*
+ * Histogramas de latencia al estilo HDR: los valores menores a
+ * SUBBALDES se cuentan exactos y cada potencia de 2 por encima se divide
+ * en SUBBALDES baldes iguales, asi que el error relativo de cualquier
+ * valor es menor a 1 / SUBBALDES con una cantidad fija de baldes.
+ * Cada tipo de operacion tiene su histograma y, si se usan contadores de
+ * hardware, la suma de lo que contaron sus operaciones medidas.
+ * Varios hilos pueden buscar a la vez en la misma tabla (por ejemplo en
+ * los fragmentos de hash_concurrente, con el candado de lectura), asi
+ * que el contador de operaciones y los histogramas son atomicos. Para
+ * informarlos se copian a un histograma_latencia_t comun.
+ */
+
+#define BITS_SUBBALDES 5
+#define SUBBALDES (1u << BITS_SUBBALDES)
+#define BALDES_LATENCIA ((64 - BITS_SUBBALDES + 1) * SUBBALDES)
+#define CANTIDAD_CONTADORES 3
+#define SIN_CONTADOR -1
+
+const char* NOMBRES_OPERACIONES[HASH_CANTIDAD_OPERACIONES] = {"obtener", "insertar", "quitar"};
+const char* NOMBRES_CONTADORES[CANTIDAD_CONTADORES] = {"ciclos", "fallos_cache", "fallos_salto"};
+
+typedef struct histograma_latencia{
+	uint64_t muestras;
+	uint64_t total_ns;
+	uint64_t maximo_ns;
+	uint64_t muestras_contadores;
+	uint64_t contadores[CANTIDAD_CONTADORES];
+	uint64_t baldes[BALDES_LATENCIA];
+}histograma_latencia_t;
+
+typedef struct histograma_compartido{
+	_Atomic uint64_t muestras;
+	_Atomic uint64_t total_ns;
+	_Atomic uint64_t maximo_ns;
+	_Atomic uint64_t muestras_contadores;
+	_Atomic uint64_t contadores[CANTIDAD_CONTADORES];
+	_Atomic uint64_t baldes[BALDES_LATENCIA];
+}histograma_compartido_t;
+
+struct instrumentacion{
+	size_t muestreo;
+	_Atomic uint64_t operaciones_vistas;
+	int contadores;
+	long hilo;
+	histograma_compartido_t operaciones[HASH_CANTIDAD_OPERACIONES];
+};
+
+// pre:
+// pos: devuelve el balde del histograma donde se cuenta valor
+size_t balde_de_latencia(uint64_t valor){
+
+	if(valor < SUBBALDES)
+		return (size_t)valor;
+
+#if defined(__GNUC__)
+	size_t exponente = 63 - (size_t)__builtin_clzll(valor);
+#else
+	size_t exponente = 0;
+	while(valor >> (exponente + 1))
+		exponente++;
+#endif
+
+	return (exponente - BITS_SUBBALDES + 1) * SUBBALDES + (size_t)((valor >> (exponente - BITS_SUBBALDES)) & (SUBBALDES - 1));
+}
+
+// pre: balde es menor a BALDES_LATENCIA
+// pos: devuelve el mayor valor que se cuenta en el balde
+uint64_t latencia_de_balde(size_t balde){
+
+	if(balde < SUBBALDES)
+		return balde;
+
+	size_t exponente = balde / SUBBALDES + BITS_SUBBALDES - 1;
+	uint64_t ancho = 1ull << (exponente - BITS_SUBBALDES);
+
+	return ((SUBBALDES + balde % SUBBALDES) << (exponente - BITS_SUBBALDES)) + ancho - 1;
+}
+
+#ifdef __linux__
+// pre:
+// pos: abre un contador del hilo actual que cuenta solo en modo usuario, dentro del grupo de lider (o como lider si es SIN_CONTADOR). Devuelve su descriptor o SIN_CONTADOR si no pudo
+int abrir_contador(uint32_t tipo, uint64_t evento, int lider){
+
+	struct perf_event_attr atributos;
+	memset(&atributos, 0, sizeof(atributos));
+	atributos.size = sizeof(atributos);
+	atributos.type = tipo;
+	atributos.config = evento;
+	atributos.disabled = lider == SIN_CONTADOR;
+	atributos.exclude_kernel = 1;
+	atributos.exclude_hv = 1;
+	atributos.read_format = PERF_FORMAT_GROUP;
+
+	long descriptor = syscall(SYS_perf_event_open, &atributos, 0, -1, lider, 0);
+
+	return descriptor < 0 ? SIN_CONTADOR : (int)descriptor;
+}
+
+// pre:
+// pos: abre el grupo de ciclos, fallos de cache y fallos de prediccion de saltos y lo pone a contar. Devuelve el descriptor del lider o SIN_CONTADOR si no pudo abrir alguno
+int abrir_contadores(){
+
+	int lider = abrir_contador(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, SIN_CONTADOR);
+	if(lider == SIN_CONTADOR)
+		return SIN_CONTADOR;
+
+	// Los miembros del grupo se cierran cuando se cierra el lider
+	if(abrir_contador(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, lider) == SIN_CONTADOR ||
+	   abrir_contador(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, lider) == SIN_CONTADOR ||
+	   ioctl(lider, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) == -1){
+		close(lider);
+		return SIN_CONTADOR;
+	}
+
+	return lider;
+}
+
+// pre: contadores fue abierto con abrir_contadores y valores tiene CANTIDAD_CONTADORES posiciones
+// pos: lee los contadores del grupo. Devuelve true si pudo
+bool leer_contadores(int contadores, uint64_t* valores){
+
+	uint64_t lectura[1 + CANTIDAD_CONTADORES];
+	if(read(contadores, lectura, sizeof(lectura)) != (ssize_t)sizeof(lectura) || lectura[0] != CANTIDAD_CONTADORES)
+		return false;
+
+	memcpy(valores, lectura + 1, sizeof(uint64_t) * CANTIDAD_CONTADORES);
+
+	return true;
+}
+
+// pre:
+// pos: devuelve el identificador del hilo actual
+long hilo_actual(){
+
+	return syscall(SYS_gettid);
+}
+#else
+int abrir_contadores(){
+
+	return SIN_CONTADOR;
+}
+
+bool leer_contadores(int contadores, uint64_t* valores){
+
+	(void)contadores;
+	(void)valores;
+
+	return false;
+}
+
+long hilo_actual(){
+
+	return 0;
+}
+#endif
+
+// pre: muestreo es mayor a 0
+// pos: devuelve la instrumentacion de una tabla que mide una de cada muestreo operaciones, o NULL si no hay memoria
+instrumentacion_t* instrumentacion_crear(size_t muestreo, bool contadores_hardware){
+
+	instrumentacion_t* instrumentacion = calloc(1, sizeof(instrumentacion_t));
+	if(!instrumentacion)
+		return NULL;
+
+	instrumentacion->muestreo = muestreo;
+	atomic_init(&instrumentacion->operaciones_vistas, 0);
+	instrumentacion->contadores = contadores_hardware ? abrir_contadores() : SIN_CONTADOR;
+	instrumentacion->hilo = hilo_actual();
+
+	return instrumentacion;
+}
+
+// pre:
+// pos: libera la instrumentacion y cierra sus contadores. Si es NULL no hace nada
+void instrumentacion_destruir(instrumentacion_t* instrumentacion){
+
+	if(!instrumentacion)
+		return;
+
+	if(instrumentacion->contadores != SIN_CONTADOR)
+		close(instrumentacion->contadores);
+
+	free(instrumentacion);
+}
+
+// pre: instrumentacion y muestra son distintos de NULL
+// pos: devuelve true si le toca medir a esta operacion, dejando en muestra el instante y los contadores de inicio
+bool instrumentacion_empezar(instrumentacion_t* instrumentacion, muestra_t* muestra){
+
+	uint64_t numero = atomic_fetch_add_explicit(&instrumentacion->operaciones_vistas, 1, memory_order_relaxed);
+	if(numero % instrumentacion->muestreo != 0)
+		return false;
+
+	// Los contadores se leen antes que el reloj para no medir su lectura
+	muestra->con_contadores = instrumentacion->contadores != SIN_CONTADOR && hilo_actual() == instrumentacion->hilo &&
+		leer_contadores(instrumentacion->contadores, muestra->contadores);
+	muestra->inicio = hash_reloj_ns();
+
+	return true;
+}
+
+// pre: muestra fue completada por instrumentacion_empezar, que devolvio true
+// pos: agrega la operacion medida al histograma de su tipo
+void instrumentacion_terminar(instrumentacion_t* instrumentacion, hash_operacion_t operacion, const muestra_t* muestra){
+
+	uint64_t latencia = hash_reloj_ns() - muestra->inicio;
+	histograma_compartido_t* histograma = &instrumentacion->operaciones[operacion];
+
+	uint64_t contadores[CANTIDAD_CONTADORES];
+	if(muestra->con_contadores && leer_contadores(instrumentacion->contadores, contadores)){
+		for(size_t i = 0; i < CANTIDAD_CONTADORES; i++)
+			atomic_fetch_add_explicit(&histograma->contadores[i], contadores[i] - muestra->contadores[i], memory_order_relaxed);
+		atomic_fetch_add_explicit(&histograma->muestras_contadores, 1, memory_order_relaxed);
+	}
+
+	atomic_fetch_add_explicit(&histograma->muestras, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&histograma->total_ns, latencia, memory_order_relaxed);
+	atomic_fetch_add_explicit(&histograma->baldes[balde_de_latencia(latencia)], 1, memory_order_relaxed);
+
+	uint64_t maximo = atomic_load_explicit(&histograma->maximo_ns, memory_order_relaxed);
+	while(latencia > maximo && !atomic_compare_exchange_weak_explicit(&histograma->maximo_ns, &maximo, latencia, memory_order_relaxed, memory_order_relaxed));
+}
+
+// pre: compartido y copia son distintos de NULL
+// pos: copia en copia los valores actuales del histograma compartido. Si otros hilos lo estan modificando, la copia puede mezclar operaciones anteriores y posteriores a la lectura
+void copiar_histograma(const histograma_compartido_t* compartido, histograma_latencia_t* copia){
+
+	histograma_compartido_t* origen = (histograma_compartido_t*)compartido;
+
+	copia->muestras = atomic_load_explicit(&origen->muestras, memory_order_relaxed);
+	copia->total_ns = atomic_load_explicit(&origen->total_ns, memory_order_relaxed);
+	copia->maximo_ns = atomic_load_explicit(&origen->maximo_ns, memory_order_relaxed);
+	copia->muestras_contadores = atomic_load_explicit(&origen->muestras_contadores, memory_order_relaxed);
+	for(size_t i = 0; i < CANTIDAD_CONTADORES; i++)
+		copia->contadores[i] = atomic_load_explicit(&origen->contadores[i], memory_order_relaxed);
+	for(size_t i = 0; i < BALDES_LATENCIA; i++)
+		copia->baldes[i] = atomic_load_explicit(&origen->baldes[i], memory_order_relaxed);
+}
+
+// pre: histograma es distinto de NULL y percentil esta entre 0 y 100
+// pos: devuelve la latencia del percentil o 0 si el histograma no tiene muestras
+uint64_t percentil_de_histograma(const histograma_latencia_t* histograma, double percentil){
+
+	if(histograma->muestras == 0)
+		return 0;
+
+	uint64_t objetivo = (uint64_t)(percentil / 100.0 * (double)histograma->muestras + 0.5);
+	if(objetivo == 0)
+		objetivo = 1;
+
+	uint64_t acumuladas = 0;
+	for(size_t i = 0; i < BALDES_LATENCIA; i++){
+		acumuladas += histograma->baldes[i];
+		if(acumuladas >= objetivo)
+			return latencia_de_balde(i) < histograma->maximo_ns ? latencia_de_balde(i) : histograma->maximo_ns;
+	}
+
+	return histograma->maximo_ns;
+}
+
+/*
+ * Devuelve la latencia en nanosegundos por debajo de la cual quedan el
+ * percentil por ciento (entre 0 y 100) de las operaciones medidas de
+ * ese tipo, con un error relativo menor al 4%.
+ * Devuelve 0 si la tabla no mide latencias o todavia no midio ninguna
+ * operacion de ese tipo.
+ */
+uint64_t hash_latencia_percentil(hash_t* hash, hash_operacion_t operacion, double percentil){
+
+	if(!hash || !hash->instrumentacion || operacion >= HASH_CANTIDAD_OPERACIONES || percentil < 0 || percentil > 100)
+		return 0;
+
+	histograma_latencia_t histograma;
+	copiar_histograma(&hash->instrumentacion->operaciones[operacion], &histograma);
+
+	return percentil_de_histograma(&histograma, percentil);
+}
+
+// pre: histograma es distinto de NULL
+// pos: devuelve el promedio del contador entre las operaciones medidas con contadores, o 0 si no hubo ninguna
+double promedio_contador(const histograma_latencia_t* histograma, size_t contador){
+
+	if(histograma->muestras_contadores == 0)
+		return 0;
+
+	return (double)histograma->contadores[contador] / (double)histograma->muestras_contadores;
+}
+
+// pre: hash y archivo son distintos de NULL y el hash mide latencias
+// pos: escribe una linea por operacion con sus muestras, media, percentiles, maximo y contadores promedio
+void exportar_texto(const hash_t* hash, FILE* archivo){
+
+	const instrumentacion_t* instrumentacion = hash->instrumentacion;
+
+	fprintf(archivo, "cantidad %zu capacidad %zu rehashes %zu nanosegundos_rehash %llu muestreo %zu contadores_hardware %s\n",
+		hash->cantidad_elementos, hash->capacidad, hash->rehashes, (unsigned long long)hash->nanosegundos_rehash,
+		instrumentacion->muestreo, instrumentacion->contadores != SIN_CONTADOR ? "si" : "no");
+	fprintf(archivo, "%-9s %10s %10s %8s %8s %8s %8s %10s", "operacion", "muestras", "media_ns", "p50_ns", "p90_ns", "p99_ns", "p999_ns", "maximo_ns");
+	for(size_t i = 0; i < CANTIDAD_CONTADORES; i++)
+		fprintf(archivo, " %12s", NOMBRES_CONTADORES[i]);
+	fprintf(archivo, "\n");
+
+	for(size_t i = 0; i < HASH_CANTIDAD_OPERACIONES; i++){
+
+		histograma_latencia_t copia;
+		copiar_histograma(&instrumentacion->operaciones[i], &copia);
+		const histograma_latencia_t* histograma = &copia;
+		double media = histograma->muestras ? (double)histograma->total_ns / (double)histograma->muestras : 0;
+
+		fprintf(archivo, "%-9s %10llu %10.1f %8llu %8llu %8llu %8llu %10llu", NOMBRES_OPERACIONES[i], (unsigned long long)histograma->muestras, media,
+			(unsigned long long)percentil_de_histograma(histograma, 50), (unsigned long long)percentil_de_histograma(histograma, 90),
+			(unsigned long long)percentil_de_histograma(histograma, 99), (unsigned long long)percentil_de_histograma(histograma, 99.9),
+			(unsigned long long)histograma->maximo_ns);
+		for(size_t j = 0; j < CANTIDAD_CONTADORES; j++)
+			fprintf(archivo, " %12.1f", promedio_contador(histograma, j));
+		fprintf(archivo, "\n");
+	}
+}
+
+// pre: hash y archivo son distintos de NULL y el hash mide latencias
+// pos: escribe un objeto JSON con los datos de la tabla y, por operacion, sus resumenes y los baldes no vacios del histograma como pares [latencia maxima del balde, cantidad]
+void exportar_json(const hash_t* hash, FILE* archivo){
+
+	const instrumentacion_t* instrumentacion = hash->instrumentacion;
+
+	fprintf(archivo, "{\"cantidad\":%zu,\"capacidad\":%zu,\"rehashes\":%zu,\"nanosegundos_rehash\":%llu,\"muestreo\":%zu,\"contadores_hardware\":%s,\"operaciones\":{",
+		hash->cantidad_elementos, hash->capacidad, hash->rehashes, (unsigned long long)hash->nanosegundos_rehash,
+		instrumentacion->muestreo, instrumentacion->contadores != SIN_CONTADOR ? "true" : "false");
+
+	for(size_t i = 0; i < HASH_CANTIDAD_OPERACIONES; i++){
+
+		histograma_latencia_t copia;
+		copiar_histograma(&instrumentacion->operaciones[i], &copia);
+		const histograma_latencia_t* histograma = &copia;
+		double media = histograma->muestras ? (double)histograma->total_ns / (double)histograma->muestras : 0;
+
+		fprintf(archivo, "%s\"%s\":{\"muestras\":%llu,\"media_ns\":%.1f,\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"maximo_ns\":%llu",
+			i ? "," : "", NOMBRES_OPERACIONES[i], (unsigned long long)histograma->muestras, media,
+			(unsigned long long)percentil_de_histograma(histograma, 50), (unsigned long long)percentil_de_histograma(histograma, 90),
+			(unsigned long long)percentil_de_histograma(histograma, 99), (unsigned long long)percentil_de_histograma(histograma, 99.9),
+			(unsigned long long)histograma->maximo_ns);
+		for(size_t j = 0; j < CANTIDAD_CONTADORES; j++)
+			fprintf(archivo, ",\"%s\":%.1f", NOMBRES_CONTADORES[j], promedio_contador(histograma, j));
+
+		fprintf(archivo, ",\"histograma\":[");
+		bool primero = true;
+		for(size_t j = 0; j < BALDES_LATENCIA; j++){
+			if(!histograma->baldes[j])
+				continue;
+			fprintf(archivo, "%s[%llu,%llu]", primero ? "" : ",", (unsigned long long)latencia_de_balde(j), (unsigned long long)histograma->baldes[j]);
+			primero = false;
+		}
+		fprintf(archivo, "]}");
+	}
+
+	fprintf(archivo, "}}\n");
+}
+
+/*
+ * Escribe en archivo las latencias medidas, como texto con una linea por
+ * operacion o como un objeto JSON que ademas incluye el histograma
+ * completo de cada operacion. Ambos formatos incluyen la cantidad de
+ * muestras, la media, los percentiles 50, 90, 99 y 99.9 y el maximo, el
+ * promedio de los contadores de hardware si se usan, y la cantidad,
+ * capacidad y rehashes de la tabla.
+ * Devuelve 0 si pudo o -1 si la tabla no mide latencias o no pudo
+ * escribir.
+ */
+int hash_exportar_latencias(hash_t* hash, FILE* archivo, hash_formato_exportacion_t formato){
+
+	if(!hash || !hash->instrumentacion || !archivo)
+		return ERROR;
+
+	if(formato == HASH_EXPORTAR_JSON)
+		exportar_json(hash, archivo);
+	else
+		exportar_texto(hash, archivo);
+
+	return ferror(archivo) ? ERROR : EXITO;
+}
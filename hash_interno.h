@@ -0,0 +1,216 @@
+#ifndef __HASH_INTERNO_H__
+#define __HASH_INTERNO_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "hash.h"
+#include "hash_iterador.h"
+#include "lista.h"
+#include "slab.h"
+
+#define SIN_ELEMENTOS 0
+#define ERROR -1
+#define EXITO 0
+
+/* Pide al procesador que traiga a cache la direccion sin esperarla. */
+#if defined(__GNUC__)
+#define ANTICIPAR(direccion) __builtin_prefetch(direccion)
+#else
+#define ANTICIPAR(direccion) ((void)(direccion))
+#endif
+
+/*
+ * Operaciones que implementa cada motor de almacenamiento. Las
+ * funciones publicas de hash.c validan los parametros, calculan el hash
+ * de la clave y delegan en estas operaciones.
+ * anticipar_balde y anticipar_elemento solo piden a cache lo que
+ * leeria una busqueda de ese hash (primero el balde y despues, ya con
+ * el balde en cache, su primer elemento); las usan las funciones de
+ * lote para superponer las esperas a memoria de varias claves.
+ * cursor_iniciar recibe el cursor con posicion 0, anterior y actual en
+ * NULL, y cursor_siguiente lo avanza con un ciclo, sin reservar memoria
+ * ni volver a recorrer los baldes ya vistos. cursor_quitar solo se
+ * llama si el cursor tiene un elemento actual, y lo quita sin buscarlo.
+ * Las tablas de solo lectura devuelven error en las operaciones que
+ * modifican la tabla.
+ * estadisticas recibe los campos generales ya completos y agrega los de
+ * los baldes y la memoria; en sondeo_medio deja la suma de los sondeos
+ * de todos los elementos, que hash_estadisticas divide por la cantidad.
+ * Las redimensiones incrementan rehashes y suman su duracion a
+ * nanosegundos_rehash.
+ */
+typedef struct hash_operaciones{
+	bool (*crear)(hash_t* hash, size_t capacidad);
+	void** (*buscar_o_insertar)(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash, bool* insertado);
+	int (*quitar)(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash);
+	bool (*buscar)(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash, void** elemento);
+	int (*reservar)(hash_t* hash, size_t cantidad);
+	void (*destruir)(hash_t* hash);
+	void (*anticipar_balde)(const hash_t* hash, uint64_t valor_hash);
+	void (*anticipar_elemento)(const hash_t* hash, uint64_t valor_hash);
+	void (*cursor_iniciar)(hash_cursor_t* cursor);
+	bool (*cursor_siguiente)(hash_cursor_t* cursor, const char** clave, size_t* largo, void** elemento);
+	int (*cursor_quitar)(hash_cursor_t* cursor);
+	void (*estadisticas)(hash_t* hash, hash_estadisticas_t* estadisticas);
+}hash_operaciones_t;
+
+/* Ranura de la tabla de direccionamiento abierto. */
+typedef struct ranura{
+	uint64_t hash;
+	char* clave;
+	size_t largo;
+	void* elemento;
+}ranura_t;
+
+/* Bloque de la arena donde hash_cargar_archivo copia los elementos. */
+typedef struct bloque_arena{
+	struct bloque_arena* siguiente;
+	size_t usado;
+	size_t tamanio;
+	char datos[];
+}bloque_arena_t;
+
+/* Elemento del motor encadenado, reservado de una vez junto con su clave. */
+typedef struct entrada{
+	struct entrada* siguiente;
+	uint64_t hash;
+	size_t largo;
+	void* elemento;
+	char clave[];
+}entrada_t;
+
+/* Latencias y contadores que mide una tabla creada con muestreo_latencia. */
+typedef struct instrumentacion instrumentacion_t;
+
+/* Lo que se lee al empezar una operacion medida. */
+typedef struct muestra{
+	uint64_t inicio;
+	uint64_t contadores[3];
+	bool con_contadores;
+}muestra_t;
+
+struct hash{
+	const hash_operaciones_t* operaciones;
+	hash_funcion_t funcion;
+	uint64_t semilla;
+	hash_destruir_dato_t destructor;
+	slab_t* slab;
+	bloque_arena_t* arena;
+	instrumentacion_t* instrumentacion;
+	bool rehash_incremental;
+	size_t hilos_rehash;
+	size_t cantidad_elementos;
+	size_t capacidad;
+	size_t factor_carga;
+	size_t rehashes;
+	uint64_t nanosegundos_rehash;
+	union{
+		/* HASH_MOTOR_LISTAS */
+		lista_t** index;
+		/* HASH_MOTOR_ABIERTO */
+		struct{
+			uint8_t* control;
+			ranura_t* ranuras;
+			size_t borrados;
+		};
+		/* HASH_MOTOR_ENCADENADO */
+		struct{
+			entrada_t** baldes;
+			/* Mientras dura un rehash incremental, baldes de la tabla anterior
+			 * que todavia no se terminaron de mudar a partir de migrados. */
+			entrada_t** baldes_viejos;
+			size_t capacidad_vieja;
+			size_t migrados;
+		};
+		/* Snapshot abierto con hash_abrir_snapshot */
+		struct{
+			const uint8_t* mapa;
+			size_t tamanio_mapa;
+			const uint64_t* inicios;
+		};
+	};
+};
+
+struct hash_iter{
+	hash_cursor_t cursor;
+};
+
+extern const hash_operaciones_t OPERACIONES_LISTAS;
+extern const hash_operaciones_t OPERACIONES_ABIERTO;
+extern const hash_operaciones_t OPERACIONES_ENCADENADO;
+extern const hash_operaciones_t OPERACIONES_SNAPSHOT;
+
+// pre: operaciones es distinto de NULL
+// pos: reserva un hash con esas operaciones, funcion, semilla, capacidad y destructor, sin slab, arena ni instrumentacion y con los demas campos en cero. La memoria propia del motor todavia no se reserva. Devuelve NULL si no hay memoria
+hash_t* hash_nuevo(const hash_operaciones_t* operaciones, hash_funcion_t funcion, uint64_t semilla, size_t capacidad, hash_destruir_dato_t destructor);
+
+// pre: hash es distinto de NULL
+// pos: reserva tamanio bytes del slab del hash, o con malloc si no usa slab
+void* hash_reservar_memoria(hash_t* hash, size_t tamanio);
+
+// pre: hash es distinto de NULL y bloque fue reservado con hash_reservar_memoria con el mismo tamanio
+// pos: libera el bloque
+void hash_liberar_memoria(hash_t* hash, void* bloque, size_t tamanio);
+
+// pre: hash y clave son distintos de NULL
+// pos: devuelve una copia de los largo bytes de clave, seguida de un '\0', reservada con hash_reservar_memoria o NULL si no hay memoria
+char* hash_copiar_clave(hash_t* hash, const void* clave, size_t largo);
+
+// pre: hash es distinto de NULL y clave fue copiada con hash_copiar_clave con el mismo largo
+// pos: libera la copia de la clave
+void hash_liberar_clave(hash_t* hash, char* clave, size_t largo);
+
+// pre:
+// pos: devuelve una semilla impredecible para una tabla nueva
+uint64_t semilla_aleatoria();
+
+// pre: clave apunta a al menos largo bytes
+// pos: devuelve el SipHash-2-4 de la clave con la clave secreta de 128 bits formada por k0 (bytes 0 a 7) y k1 (bytes 8 a 15)
+uint64_t siphash_2_4(const void* clave, size_t largo, uint64_t k0, uint64_t k1);
+
+// pre: mascara es distinto de 0
+// pos: devuelve la posicion del bit encendido menos significativo
+size_t primer_bit(uint32_t mascara);
+
+// pre: hash es distinto de NULL
+// pos: libera todos los bloques de la arena del hash
+void hash_liberar_arena(hash_t* hash);
+
+// pre:
+// pos: devuelve la cantidad de bytes que ocupa una entrada del motor encadenado con una clave de largo bytes
+size_t encadenado_tamanio_entrada(size_t largo);
+
+// pre:
+// pos: devuelve un instante en nanosegundos de un reloj monotono
+uint64_t hash_reloj_ns();
+
+// pre: hash es distinto de NULL e inicio fue devuelto por hash_reloj_ns
+// pos: suma el tiempo transcurrido desde inicio al tiempo de rehash del hash
+void hash_sumar_tiempo_rehash(hash_t* hash, uint64_t inicio);
+
+// pre: estadisticas es distinto de NULL
+// pos: agrega a las estadisticas un balde con largo elementos, que una busqueda exitosa recorre en orden
+void hash_contar_cadena(hash_estadisticas_t* estadisticas, size_t largo);
+
+// pre: ruta es distinto de NULL
+// pos: lleva a disco el directorio que contiene ruta, para que sobrevivan a un corte de luz los archivos creados o renombrados en el. Devuelve 0 si pudo o -1 si no
+int sincronizar_directorio(const char* ruta);
+
+// pre: muestreo es mayor a 0
+// pos: devuelve la instrumentacion de una tabla que mide una de cada muestreo operaciones, o NULL si no hay memoria
+instrumentacion_t* instrumentacion_crear(size_t muestreo, bool contadores_hardware);
+
+// pre:
+// pos: libera la instrumentacion y cierra sus contadores. Si es NULL no hace nada
+void instrumentacion_destruir(instrumentacion_t* instrumentacion);
+
+// pre: instrumentacion y muestra son distintos de NULL
+// pos: devuelve true si le toca medir a esta operacion, dejando en muestra el instante y los contadores de inicio
+bool instrumentacion_empezar(instrumentacion_t* instrumentacion, muestra_t* muestra);
+
+// pre: muestra fue completada por instrumentacion_empezar, que devolvio true
+// pos: agrega la operacion medida al histograma de su tipo
+void instrumentacion_terminar(instrumentacion_t* instrumentacion, hash_operacion_t operacion, const muestra_t* muestra);
+
+#endif /* __HASH_INTERNO_H__ */
@@ -2,16 +2,32 @@
 #define _HASH_ITERADOR_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include "hash.h"
 
 /* Iterador externo para el HASH */
 typedef struct hash_iter hash_iterador_t;
 
+/*
+ * Cursor para recorrer el HASH sin reservar memoria. Sus campos son
+ * privados: solo se usa con las funciones hash_cursor_*.
+ */
+typedef struct hash_cursor{
+	hash_t* hash;
+	size_t posicion;
+	void* anterior;
+	void* actual;
+	uint64_t valor_hash;
+}hash_cursor_t;
+
 /*
  * Crea un iterador de claves para el hash reservando la memoria
  * necesaria para el mismo. El iterador creado es válido desde su
  * creación hasta que se modifique la tabla de hash (insertando o
- * removiendo elementos);
+ * removiendo elementos), salvo que se quiten con
+ * hash_iterador_quitar_actual;
+ * Si la tabla tiene un rehash incremental en curso, crear el iterador
+ * lo termina.
  *
  * Devuelve el puntero al iterador creado o NULL en caso de error.
  */
@@ -29,10 +45,48 @@ void* hash_iterador_siguiente(hash_iterador_t* iterador);
  */
 bool hash_iterador_tiene_siguiente(hash_iterador_t* iterador);
 
+/*
+ * Quita del hash la ultima clave devuelta por hash_iterador_siguiente,
+ * invocando al destructor con su elemento, sin volver a buscarla. La
+ * clave devuelta deja de ser valida y el iterador continua por la
+ * siguiente.
+ * Devuelve 0 si pudo quitarla o -1 si no habia clave para quitar.
+ */
+int hash_iterador_quitar_actual(hash_iterador_t* iterador);
+
 /*
  * Destruye el iterador del hash.
  */
 void hash_iterador_destruir(hash_iterador_t* iterador);
 
+/*
+ * Inicia un cursor para recorrer el hash. El cursor no reserva memoria:
+ * se declara donde se lo use (por ejemplo en la pila) y no hace falta
+ * destruirlo. Es valido mientras no se modifique la tabla, salvo con
+ * hash_cursor_quitar. Recorrer toda la tabla cuesta
+ * O(capacidad + cantidad de elementos).
+ * Si la tabla tiene un rehash incremental en curso, iniciar el cursor
+ * lo termina.
+ *
+ * Devuelve false si el cursor o el hash son NULL.
+ */
+bool hash_cursor_iniciar(hash_cursor_t* cursor, hash_t* hash);
+
+/*
+ * Avanza el cursor al proximo elemento del hash y devuelve su clave, el
+ * largo de la clave y el elemento en clave, largo y elemento (cualquiera
+ * de ellos puede ser NULL si no interesa).
+ * Devuelve false si no habia mas elementos.
+ */
+bool hash_cursor_siguiente(hash_cursor_t* cursor, const char** clave, size_t* largo, void** elemento);
+
+/*
+ * Quita del hash el ultimo elemento devuelto por hash_cursor_siguiente
+ * en O(1), invocando al destructor con el elemento. La clave devuelta
+ * deja de ser valida y el cursor continua por el elemento siguiente.
+ * Devuelve 0 si pudo quitarlo o -1 si no habia elemento para quitar.
+ */
+int hash_cursor_quitar(hash_cursor_t* cursor);
+
 
 #endif /* _HASH_ITERADOR_H_ */
\ No newline at end of file
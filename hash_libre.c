@@ -0,0 +1,596 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "hash_libre.h"
+#include "hash_interno.h"
+#include "epoca.h"
+
+/*
+ * La lista esta ordenada por orden = bits del hash invertidos. Un
+ * centinela del balde b tiene orden invertir(b) (bit bajo en 0) y un
+ * elemento tiene invertir(hash) con el bit bajo en 1, de modo que cada
+ * elemento queda despues del centinela de su balde y antes del
+ * centinela del siguiente balde de la lista, con cualquier cantidad de
+ * baldes. Al duplicarse la cantidad, el balde b + capacidad parte en
+ * dos la porcion del balde b sin mover ningun nodo.
+ *
+ * El bit bajo del enlace siguiente de un nodo marca que el nodo fue
+ * quitado (algoritmo de Harris y Michael): primero se marca y despues
+ * se desengancha, y el hilo que logra desengancharlo lo retira.
+ *
+ * Los baldes viven en segmentos que se reservan a medida que se usan:
+ * el segmento 0 tiene los primeros BALDES_SEGMENTO_CERO baldes y cada
+ * segmento siguiente tantos baldes como todos los anteriores juntos.
+ */
+
+#define MARCA ((uintptr_t)1)
+#define BITS_SEGMENTO_CERO 3
+#define BALDES_SEGMENTO_CERO ((size_t)1 << BITS_SEGMENTO_CERO)
+#define CANTIDAD_SEGMENTOS (64 - BITS_SEGMENTO_CERO)
+#define CARGA_MAXIMA 2
+#define CANTIDAD_FRANJAS 64
+#define INSERCIONES_POR_CONTROL 64
+#define LINEA_CACHE 64
+
+typedef struct nodo_libre{
+	_Atomic uintptr_t siguiente;
+	uint64_t orden;
+	uint64_t hash;
+	_Atomic(void*) elemento;
+	size_t largo;
+	hash_destruir_dato_t destructor;
+	epoca_retiro_t retiro;
+	char clave[];
+}nodo_libre_t;
+
+/* Elemento reemplazado que espera para ser destruido. */
+typedef struct elemento_retirado{
+	epoca_retiro_t retiro;
+	void* elemento;
+	hash_destruir_dato_t destructor;
+}elemento_retirado_t;
+
+/*
+ * La cantidad de elementos se cuenta repartida en franjas, cada una en
+ * su propia linea de cache, para que los hilos no compitan por un unico
+ * contador.
+ */
+typedef struct franja{
+	_Alignas(LINEA_CACHE) _Atomic long cantidad;
+}franja_t;
+
+struct hash_libre{
+	_Atomic(_Atomic(nodo_libre_t*)*) segmentos[CANTIDAD_SEGMENTOS];
+	_Atomic size_t capacidad;
+	uint64_t semilla;
+	hash_destruir_dato_t destructor;
+	epoca_t* epoca;
+	franja_t* franjas;
+	_Atomic size_t proxima_franja;
+};
+
+struct hash_libre_hilo{
+	hash_libre_t* hash;
+	epoca_hilo_t* epoca;
+	franja_t* franja;
+	size_t inserciones;
+};
+
+// pre:
+// pos: devuelve valor con el orden de sus 64 bits invertido
+uint64_t invertir_bits(uint64_t valor){
+
+	valor = ((valor >> 1) & 0x5555555555555555ULL) | ((valor & 0x5555555555555555ULL) << 1);
+	valor = ((valor >> 2) & 0x3333333333333333ULL) | ((valor & 0x3333333333333333ULL) << 2);
+	valor = ((valor >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((valor & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	valor = ((valor >> 8) & 0x00FF00FF00FF00FFULL) | ((valor & 0x00FF00FF00FF00FFULL) << 8);
+	valor = ((valor >> 16) & 0x0000FFFF0000FFFFULL) | ((valor & 0x0000FFFF0000FFFFULL) << 16);
+
+	return (valor >> 32) | (valor << 32);
+}
+
+// pre: valor es distinto de 0
+// pos: devuelve la posicion del bit encendido mas significativo
+size_t bit_mas_alto(size_t valor){
+
+	size_t posicion = 0;
+	while(valor >>= 1)
+		posicion++;
+
+	return posicion;
+}
+
+// pre: clave es distinto de NULL si largo es mayor a 0
+// pos: devuelve un nodo sin enlazar con una copia de la clave, o NULL si no hay memoria
+nodo_libre_t* libre_crear_nodo(uint64_t orden, uint64_t valor_hash, const char* clave, size_t largo, void* elemento){
+
+	nodo_libre_t* nodo = malloc(sizeof(nodo_libre_t) + largo + 1);
+	if(!nodo)
+		return NULL;
+
+	atomic_init(&nodo->siguiente, 0);
+	atomic_init(&nodo->elemento, elemento);
+	nodo->orden = orden;
+	nodo->hash = valor_hash;
+	nodo->largo = largo;
+	nodo->destructor = NULL;
+	if(largo > 0)
+		memcpy(nodo->clave, clave, largo);
+	nodo->clave[largo] = '\0';
+
+	return nodo;
+}
+
+// pre: retiro es el encabezado de un nodo_libre_t
+// pos: invoca al destructor guardado en el nodo (si hay) con su elemento y libera el nodo
+void libre_liberar_nodo(epoca_retiro_t* retiro){
+
+	nodo_libre_t* nodo = (nodo_libre_t*)((char*)retiro - offsetof(nodo_libre_t, retiro));
+
+	if(nodo->destructor)
+		nodo->destructor(atomic_load_explicit(&nodo->elemento, memory_order_relaxed));
+
+	free(nodo);
+}
+
+// pre: retiro es el encabezado de un elemento_retirado_t
+// pos: destruye el elemento y libera el encabezado
+void libre_liberar_elemento(epoca_retiro_t* retiro){
+
+	elemento_retirado_t* retirado = (elemento_retirado_t*)retiro;
+
+	retirado->destructor(retirado->elemento);
+	free(retirado);
+}
+
+// pre: nodo es distinto de NULL
+// pos: devuelve un valor negativo, 0 o positivo segun el nodo vaya antes, en el mismo lugar o despues que la clave dada en la lista
+int libre_comparar(const nodo_libre_t* nodo, uint64_t orden, uint64_t valor_hash, const char* clave, size_t largo){
+
+	if(nodo->orden != orden)
+		return nodo->orden < orden ? -1 : 1;
+
+	// Dos centinelas con el mismo orden son el mismo balde
+	if(!(orden & 1))
+		return 0;
+
+	if(nodo->hash != valor_hash)
+		return nodo->hash < valor_hash ? -1 : 1;
+
+	if(nodo->largo != largo)
+		return nodo->largo < largo ? -1 : 1;
+
+	return memcmp(nodo->clave, clave, largo);
+}
+
+// pre: hilo y inicio son distintos de NULL y el hilo esta dentro de una seccion de lectura
+// pos: recorre la lista desde inicio desenganchando los nodos marcados. Deja en anterior el enlace que apunta al primer nodo que no va antes de la clave y en actual ese nodo (o NULL). Devuelve true si ese nodo tiene la clave
+bool libre_buscar(hash_libre_hilo_t* hilo, _Atomic uintptr_t* inicio, uint64_t orden, uint64_t valor_hash, const char* clave, size_t largo, _Atomic uintptr_t** anterior, nodo_libre_t** actual){
+
+	while(true){
+
+		_Atomic uintptr_t* enlace = inicio;
+		nodo_libre_t* nodo = (nodo_libre_t*)atomic_load_explicit(enlace, memory_order_acquire);
+		bool reintentar = false;
+
+		while(nodo && !reintentar){
+
+			uintptr_t siguiente = atomic_load_explicit(&nodo->siguiente, memory_order_acquire);
+
+			// Si el enlace anterior cambio, el nodo pudo haber sido quitado
+			if(atomic_load_explicit(enlace, memory_order_acquire) != (uintptr_t)nodo){
+				reintentar = true;
+				continue;
+			}
+
+			if(siguiente & MARCA){
+				uintptr_t esperado = (uintptr_t)nodo;
+				if(atomic_compare_exchange_strong_explicit(enlace, &esperado, siguiente & ~MARCA, memory_order_acq_rel, memory_order_acquire))
+					epoca_retirar(hilo->epoca, &nodo->retiro, libre_liberar_nodo);
+				else
+					reintentar = true;
+				nodo = (nodo_libre_t*)(siguiente & ~MARCA);
+				continue;
+			}
+
+			int comparacion = libre_comparar(nodo, orden, valor_hash, clave, largo);
+			if(comparacion >= 0){
+				*anterior = enlace;
+				*actual = nodo;
+				return comparacion == 0;
+			}
+
+			enlace = &nodo->siguiente;
+			nodo = (nodo_libre_t*)siguiente;
+		}
+
+		if(!reintentar){
+			*anterior = enlace;
+			*actual = NULL;
+			return false;
+		}
+	}
+}
+
+// pre: hilo e inicio son distintos de NULL, nuevo no esta enlazado y el hilo esta dentro de una seccion de lectura
+// pos: enlaza nuevo en su lugar de la lista si no habia un nodo igual. Devuelve el nodo que quedo en la lista con esa clave (nuevo o el que ya estaba)
+nodo_libre_t* libre_enlazar(hash_libre_hilo_t* hilo, _Atomic uintptr_t* inicio, nodo_libre_t* nuevo){
+
+	_Atomic uintptr_t* anterior;
+	nodo_libre_t* actual;
+
+	while(true){
+
+		if(libre_buscar(hilo, inicio, nuevo->orden, nuevo->hash, nuevo->clave, nuevo->largo, &anterior, &actual))
+			return actual;
+
+		atomic_store_explicit(&nuevo->siguiente, (uintptr_t)actual, memory_order_relaxed);
+		uintptr_t esperado = (uintptr_t)actual;
+		if(atomic_compare_exchange_strong_explicit(anterior, &esperado, (uintptr_t)nuevo, memory_order_release, memory_order_relaxed))
+			return nuevo;
+	}
+}
+
+// pre: hash es distinto de NULL
+// pos: devuelve el lugar del arreglo de baldes donde se guarda el centinela del balde, reservando su segmento si hace falta, o NULL si no hay memoria
+_Atomic(nodo_libre_t*)* libre_lugar_balde(hash_libre_t* hash, size_t balde){
+
+	size_t segmento = 0;
+	size_t posicion = balde;
+	size_t tamanio = BALDES_SEGMENTO_CERO;
+
+	if(balde >= BALDES_SEGMENTO_CERO){
+		size_t bit = bit_mas_alto(balde);
+		segmento = bit - BITS_SEGMENTO_CERO + 1;
+		tamanio = (size_t)1 << bit;
+		posicion = balde - tamanio;
+	}
+
+	_Atomic(nodo_libre_t*)* baldes = atomic_load_explicit(&hash->segmentos[segmento], memory_order_acquire);
+	if(!baldes){
+		_Atomic(nodo_libre_t*)* nuevos = calloc(tamanio, sizeof(_Atomic(nodo_libre_t*)));
+		if(!nuevos)
+			return NULL;
+		if(atomic_compare_exchange_strong_explicit(&hash->segmentos[segmento], &baldes, nuevos, memory_order_acq_rel, memory_order_acquire))
+			baldes = nuevos;
+		else
+			free(nuevos);
+	}
+
+	return &baldes[posicion];
+}
+
+// pre: hilo es distinto de NULL y el hilo esta dentro de una seccion de lectura
+// pos: devuelve el centinela del balde, inicializandolo (y a su balde padre) si es la primera vez que se usa, o NULL si no hay memoria
+nodo_libre_t* libre_centinela(hash_libre_hilo_t* hilo, size_t balde){
+
+	_Atomic(nodo_libre_t*)* lugar = libre_lugar_balde(hilo->hash, balde);
+	if(!lugar)
+		return NULL;
+
+	nodo_libre_t* centinela = atomic_load_explicit(lugar, memory_order_acquire);
+	if(centinela)
+		return centinela;
+
+	// El padre es el balde que se partio para crear este
+	nodo_libre_t* padre = libre_centinela(hilo, balde & ~((size_t)1 << bit_mas_alto(balde)));
+	if(!padre)
+		return NULL;
+
+	nodo_libre_t* nuevo = libre_crear_nodo(invertir_bits(balde), 0, NULL, 0, NULL);
+	if(!nuevo)
+		return NULL;
+
+	centinela = libre_enlazar(hilo, &padre->siguiente, nuevo);
+	if(centinela != nuevo)
+		free(nuevo);
+
+	atomic_store_explicit(lugar, centinela, memory_order_release);
+
+	return centinela;
+}
+
+/*
+ * Crea el hash igual que hash_crear.
+ * Devuelve un puntero al hash creado o NULL en caso de no poder crearlo.
+ */
+hash_libre_t* hash_libre_crear(hash_destruir_dato_t destruir_elemento, size_t capacidad){
+
+	hash_libre_t* hash = malloc(sizeof(hash_libre_t));
+	if(!hash)
+		return NULL;
+
+	for(size_t i = 0; i < CANTIDAD_SEGMENTOS; i++)
+		atomic_init(&hash->segmentos[i], NULL);
+
+	size_t capacidad_inicial = BALDES_SEGMENTO_CERO;
+	while(capacidad_inicial * CARGA_MAXIMA < capacidad)
+		capacidad_inicial *= 2;
+
+	atomic_init(&hash->capacidad, capacidad_inicial);
+	atomic_init(&hash->proxima_franja, 0);
+	hash->semilla = semilla_aleatoria();
+	hash->destructor = destruir_elemento;
+	hash->epoca = epoca_crear();
+	hash->franjas = aligned_alloc(LINEA_CACHE, CANTIDAD_FRANJAS * sizeof(franja_t));
+
+	_Atomic(nodo_libre_t*)* lugar_cero = libre_lugar_balde(hash, 0);
+	nodo_libre_t* cabeza = libre_crear_nodo(0, 0, NULL, 0, NULL);
+
+	if(!hash->epoca || !hash->franjas || !lugar_cero || !cabeza){
+		free(cabeza);
+		free(atomic_load(&hash->segmentos[0]));
+		free(hash->franjas);
+		epoca_destruir(hash->epoca);
+		free(hash);
+		return NULL;
+	}
+
+	for(size_t i = 0; i < CANTIDAD_FRANJAS; i++)
+		atomic_init(&hash->franjas[i].cantidad, 0);
+
+	// El centinela del balde 0 es la cabeza de toda la lista
+	atomic_init(lugar_cero, cabeza);
+
+	return hash;
+}
+
+/*
+ * Registra al hilo que la llama. El registro devuelto solo puede
+ * usarlo ese hilo.
+ * Devuelve el registro o NULL en caso de error.
+ */
+hash_libre_hilo_t* hash_libre_registrar_hilo(hash_libre_t* hash){
+
+	if(!hash)
+		return NULL;
+
+	hash_libre_hilo_t* hilo = malloc(sizeof(hash_libre_hilo_t));
+	if(!hilo)
+		return NULL;
+
+	hilo->hash = hash;
+	hilo->epoca = epoca_registrar(hash->epoca);
+	hilo->franja = &hash->franjas[atomic_fetch_add(&hash->proxima_franja, 1) % CANTIDAD_FRANJAS];
+	hilo->inserciones = 0;
+
+	if(!hilo->epoca){
+		free(hilo);
+		return NULL;
+	}
+
+	return hilo;
+}
+
+/*
+ * Da de baja el registro del hilo.
+ */
+void hash_libre_desregistrar_hilo(hash_libre_hilo_t* hilo){
+
+	if(!hilo)
+		return;
+
+	epoca_desregistrar(hilo->epoca);
+	free(hilo);
+}
+
+// pre: hilo es distinto de NULL
+// pos: suma diferencia a la cantidad de elementos en la franja del hilo
+void libre_contar(hash_libre_hilo_t* hilo, long diferencia){
+
+	atomic_fetch_add_explicit(&hilo->franja->cantidad, diferencia, memory_order_relaxed);
+}
+
+// pre: hilo es distinto de NULL
+// pos: cada tanto compara la cantidad de elementos con la de baldes y, si se supera la carga maxima, duplica la cantidad de baldes en uso
+void libre_controlar_carga(hash_libre_hilo_t* hilo){
+
+	if(++hilo->inserciones % INSERCIONES_POR_CONTROL != 0)
+		return;
+
+	size_t capacidad = atomic_load_explicit(&hilo->hash->capacidad, memory_order_relaxed);
+	if(capacidad >= ((size_t)1 << (CANTIDAD_SEGMENTOS + BITS_SEGMENTO_CERO - 2)))
+		return;
+
+	if(hash_libre_cantidad(hilo->hash) > capacidad * CARGA_MAXIMA)
+		atomic_compare_exchange_strong(&hilo->hash->capacidad, &capacidad, capacidad * 2);
+}
+
+// pre: hilo y clave son distintos de NULL y el hilo esta dentro de una seccion de lectura
+// pos: devuelve el enlace de inicio de la busqueda de la clave (el centinela de su balde) y calcula su orden y hash, o NULL si no hay memoria para inicializar el balde
+_Atomic uintptr_t* libre_inicio(hash_libre_hilo_t* hilo, const char* clave, size_t largo, uint64_t* orden, uint64_t* valor_hash){
+
+	*valor_hash = hash_funcion_rapida(clave, largo, hilo->hash->semilla);
+	*orden = invertir_bits(*valor_hash) | 1;
+
+	size_t capacidad = atomic_load_explicit(&hilo->hash->capacidad, memory_order_acquire);
+	nodo_libre_t* centinela = libre_centinela(hilo, (size_t)(*valor_hash & (capacidad - 1)));
+
+	return centinela ? &centinela->siguiente : NULL;
+}
+
+/*
+ * Igual que hash_insertar. Si la clave existia, su elemento anterior
+ * se destruye cuando ningun hilo pueda estar mirandolo.
+ * Devuelve 0 si pudo guardarlo o -1 si no pudo.
+ */
+int hash_libre_insertar(hash_libre_hilo_t* hilo, const char* clave, void* elemento){
+
+	if(!hilo || !clave)
+		return ERROR;
+
+	size_t largo = strlen(clave);
+	uint64_t orden, valor_hash;
+	int resultado = ERROR;
+
+	epoca_entrar(hilo->epoca);
+
+	_Atomic uintptr_t* inicio = libre_inicio(hilo, clave, largo, &orden, &valor_hash);
+	nodo_libre_t* nuevo = inicio ? libre_crear_nodo(orden, valor_hash, clave, largo, elemento) : NULL;
+	elemento_retirado_t* retirado = nuevo && hilo->hash->destructor ? malloc(sizeof(elemento_retirado_t)) : NULL;
+
+	if(nuevo && (retirado || !hilo->hash->destructor)){
+
+		// Cuando el nodo se quite, el hilo que lo libere destruira el elemento que tenga en ese momento
+		nuevo->destructor = hilo->hash->destructor;
+		nodo_libre_t* enlazado = libre_enlazar(hilo, inicio, nuevo);
+		if(enlazado == nuevo){
+			libre_contar(hilo, 1);
+			libre_controlar_carga(hilo);
+			free(retirado);
+		}
+		else{
+			free(nuevo);
+			void* anterior = atomic_exchange(&enlazado->elemento, elemento);
+			if(retirado && anterior != elemento){
+				retirado->elemento = anterior;
+				retirado->destructor = hilo->hash->destructor;
+				epoca_retirar(hilo->epoca, &retirado->retiro, libre_liberar_elemento);
+			}
+			else
+				free(retirado);
+		}
+		resultado = EXITO;
+	}
+	else
+		free(nuevo);
+
+	epoca_salir(hilo->epoca);
+
+	return resultado;
+}
+
+/*
+ * Igual que hash_quitar, pero el destructor se invoca cuando ningun
+ * hilo pueda estar mirando el elemento.
+ * Devuelve 0 si pudo eliminar el elemento o -1 si no pudo.
+ */
+int hash_libre_quitar(hash_libre_hilo_t* hilo, const char* clave){
+
+	if(!hilo || !clave)
+		return ERROR;
+
+	size_t largo = strlen(clave);
+	uint64_t orden, valor_hash;
+	int resultado = ERROR;
+
+	epoca_entrar(hilo->epoca);
+
+	_Atomic uintptr_t* inicio = libre_inicio(hilo, clave, largo, &orden, &valor_hash);
+	_Atomic uintptr_t* anterior;
+	nodo_libre_t* actual;
+
+	while(inicio && resultado == ERROR && libre_buscar(hilo, inicio, orden, valor_hash, clave, largo, &anterior, &actual)){
+
+		uintptr_t siguiente = atomic_load_explicit(&actual->siguiente, memory_order_acquire);
+		if(siguiente & MARCA)
+			continue;
+
+		if(!atomic_compare_exchange_strong(&actual->siguiente, &siguiente, siguiente | MARCA))
+			continue;
+
+		uintptr_t esperado = (uintptr_t)actual;
+		if(atomic_compare_exchange_strong(anterior, &esperado, siguiente))
+			epoca_retirar(hilo->epoca, &actual->retiro, libre_liberar_nodo);
+		else
+			libre_buscar(hilo, inicio, orden, valor_hash, clave, largo, &anterior, &actual);
+
+		libre_contar(hilo, -1);
+		resultado = EXITO;
+	}
+
+	epoca_salir(hilo->epoca);
+
+	return resultado;
+}
+
+// pre: hilo y clave son distintos de NULL
+// pos: devuelve el elemento de la clave en elemento y true si la clave esta, o false si no esta
+bool libre_obtener(hash_libre_hilo_t* hilo, const char* clave, void** elemento){
+
+	size_t largo = strlen(clave);
+	uint64_t orden, valor_hash;
+	_Atomic uintptr_t* anterior;
+	nodo_libre_t* actual;
+
+	epoca_entrar(hilo->epoca);
+
+	_Atomic uintptr_t* inicio = libre_inicio(hilo, clave, largo, &orden, &valor_hash);
+	bool encontrado = inicio && libre_buscar(hilo, inicio, orden, valor_hash, clave, largo, &anterior, &actual);
+	if(encontrado)
+		*elemento = atomic_load_explicit(&actual->elemento, memory_order_acquire);
+
+	epoca_salir(hilo->epoca);
+
+	return encontrado;
+}
+
+/*
+ * Igual que hash_obtener. Si otro hilo quita o reemplaza la clave, el
+ * elemento devuelto puede ser destruido; mantenerlo vivo queda a cargo
+ * del usuario.
+ */
+void* hash_libre_obtener(hash_libre_hilo_t* hilo, const char* clave){
+
+	if(!hilo || !clave)
+		return NULL;
+
+	void* elemento = NULL;
+	libre_obtener(hilo, clave, &elemento);
+
+	return elemento;
+}
+
+/*
+ * Igual que hash_contiene.
+ */
+bool hash_libre_contiene(hash_libre_hilo_t* hilo, const char* clave){
+
+	if(!hilo || !clave)
+		return false;
+
+	void* elemento;
+
+	return libre_obtener(hilo, clave, &elemento);
+}
+
+/*
+ * Devuelve la cantidad de elementos almacenados. Si otros hilos estan
+ * modificando el hash, es solo una aproximacion.
+ */
+size_t hash_libre_cantidad(hash_libre_t* hash){
+
+	if(!hash)
+		return SIN_ELEMENTOS;
+
+	long cantidad = 0;
+	for(size_t i = 0; i < CANTIDAD_FRANJAS; i++)
+		cantidad += atomic_load_explicit(&hash->franjas[i].cantidad, memory_order_relaxed);
+
+	return cantidad > 0 ? (size_t)cantidad : SIN_ELEMENTOS;
+}
+
+/*
+ * Destruye el hash invocando al destructor con cada elemento. Ningun
+ * otro hilo puede estar usandolo.
+ */
+void hash_libre_destruir(hash_libre_t* hash){
+
+	if(!hash)
+		return;
+
+	nodo_libre_t* nodo = atomic_load(libre_lugar_balde(hash, 0));
+	while(nodo){
+		nodo_libre_t* siguiente = (nodo_libre_t*)(atomic_load_explicit(&nodo->siguiente, memory_order_relaxed) & ~MARCA);
+		libre_liberar_nodo(&nodo->retiro);
+		nodo = siguiente;
+	}
+
+	for(size_t i = 0; i < CANTIDAD_SEGMENTOS; i++)
+		free(atomic_load(&hash->segmentos[i]));
+
+	epoca_destruir(hash->epoca);
+	free(hash->franjas);
+	free(hash);
+}
@@ -0,0 +1,81 @@
+#ifndef __HASH_LIBRE_H__
+#define __HASH_LIBRE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "hash.h"
+
+/*
+ * Hash sin candados para muchos hilos que insertan y quitan a la vez.
+ * Todos los elementos estan en una unica lista enlazada ordenada por
+ * los bits de su hash invertidos (listas de orden dividido, de Shalev y
+ * Shavit), y cada balde apunta a un nodo centinela dentro de esa lista.
+ * Las inserciones, borrados y busquedas modifican la lista con
+ * compare-and-swap, y agrandar la tabla solo duplica la cantidad de
+ * baldes en uso: cada balde nuevo se inicializa la primera vez que se
+ * usa, sin mover ningun elemento. Los nodos quitados se liberan por
+ * epocas (ver epoca.h).
+ *
+ * Cada hilo se registra una vez con hash_libre_registrar_hilo y usa su
+ * registro en todas las operaciones.
+ */
+typedef struct hash_libre hash_libre_t;
+typedef struct hash_libre_hilo hash_libre_hilo_t;
+
+/*
+ * Crea el hash igual que hash_crear.
+ * Devuelve un puntero al hash creado o NULL en caso de no poder crearlo.
+ */
+hash_libre_t* hash_libre_crear(hash_destruir_dato_t destruir_elemento, size_t capacidad);
+
+/*
+ * Registra al hilo que la llama. El registro devuelto solo puede
+ * usarlo ese hilo.
+ * Devuelve el registro o NULL en caso de error.
+ */
+hash_libre_hilo_t* hash_libre_registrar_hilo(hash_libre_t* hash);
+
+/*
+ * Da de baja el registro del hilo.
+ */
+void hash_libre_desregistrar_hilo(hash_libre_hilo_t* hilo);
+
+/*
+ * Igual que hash_insertar. Si la clave existia, su elemento anterior
+ * se destruye cuando ningun hilo pueda estar mirandolo.
+ * Devuelve 0 si pudo guardarlo o -1 si no pudo.
+ */
+int hash_libre_insertar(hash_libre_hilo_t* hilo, const char* clave, void* elemento);
+
+/*
+ * Igual que hash_quitar, pero el destructor se invoca cuando ningun
+ * hilo pueda estar mirando el elemento.
+ * Devuelve 0 si pudo eliminar el elemento o -1 si no pudo.
+ */
+int hash_libre_quitar(hash_libre_hilo_t* hilo, const char* clave);
+
+/*
+ * Igual que hash_obtener. Si otro hilo quita o reemplaza la clave, el
+ * elemento devuelto puede ser destruido; mantenerlo vivo queda a cargo
+ * del usuario.
+ */
+void* hash_libre_obtener(hash_libre_hilo_t* hilo, const char* clave);
+
+/*
+ * Igual que hash_contiene.
+ */
+bool hash_libre_contiene(hash_libre_hilo_t* hilo, const char* clave);
+
+/*
+ * Devuelve la cantidad de elementos almacenados. Si otros hilos estan
+ * modificando el hash, es solo una aproximacion.
+ */
+size_t hash_libre_cantidad(hash_libre_t* hash);
+
+/*
+ * Destruye el hash invocando al destructor con cada elemento. Ningun
+ * otro hilo puede estar usandolo.
+ */
+void hash_libre_destruir(hash_libre_t* hash);
+
+#endif /* __HASH_LIBRE_H__ */
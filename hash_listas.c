@@ -0,0 +1,432 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "hash_interno.h"
+
+#define FACTOR_REHASH 3
+
+typedef struct elemento{
+	uint64_t hash;
+	char* clave;
+	size_t largo;
+	void* elemento;
+}elemento_t;
+
+// pre: 
+// pos: devuelve TRUE si pudo inicializar todas las listas correctamente, FALSE en caso contrario
+bool inicializar_listas(slab_t* slab, lista_t** index, size_t pos_inicial, size_t capacidad){
+
+	if(!index)
+		return false;
+
+	size_t cantidad_inicializadas = 0;
+	size_t i = pos_inicial;
+	bool inicializa_correctamente = true;
+
+	while(i < capacidad && inicializa_correctamente){
+
+		index[i] = lista_crear_en_slab(slab);
+		if(!index[i])
+			inicializa_correctamente = false;
+		else{
+			i++;
+			cantidad_inicializadas++;
+		}
+	}
+
+	if(!inicializa_correctamente){
+		for (size_t i = pos_inicial; i < cantidad_inicializadas + pos_inicial; i++)
+			lista_destruir(index[i]);
+	}
+
+	return inicializa_correctamente;
+}
+
+// pre: hash es distinto de NULL
+// pos: reserva el arreglo de listas. Devuelve TRUE si pudo crearlo, FALSE en caso contrario
+bool listas_crear(hash_t* hash, size_t capacidad){
+
+	hash->index = malloc(sizeof(void*) * capacidad);
+	if(!hash->index)
+		return false;
+
+	if(!inicializar_listas(hash->slab, hash->index, 0, hash->capacidad)){
+		free(hash->index);
+		return false;
+	}
+
+	return true;
+}
+
+// pre: clave es distinto de NULL
+// pos: devuelve un puntero a un elemento con una copia de los largo bytes de clave, el elemento y el hash
+elemento_t* crear_elemento(hash_t* hash, const void* clave, size_t largo, void* elemento, uint64_t valor_hash){
+
+	if(!clave)
+		return NULL;
+
+	elemento_t* elem = hash_reservar_memoria(hash, sizeof(elemento_t));
+	if(!elem)
+		return NULL;
+
+	elem->hash = valor_hash;
+	elem->largo = largo;
+	elem->clave = hash_copiar_clave(hash, clave, largo);
+	if(!elem->clave){
+		hash_liberar_memoria(hash, elem, sizeof(elemento_t));
+		return NULL;
+	}
+	elem->elemento = elemento;
+
+	return elem;
+}
+
+// pre:
+// pos: devuelve TRUE si el numero es primo, FALSE caso contrario. Solo prueba divisores impares hasta la raiz del numero
+bool es_primo(size_t numero){
+
+	if(numero < 4)
+		return numero >= 2;
+
+	if(numero % 2 == 0)
+		return false;
+
+	for(size_t i = 3; i <= numero / i; i += 2){
+		if(numero % i == 0)
+			return false;
+	}
+
+	return true;
+}
+
+// pre:
+// pos: devuelve el numero primo mas cercano a numero
+size_t numero_primo_mas_cercano(size_t numero){
+
+	bool primo = false;
+	size_t i = numero;
+
+	while(!primo){
+
+		if(es_primo(i))
+			primo = true;
+		else
+			i++;
+	}
+
+	return i;
+}
+
+// pre: hash es distinto de NULL y nueva_capacidad es mayor a la capacidad actual
+// pos: agranda el arreglo de listas a nueva_capacidad y mueve cada elemento a la lista que le corresponde. Devuelve 0 si se ejecuto correctamente, -1 caso contrario
+int listas_redimensionar(hash_t* hash, size_t nueva_capacidad){
+
+	uint64_t inicio = hash_reloj_ns();
+	void* aux = realloc(hash->index, nueva_capacidad* sizeof(void*));
+	if(!aux)
+		return ERROR;
+
+	size_t cantidad_aux = hash->capacidad;
+	hash->index = aux;
+
+	// Si falla, inicializar_listas destruye las listas nuevas que llego a crear y
+	// la tabla sigue usando las viejas con la capacidad anterior
+	if(!inicializar_listas(hash->slab, aux, cantidad_aux, nueva_capacidad))
+		return ERROR;
+
+	hash->capacidad = nueva_capacidad;
+
+	// Los nodos pasan de la lista vieja a la nueva (al final, si es la misma) sin
+	// reservar memoria, asi que la mudanza no puede quedar a medias.
+	for(size_t i = 0; i < cantidad_aux; i++){
+
+		size_t pendientes = lista_elementos(hash->index[i]);
+		while(pendientes > 0){
+			elemento_t* elem = lista_elemento_en_posicion(hash->index[i], 0);
+			size_t posicion_hash = (size_t)(elem->hash % hash->capacidad);
+			lista_mover_primero(hash->index[i], hash->index[posicion_hash]);
+			pendientes--;
+		}
+	}
+
+	hash->rehashes++;
+	hash_sumar_tiempo_rehash(hash, inicio);
+
+	return EXITO;
+}
+
+// pre:
+// pos: agranda el tamaño del arreglo de listas al primo mas cercano al doble de su capacidad y mueve cada elemento a la lista que le corresponde. Devuelve 0 si se ejecuto correctamente, -1 caso contrario
+int hash_rehashear(hash_t* hash){
+
+	if(!hash)
+		return ERROR;
+
+	return listas_redimensionar(hash, numero_primo_mas_cercano(2 * hash->capacidad));
+}
+
+// pre: hash es distinto de NULL
+// pos: agranda el arreglo de listas, si hace falta, para que guardar cantidad elementos no provoque ningun rehash. Devuelve 0 si pudo o -1 si no
+int listas_reservar(hash_t* hash, size_t cantidad){
+
+	size_t necesaria = cantidad / FACTOR_REHASH + 1;
+	if(necesaria <= hash->capacidad)
+		return EXITO;
+
+	return listas_redimensionar(hash, numero_primo_mas_cercano(necesaria));
+}
+
+// pre: hash y clave son distintos de NULL
+// pos: devuelve el elemento_t con dicha clave o NULL si no existe
+elemento_t* listas_ubicar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash){
+
+	size_t posicion_hash = (size_t)(valor_hash % hash->capacidad);
+
+	// El cursor no reserva memoria, asi que NULL siempre significa que la clave no esta
+	lista_cursor_t cursor;
+	lista_cursor_iniciar(hash->index[posicion_hash], &cursor);
+
+	void* actual;
+	while(lista_cursor_siguiente(&cursor, &actual)){
+		elemento_t* elem = actual;
+		if(elem->hash == valor_hash && elem->largo == largo && memcmp(elem->clave, clave, largo) == 0)
+			return elem;
+	}
+
+	return NULL;
+}
+
+// pre: hash, clave e insertado son distintos de NULL y valor_hash es el hash de la clave
+// pos: devuelve el lugar del elemento con dicha clave, insertandola con elemento NULL al final de su lista si no existia. Devuelve NULL si no pudo insertarla
+void** listas_buscar_o_insertar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash, bool* insertado){
+
+	elemento_t* existente = listas_ubicar(hash, clave, largo, valor_hash);
+	if(existente){
+		*insertado = false;
+		return &existente->elemento;
+	}
+
+	hash->factor_carga = (hash->cantidad_elementos + 1)/hash->capacidad;
+
+	if(hash->factor_carga >= FACTOR_REHASH){
+		if(hash_rehashear(hash) == ERROR)
+				return NULL;
+	}
+
+	elemento_t* elemento_a_insertar = crear_elemento(hash, clave, largo, NULL, valor_hash);
+	if(!elemento_a_insertar)
+		return NULL;
+
+	size_t posicion_hash = (size_t)(valor_hash % hash->capacidad);
+
+	if(lista_insertar(hash->index[posicion_hash], elemento_a_insertar) == ERROR){
+		hash_liberar_clave(hash, elemento_a_insertar->clave, largo);
+		hash_liberar_memoria(hash, elemento_a_insertar, sizeof(elemento_t));
+		return NULL;
+	}
+
+	hash->cantidad_elementos++;
+	*insertado = true;
+
+	return &elemento_a_insertar->elemento;
+}
+
+// pre: hash y clave son distintos de NULL y valor_hash es el hash de la clave
+// pos: quita el elemento de su lista e invoca al destructor. Devuelve 0 si pudo eliminarlo o -1 si no pudo.
+int listas_quitar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash){
+
+	size_t posicion_hash = (size_t)(valor_hash % hash->capacidad);
+
+	lista_cursor_t cursor;
+	lista_cursor_iniciar(hash->index[posicion_hash], &cursor);
+
+	void* actual;
+	while(lista_cursor_siguiente(&cursor, &actual)){
+		elemento_t* elem = actual;
+		if(elem->hash == valor_hash && elem->largo == largo && memcmp(elem->clave, clave, largo) == 0){
+			lista_cursor_quitar(&cursor, &actual);
+			if(hash->destructor)
+				hash->destructor(elem->elemento);
+			hash_liberar_clave(hash, elem->clave, elem->largo);
+			hash_liberar_memoria(hash, elem, sizeof(elemento_t));
+			hash->cantidad_elementos--;
+			return EXITO;
+		}
+	}
+
+	return ERROR;
+}
+
+// pre: hash y clave son distintos de NULL y valor_hash es el hash de la clave
+// pos: devuelve true si la clave esta, dejando su elemento en elemento si no es NULL
+bool listas_buscar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash, void** elemento){
+
+	elemento_t* elem = listas_ubicar(hash, clave, largo, valor_hash);
+	if(!elem)
+		return false;
+
+	if(elemento)
+		*elemento = elem->elemento;
+
+	return true;
+}
+
+// pre: hash es distinto de NULL
+// pos: pide a cache la posicion del indice que le corresponde a valor_hash
+void listas_anticipar_balde(const hash_t* hash, uint64_t valor_hash){
+
+	ANTICIPAR(&hash->index[valor_hash % hash->capacidad]);
+}
+
+// pre: hash es distinto de NULL
+// pos: pide a cache la lista que le corresponde a valor_hash
+void listas_anticipar_elemento(const hash_t* hash, uint64_t valor_hash){
+
+	ANTICIPAR(hash->index[valor_hash % hash->capacidad]);
+}
+
+// pre:
+// pos: borra todos los elementos del hash
+void borrar_todos_los_elementos(hash_t* hash){
+
+	if(!hash)
+		return;
+
+	elemento_t* elem;
+	for(size_t i = 0; i < hash->capacidad; i++){
+
+		while(!lista_vacia(hash->index[i])){
+
+			lista_iterador_t* iter = lista_iterador_crear(hash->index[i]);
+			elem = lista_iterador_siguiente(iter);
+
+			if(elem){
+				if(hash->destructor)
+					hash->destructor(elem->elemento);
+				hash_liberar_clave(hash, elem->clave, elem->largo);
+				hash_liberar_memoria(hash, elem, sizeof(elemento_t));
+				hash->cantidad_elementos--;
+				lista_borrar_de_posicion(hash->index[i], 0);
+			}
+
+			lista_iterador_destruir(iter);
+		}
+	}
+
+}
+
+// pre: hash es distinto de NULL
+// pos: libera todos los elementos y las listas del hash
+void listas_destruir(hash_t* hash){
+
+	// Las listas, nodos, elementos y claves se liberan junto con el slab
+	if(hash->slab && !hash->destructor){
+		free(hash->index);
+		return;
+	}
+
+	if(hash_cantidad(hash) != 0)
+		borrar_todos_los_elementos(hash);
+
+	for(size_t i = 0; i < hash->capacidad; i++)
+		lista_destruir(hash->index[i]);
+
+	free(hash->index);
+}
+
+// pre: cursor es distinto de NULL
+// pos: no hace nada, el cursor ya empieza en la primera lista
+void listas_cursor_iniciar(hash_cursor_t* cursor){
+
+	(void)cursor;
+}
+
+// pre: cursor, clave, largo y elemento son distintos de NULL
+// pos: devuelve el proximo elemento y avanza el cursor, o false si no habia mas. En posicion queda la lista del elemento devuelto
+bool listas_cursor_siguiente(hash_cursor_t* cursor, const char** clave, size_t* largo, void** elemento){
+
+	hash_t* hash = cursor->hash;
+	if(cursor->posicion == hash->capacidad)
+		return false;
+
+	lista_cursor_t lista_cursor = {hash->index[cursor->posicion], cursor->anterior, cursor->actual};
+	void* proximo;
+
+	while(!lista_cursor_siguiente(&lista_cursor, &proximo)){
+		if(++cursor->posicion == hash->capacidad){
+			cursor->anterior = cursor->actual = NULL;
+			return false;
+		}
+		lista_cursor_iniciar(hash->index[cursor->posicion], &lista_cursor);
+	}
+
+	cursor->anterior = lista_cursor.anterior;
+	cursor->actual = lista_cursor.actual;
+
+	elemento_t* elem = proximo;
+	*clave = elem->clave;
+	*largo = elem->largo;
+	*elemento = elem->elemento;
+	cursor->valor_hash = elem->hash;
+
+	return true;
+}
+
+// pre: cursor es distinto de NULL y tiene un elemento actual
+// pos: quita el elemento actual de su lista sin recorrerla y lo libera. Devuelve 0 si pudo o -1 si no
+int listas_cursor_quitar(hash_cursor_t* cursor){
+
+	hash_t* hash = cursor->hash;
+	lista_cursor_t lista_cursor = {hash->index[cursor->posicion], cursor->anterior, cursor->actual};
+	void* quitado;
+
+	if(!lista_cursor_quitar(&lista_cursor, &quitado))
+		return ERROR;
+
+	cursor->actual = lista_cursor.actual;
+
+	elemento_t* elem = quitado;
+	if(hash->destructor)
+		hash->destructor(elem->elemento);
+	hash_liberar_clave(hash, elem->clave, elem->largo);
+	hash_liberar_memoria(hash, elem, sizeof(elemento_t));
+	hash->cantidad_elementos--;
+
+	return EXITO;
+}
+
+// pre: hash y estadisticas son distintos de NULL
+// pos: agrega a las estadisticas el largo de cada lista y la memoria del arreglo, las listas, los elementos y las claves
+void listas_estadisticas(hash_t* hash, hash_estadisticas_t* estadisticas){
+
+	estadisticas->bytes_baldes = hash->capacidad * sizeof(lista_t*);
+
+	for(size_t i = 0; i < hash->capacidad; i++){
+
+		hash_contar_cadena(estadisticas, lista_elementos(hash->index[i]));
+		estadisticas->bytes_baldes += lista_memoria(hash->index[i]);
+
+		lista_cursor_t cursor;
+		void* elem;
+		lista_cursor_iniciar(hash->index[i], &cursor);
+		while(lista_cursor_siguiente(&cursor, &elem)){
+			estadisticas->bytes_entradas += sizeof(elemento_t);
+			estadisticas->bytes_claves += ((elemento_t*)elem)->largo + 1;
+		}
+	}
+}
+
+const hash_operaciones_t OPERACIONES_LISTAS = {
+	.crear = listas_crear,
+	.buscar_o_insertar = listas_buscar_o_insertar,
+	.quitar = listas_quitar,
+	.buscar = listas_buscar,
+	.reservar = listas_reservar,
+	.destruir = listas_destruir,
+	.anticipar_balde = listas_anticipar_balde,
+	.anticipar_elemento = listas_anticipar_elemento,
+	.cursor_iniciar = listas_cursor_iniciar,
+	.cursor_siguiente = listas_cursor_siguiente,
+	.cursor_quitar = listas_cursor_quitar,
+	.estadisticas = listas_estadisticas
+};
@@ -0,0 +1,443 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "hash_rcu.h"
+#include "hash_interno.h"
+#include "epoca.h"
+
+/*
+ * Un nodo publicado nunca se modifica: reemplazar un elemento publica
+ * un nodo nuevo en su lugar y retira el viejo. Los enlaces se escriben
+ * con semantica release y se leen con acquire, asi un lector que llega
+ * a un nodo ve todos sus campos inicializados.
+ */
+
+#define CAPACIDAD_MINIMA 8
+#define LECTURAS_POR_RECOLECCION 64
+
+typedef struct nodo_rcu{
+	_Atomic(struct nodo_rcu*) siguiente;
+	uint64_t hash;
+	size_t largo;
+	void* elemento;
+	hash_destruir_dato_t destructor;
+	epoca_retiro_t retiro;
+	char clave[];
+}nodo_rcu_t;
+
+typedef struct tabla_rcu{
+	size_t capacidad;
+	_Atomic(nodo_rcu_t*) baldes[];
+}tabla_rcu_t;
+
+struct hash_rcu{
+	_Atomic(tabla_rcu_t*) tabla;
+	_Atomic size_t cantidad_elementos;
+	uint64_t semilla;
+	hash_destruir_dato_t destructor;
+	pthread_mutex_t escritura;
+	epoca_t* epoca;
+	epoca_hilo_t* escritor;
+};
+
+struct hash_rcu_lector{
+	hash_rcu_t* hash;
+	epoca_hilo_t* hilo;
+	size_t lecturas;
+};
+
+// pre:
+// pos: devuelve una tabla vacia de capacidad baldes (potencia de 2) o NULL si no hay memoria
+tabla_rcu_t* rcu_crear_tabla(size_t capacidad){
+
+	tabla_rcu_t* tabla = malloc(sizeof(tabla_rcu_t) + capacidad * sizeof(_Atomic(nodo_rcu_t*)));
+	if(!tabla)
+		return NULL;
+
+	tabla->capacidad = capacidad;
+	for(size_t i = 0; i < capacidad; i++)
+		atomic_init(&tabla->baldes[i], NULL);
+
+	return tabla;
+}
+
+// pre: clave es distinto de NULL
+// pos: devuelve un nodo sin publicar con una copia de la clave, o NULL si no hay memoria
+nodo_rcu_t* rcu_crear_nodo(const char* clave, size_t largo, uint64_t valor_hash, void* elemento){
+
+	nodo_rcu_t* nodo = malloc(sizeof(nodo_rcu_t) + largo + 1);
+	if(!nodo)
+		return NULL;
+
+	atomic_init(&nodo->siguiente, NULL);
+	nodo->hash = valor_hash;
+	nodo->largo = largo;
+	nodo->elemento = elemento;
+	nodo->destructor = NULL;
+	memcpy(nodo->clave, clave, largo + 1);
+
+	return nodo;
+}
+
+// pre: retiro es el encabezado de un nodo_rcu_t
+// pos: invoca al destructor guardado en el nodo (si hay) con su elemento y libera el nodo
+void rcu_liberar_nodo(epoca_retiro_t* retiro){
+
+	nodo_rcu_t* nodo = (nodo_rcu_t*)((char*)retiro - offsetof(nodo_rcu_t, retiro));
+
+	if(nodo->destructor)
+		nodo->destructor(nodo->elemento);
+
+	free(nodo);
+}
+
+// pre: hash es distinto de NULL y el llamador tiene el candado de escritura
+// pos: retira el nodo; si destruir_elemento es true, su elemento se destruye junto con el nodo. Libera tambien los retirados antes que ya nadie puede estar leyendo
+void rcu_retirar_nodo(hash_rcu_t* hash, nodo_rcu_t* nodo, bool destruir_elemento){
+
+	nodo->destructor = destruir_elemento ? hash->destructor : NULL;
+	epoca_retirar(hash->escritor, &nodo->retiro, rcu_liberar_nodo);
+	epoca_recolectar(hash->escritor);
+}
+
+/*
+ * Crea el hash igual que hash_crear.
+ * Devuelve un puntero al hash creado o NULL en caso de no poder crearlo.
+ */
+hash_rcu_t* hash_rcu_crear(hash_destruir_dato_t destruir_elemento, size_t capacidad){
+
+	hash_rcu_t* hash = malloc(sizeof(hash_rcu_t));
+	if(!hash)
+		return NULL;
+
+	size_t capacidad_tabla = CAPACIDAD_MINIMA;
+	while(capacidad_tabla < capacidad)
+		capacidad_tabla *= 2;
+
+	tabla_rcu_t* tabla = rcu_crear_tabla(capacidad_tabla);
+	hash->epoca = epoca_crear();
+	hash->escritor = epoca_registrar(hash->epoca);
+
+	if(!tabla || !hash->escritor || pthread_mutex_init(&hash->escritura, NULL) != 0){
+		free(tabla);
+		epoca_destruir(hash->epoca);
+		free(hash);
+		return NULL;
+	}
+
+	atomic_init(&hash->tabla, tabla);
+	atomic_init(&hash->cantidad_elementos, SIN_ELEMENTOS);
+	hash->semilla = semilla_aleatoria();
+	hash->destructor = destruir_elemento;
+
+	return hash;
+}
+
+// pre: hash y clave son distintos de NULL
+// pos: devuelve el nodo con dicha clave en la tabla publicada o NULL si no esta
+nodo_rcu_t* rcu_buscar(hash_rcu_t* hash, const char* clave, size_t largo, uint64_t valor_hash){
+
+	tabla_rcu_t* tabla = atomic_load_explicit(&hash->tabla, memory_order_acquire);
+	nodo_rcu_t* nodo = atomic_load_explicit(&tabla->baldes[valor_hash & (tabla->capacidad - 1)], memory_order_acquire);
+
+	while(nodo && (nodo->hash != valor_hash || nodo->largo != largo || memcmp(nodo->clave, clave, largo) != 0))
+		nodo = atomic_load_explicit(&nodo->siguiente, memory_order_acquire);
+
+	return nodo;
+}
+
+// pre: hash y clave son distintos de NULL y el llamador tiene el candado de escritura
+// pos: devuelve el enlace que apunta al nodo con dicha clave, o al NULL final de su cadena si no esta
+_Atomic(nodo_rcu_t*)* rcu_ubicar(hash_rcu_t* hash, const char* clave, size_t largo, uint64_t valor_hash){
+
+	tabla_rcu_t* tabla = atomic_load_explicit(&hash->tabla, memory_order_relaxed);
+	_Atomic(nodo_rcu_t*)* enlace = &tabla->baldes[valor_hash & (tabla->capacidad - 1)];
+
+	nodo_rcu_t* nodo;
+	while((nodo = atomic_load_explicit(enlace, memory_order_relaxed)) && (nodo->hash != valor_hash || nodo->largo != largo || memcmp(nodo->clave, clave, largo) != 0))
+		enlace = &nodo->siguiente;
+
+	return enlace;
+}
+
+// pre: hash es distinto de NULL, el llamador tiene el candado de escritura y no esta dentro de una lectura
+// pos: publica una tabla del doble de baldes con los mismos nodos y libera la tabla vieja. Si no hay memoria deja la tabla como estaba
+void rcu_redimensionar(hash_rcu_t* hash){
+
+	tabla_rcu_t* vieja = atomic_load_explicit(&hash->tabla, memory_order_relaxed);
+	size_t capacidad = vieja->capacidad;
+	size_t mascara = capacidad * 2 - 1;
+
+	tabla_rcu_t* nueva = rcu_crear_tabla(capacidad * 2);
+	nodo_rcu_t** frentes = malloc(capacidad * sizeof(nodo_rcu_t*));
+	if(!nueva || !frentes){
+		free(nueva);
+		free(frentes);
+		return;
+	}
+
+	// Cada balde viejo i se parte en los baldes nuevos i e i + capacidad. Al principio
+	// los dos empiezan en su primer nodo de la cadena vieja, que queda compartida: un
+	// lector que pasa por un nodo del otro balde lo descarta al comparar la clave
+	for(size_t i = 0; i < capacidad; i++){
+		frentes[i] = atomic_load_explicit(&vieja->baldes[i], memory_order_relaxed);
+		for(nodo_rcu_t* nodo = frentes[i]; nodo; nodo = atomic_load_explicit(&nodo->siguiente, memory_order_relaxed)){
+			_Atomic(nodo_rcu_t*)* balde = &nueva->baldes[nodo->hash & mascara];
+			if(!atomic_load_explicit(balde, memory_order_relaxed))
+				atomic_store_explicit(balde, nodo, memory_order_relaxed);
+		}
+	}
+
+	atomic_store_explicit(&hash->tabla, nueva, memory_order_release);
+
+	// Despues de esto nadie sigue recorriendo las cadenas viejas completas
+	epoca_sincronizar(hash->escritor);
+	free(vieja);
+
+	// Se separan las cadenas de a un cruce por balde viejo, esperando entre vuelta y
+	// vuelta a que terminen las lecturas en curso: asi ningun lector de un balde puede
+	// estar parado en el tramo del otro cuando se saltea ese tramo
+	bool entrelazadas = true;
+	while(entrelazadas){
+
+		entrelazadas = false;
+		for(size_t i = 0; i < capacidad; i++){
+
+			nodo_rcu_t* nodo = frentes[i];
+			if(!nodo)
+				continue;
+
+			size_t balde = nodo->hash & mascara;
+			nodo_rcu_t* siguiente;
+			while((siguiente = atomic_load_explicit(&nodo->siguiente, memory_order_relaxed)) && (siguiente->hash & mascara) == balde)
+				nodo = siguiente;
+
+			nodo_rcu_t* mismo_balde = siguiente;
+			while(mismo_balde && (mismo_balde->hash & mascara) != balde)
+				mismo_balde = atomic_load_explicit(&mismo_balde->siguiente, memory_order_relaxed);
+
+			if(siguiente)
+				atomic_store_explicit(&nodo->siguiente, mismo_balde, memory_order_release);
+
+			// Si quedan nodos de este balde, el tramo que empieza en siguiente vuelve a cruzar
+			frentes[i] = mismo_balde ? siguiente : NULL;
+			entrelazadas |= mismo_balde != NULL;
+		}
+
+		if(entrelazadas)
+			epoca_sincronizar(hash->escritor);
+	}
+
+	free(frentes);
+}
+
+/*
+ * Inserta un elemento o reemplaza el de una clave existente. El
+ * elemento reemplazado se destruye cuando ya no lo puede estar leyendo
+ * ningun lector.
+ * Al agrandarse la tabla los mismos nodos se reparten entre los baldes
+ * nuevos sin copiarlos, esperando entre paso y paso a que terminen las
+ * lecturas en curso; por eso no puede llamarse desde un hilo que esta
+ * dentro de una lectura.
+ * Devuelve 0 si pudo guardarlo o -1 si no pudo.
+ */
+int hash_rcu_insertar(hash_rcu_t* hash, const char* clave, void* elemento){
+
+	if(!hash || !clave)
+		return ERROR;
+
+	size_t largo = strlen(clave);
+	uint64_t valor_hash = hash_funcion_rapida(clave, largo, hash->semilla);
+
+	nodo_rcu_t* nuevo = rcu_crear_nodo(clave, largo, valor_hash, elemento);
+	if(!nuevo)
+		return ERROR;
+
+	pthread_mutex_lock(&hash->escritura);
+
+	_Atomic(nodo_rcu_t*)* enlace = rcu_ubicar(hash, clave, largo, valor_hash);
+	nodo_rcu_t* viejo = atomic_load_explicit(enlace, memory_order_relaxed);
+
+	if(viejo){
+		atomic_store_explicit(&nuevo->siguiente, atomic_load_explicit(&viejo->siguiente, memory_order_relaxed), memory_order_relaxed);
+		atomic_store_explicit(enlace, nuevo, memory_order_release);
+		rcu_retirar_nodo(hash, viejo, viejo->elemento != elemento);
+	}
+	else{
+		atomic_store_explicit(enlace, nuevo, memory_order_release);
+		size_t cantidad = atomic_load_explicit(&hash->cantidad_elementos, memory_order_relaxed) + 1;
+		atomic_store_explicit(&hash->cantidad_elementos, cantidad, memory_order_relaxed);
+		if(cantidad > atomic_load_explicit(&hash->tabla, memory_order_relaxed)->capacidad)
+			rcu_redimensionar(hash);
+	}
+
+	pthread_mutex_unlock(&hash->escritura);
+
+	return EXITO;
+}
+
+/*
+ * Quita un elemento del hash. El destructor se invoca con el elemento
+ * cuando ya no lo puede estar leyendo ningun lector.
+ * Devuelve 0 si pudo eliminar el elemento o -1 si no pudo.
+ */
+int hash_rcu_quitar(hash_rcu_t* hash, const char* clave){
+
+	if(!hash || !clave)
+		return ERROR;
+
+	size_t largo = strlen(clave);
+	uint64_t valor_hash = hash_funcion_rapida(clave, largo, hash->semilla);
+
+	pthread_mutex_lock(&hash->escritura);
+
+	_Atomic(nodo_rcu_t*)* enlace = rcu_ubicar(hash, clave, largo, valor_hash);
+	nodo_rcu_t* nodo = atomic_load_explicit(enlace, memory_order_relaxed);
+
+	if(nodo){
+		atomic_store_explicit(enlace, atomic_load_explicit(&nodo->siguiente, memory_order_relaxed), memory_order_release);
+		rcu_retirar_nodo(hash, nodo, true);
+		atomic_store_explicit(&hash->cantidad_elementos, atomic_load_explicit(&hash->cantidad_elementos, memory_order_relaxed) - 1, memory_order_relaxed);
+	}
+
+	pthread_mutex_unlock(&hash->escritura);
+
+	return nodo ? EXITO : ERROR;
+}
+
+/*
+ * Devuelve la cantidad de elementos almacenados en el hash.
+ */
+size_t hash_rcu_cantidad(hash_rcu_t* hash){
+
+	if(!hash)
+		return SIN_ELEMENTOS;
+
+	return atomic_load_explicit(&hash->cantidad_elementos, memory_order_relaxed);
+}
+
+/*
+ * Registra al hilo que la llama como lector del hash. El lector
+ * devuelto solo puede usarlo ese hilo.
+ * Devuelve el lector o NULL en caso de error.
+ */
+hash_rcu_lector_t* hash_rcu_registrar_lector(hash_rcu_t* hash){
+
+	if(!hash)
+		return NULL;
+
+	hash_rcu_lector_t* lector = malloc(sizeof(hash_rcu_lector_t));
+	if(!lector)
+		return NULL;
+
+	lector->hash = hash;
+	lector->lecturas = 0;
+	lector->hilo = epoca_registrar(hash->epoca);
+	if(!lector->hilo){
+		free(lector);
+		return NULL;
+	}
+
+	return lector;
+}
+
+/*
+ * Da de baja al lector, que no puede estar dentro de una lectura.
+ */
+void hash_rcu_desregistrar_lector(hash_rcu_lector_t* lector){
+
+	if(!lector)
+		return;
+
+	epoca_desregistrar(lector->hilo);
+	free(lector);
+}
+
+/*
+ * Empieza una lectura. Los elementos obtenidos hasta llamar a
+ * hash_rcu_terminar_lectura no se destruyen aunque otro hilo los
+ * quite o reemplace.
+ */
+void hash_rcu_leer(hash_rcu_lector_t* lector){
+
+	if(lector)
+		epoca_entrar(lector->hilo);
+}
+
+/*
+ * Termina la lectura empezada con hash_rcu_leer.
+ */
+void hash_rcu_terminar_lectura(hash_rcu_lector_t* lector){
+
+	if(!lector)
+		return;
+
+	epoca_salir(lector->hilo);
+
+	// Cada tanto un lector libera lo que retiraron las escrituras, para que no espere
+	// hasta la proxima modificacion si el hash deja de modificarse
+	if(++lector->lecturas % LECTURAS_POR_RECOLECCION == 0 && pthread_mutex_trylock(&lector->hash->escritura) == 0){
+		epoca_recolectar(lector->hash->escritor);
+		pthread_mutex_unlock(&lector->hash->escritura);
+	}
+}
+
+/*
+ * Devuelve el elemento con la clave dada o NULL si no existe. Solo se
+ * puede llamar dentro de una lectura, y el elemento devuelto es valido
+ * hasta que esta termine.
+ */
+void* hash_rcu_obtener(hash_rcu_lector_t* lector, const char* clave){
+
+	if(!lector || !clave)
+		return NULL;
+
+	size_t largo = strlen(clave);
+	nodo_rcu_t* nodo = rcu_buscar(lector->hash, clave, largo, hash_funcion_rapida(clave, largo, lector->hash->semilla));
+
+	return nodo ? nodo->elemento : NULL;
+}
+
+/*
+ * Devuelve true si el hash contiene la clave o false en caso contrario.
+ * Solo se puede llamar dentro de una lectura.
+ */
+bool hash_rcu_contiene(hash_rcu_lector_t* lector, const char* clave){
+
+	if(!lector || !clave)
+		return false;
+
+	size_t largo = strlen(clave);
+
+	return rcu_buscar(lector->hash, clave, largo, hash_funcion_rapida(clave, largo, lector->hash->semilla)) != NULL;
+}
+
+/*
+ * Destruye el hash invocando al destructor con cada elemento, incluidos
+ * los quitados que todavia esperaban. Ningun otro hilo puede estar
+ * usandolo.
+ */
+void hash_rcu_destruir(hash_rcu_t* hash){
+
+	if(!hash)
+		return;
+
+	tabla_rcu_t* tabla = atomic_load_explicit(&hash->tabla, memory_order_relaxed);
+	for(size_t i = 0; i < tabla->capacidad; i++){
+		nodo_rcu_t* nodo = atomic_load_explicit(&tabla->baldes[i], memory_order_relaxed);
+		while(nodo){
+			nodo_rcu_t* siguiente = atomic_load_explicit(&nodo->siguiente, memory_order_relaxed);
+			nodo->destructor = hash->destructor;
+			rcu_liberar_nodo(&nodo->retiro);
+			nodo = siguiente;
+		}
+	}
+
+	free(tabla);
+	epoca_destruir(hash->epoca);
+	pthread_mutex_destroy(&hash->escritura);
+	free(hash);
+}
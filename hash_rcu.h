@@ -0,0 +1,100 @@
+#ifndef __HASH_RCU_H__
+#define __HASH_RCU_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "hash.h"
+
+/*
+ * Hash para tablas que se leen mucho mas de lo que se modifican. Las
+ * lecturas recorren las cadenas sin candados ni escrituras atomicas
+ * compartidas, protegidas por recoleccion por epocas (ver epoca.h).
+ * Las modificaciones se serializan entre si con un candado y nunca
+ * liberan en el momento un elemento o una clave que un lector pueda
+ * estar mirando: los nodos quitados o reemplazados, y el destructor de
+ * sus elementos, esperan a que terminen las lecturas en curso. Se
+ * liberan en la modificacion siguiente o, si el hash deja de
+ * modificarse, cuando algun lector termina una lectura, asi que el
+ * destructor puede invocarse desde un hilo lector.
+ *
+ * Cada hilo lector se registra una vez con hash_rcu_registrar_lector y
+ * hace sus busquedas entre hash_rcu_leer y hash_rcu_terminar_lectura.
+ */
+typedef struct hash_rcu hash_rcu_t;
+typedef struct hash_rcu_lector hash_rcu_lector_t;
+
+/*
+ * Crea el hash igual que hash_crear.
+ * Devuelve un puntero al hash creado o NULL en caso de no poder crearlo.
+ */
+hash_rcu_t* hash_rcu_crear(hash_destruir_dato_t destruir_elemento, size_t capacidad);
+
+/*
+ * Inserta un elemento o reemplaza el de una clave existente. El
+ * elemento reemplazado se destruye cuando ya no lo puede estar leyendo
+ * ningun lector.
+ * Al agrandarse la tabla los mismos nodos se reparten entre los baldes
+ * nuevos sin copiarlos, esperando entre paso y paso a que terminen las
+ * lecturas en curso; por eso no puede llamarse desde un hilo que esta
+ * dentro de una lectura.
+ * Devuelve 0 si pudo guardarlo o -1 si no pudo.
+ */
+int hash_rcu_insertar(hash_rcu_t* hash, const char* clave, void* elemento);
+
+/*
+ * Quita un elemento del hash. El destructor se invoca con el elemento
+ * cuando ya no lo puede estar leyendo ningun lector.
+ * Devuelve 0 si pudo eliminar el elemento o -1 si no pudo.
+ */
+int hash_rcu_quitar(hash_rcu_t* hash, const char* clave);
+
+/*
+ * Devuelve la cantidad de elementos almacenados en el hash.
+ */
+size_t hash_rcu_cantidad(hash_rcu_t* hash);
+
+/*
+ * Registra al hilo que la llama como lector del hash. El lector
+ * devuelto solo puede usarlo ese hilo.
+ * Devuelve el lector o NULL en caso de error.
+ */
+hash_rcu_lector_t* hash_rcu_registrar_lector(hash_rcu_t* hash);
+
+/*
+ * Da de baja al lector, que no puede estar dentro de una lectura.
+ */
+void hash_rcu_desregistrar_lector(hash_rcu_lector_t* lector);
+
+/*
+ * Empieza una lectura. Los elementos obtenidos hasta llamar a
+ * hash_rcu_terminar_lectura no se destruyen aunque otro hilo los
+ * quite o reemplace.
+ */
+void hash_rcu_leer(hash_rcu_lector_t* lector);
+
+/*
+ * Termina la lectura empezada con hash_rcu_leer.
+ */
+void hash_rcu_terminar_lectura(hash_rcu_lector_t* lector);
+
+/*
+ * Devuelve el elemento con la clave dada o NULL si no existe. Solo se
+ * puede llamar dentro de una lectura, y el elemento devuelto es valido
+ * hasta que esta termine.
+ */
+void* hash_rcu_obtener(hash_rcu_lector_t* lector, const char* clave);
+
+/*
+ * Devuelve true si el hash contiene la clave o false en caso contrario.
+ * Solo se puede llamar dentro de una lectura.
+ */
+bool hash_rcu_contiene(hash_rcu_lector_t* lector, const char* clave);
+
+/*
+ * Destruye el hash invocando al destructor con cada elemento, incluidos
+ * los quitados que todavia esperaban. Ningun otro hilo puede estar
+ * usandolo.
+ */
+void hash_rcu_destruir(hash_rcu_t* hash);
+
+#endif /* __HASH_RCU_H__ */
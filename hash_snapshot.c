@@ -0,0 +1,604 @@
+#define _DEFAULT_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hash_interno.h"
+
+/*
+ * Formato del snapshot. Todos los enteros estan en el orden de bytes de
+ * la maquina que lo guardo y todas las posiciones son desplazamientos
+ * desde el comienzo del archivo, asi puede proyectarse en cualquier
+ * direccion:
+ *
+ *   cabecera_snapshot_t
+ *   uint64_t inicios[capacidad + 1]   registros del balde b: [inicios[b], inicios[b + 1])
+ *   registros, agrupados por balde
+ *
+ * Cada registro es un registro_snapshot_t seguido de la clave con su
+ * '\0' y de los bytes del elemento, ambos completados hasta un multiplo
+ * de 8 para que el elemento quede alineado.
+ */
+
+#define MAGIA_SNAPSHOT "TDAHASH1"
+#define ORDEN_SNAPSHOT 0x01020304u
+
+#define FUNCION_RAPIDA 0
+#define FUNCION_SIPHASH 1
+#define FUNCION_PROPIA 2
+
+#define VENTANA_MINIMA_SNAPSHOT (1024 * 1024)
+#define PASADAS_MAXIMAS_SNAPSHOT 8
+
+typedef struct cabecera_snapshot{
+	char magia[8];
+	uint32_t orden;
+	uint32_t funcion;
+	uint64_t semilla;
+	uint64_t cantidad;
+	uint64_t capacidad;
+	uint64_t tamanio;
+}cabecera_snapshot_t;
+
+typedef struct registro_snapshot{
+	uint64_t hash;
+	uint64_t largo_clave;
+	uint64_t largo_elemento;
+	char clave[];
+}registro_snapshot_t;
+
+// pre:
+// pos: devuelve tamanio redondeado hacia arriba a un multiplo de 8
+size_t alinear_a_8(size_t tamanio){
+
+	return (tamanio + 7) & ~(size_t)7;
+}
+
+// pre:
+// pos: devuelve cuantos bytes ocupa un registro con esa clave y ese elemento
+size_t tamanio_registro(size_t largo_clave, size_t largo_elemento){
+
+	return sizeof(registro_snapshot_t) + alinear_a_8(largo_clave + 1) + alinear_a_8(largo_elemento);
+}
+
+// pre: registro es distinto de NULL
+// pos: devuelve el elemento del registro dentro del archivo, o NULL si se guardo sin bytes
+void* elemento_del_registro(const registro_snapshot_t* registro){
+
+	if(registro->largo_elemento == 0)
+		return NULL;
+
+	return (void*)(registro->clave + alinear_a_8(registro->largo_clave + 1));
+}
+
+// pre: mapa es el snapshot proyectado y posicion <= fin <= tamanio del mapa
+// pos: devuelve cuantos bytes ocupa el registro que empieza en posicion, o 0 si sus largos no entran antes de fin o su clave no termina en '\0'. Las cuentas no pueden desbordarse aunque el archivo este corrupto
+size_t tamanio_registro_valido(const uint8_t* mapa, uint64_t posicion, uint64_t fin){
+
+	if(fin - posicion < sizeof(registro_snapshot_t))
+		return 0;
+
+	const registro_snapshot_t* registro = (const registro_snapshot_t*)(mapa + posicion);
+	uint64_t disponible = fin - posicion - sizeof(registro_snapshot_t);
+
+	if(registro->largo_clave >= disponible)
+		return 0;
+	uint64_t bytes_clave = alinear_a_8((size_t)registro->largo_clave + 1);
+	if(bytes_clave > disponible || registro->clave[registro->largo_clave] != '\0')
+		return 0;
+
+	disponible -= bytes_clave;
+	if(registro->largo_elemento > disponible || alinear_a_8((size_t)registro->largo_elemento) > disponible)
+		return 0;
+
+	return tamanio_registro((size_t)registro->largo_clave, (size_t)registro->largo_elemento);
+}
+
+// pre: hash es distinto de NULL
+// pos: devuelve el registro con esa clave o NULL si no esta
+const registro_snapshot_t* snapshot_ubicar(const hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash){
+
+	size_t balde = (size_t)(valor_hash & (hash->capacidad - 1));
+	uint64_t posicion = hash->inicios[balde];
+	uint64_t fin = hash->inicios[balde + 1];
+
+	while(posicion < fin){
+		size_t tamanio = tamanio_registro_valido(hash->mapa, posicion, fin);
+		if(tamanio == 0)
+			return NULL;
+		const registro_snapshot_t* registro = (const registro_snapshot_t*)(hash->mapa + posicion);
+		posicion += tamanio;
+		if(registro->hash == valor_hash && registro->largo_clave == largo && memcmp(registro->clave, clave, largo) == 0)
+			return registro;
+	}
+
+	return NULL;
+}
+
+// pre: hash es distinto de NULL
+// pos: un snapshot solo se crea con hash_abrir_snapshot; devuelve false
+bool snapshot_crear(hash_t* hash, size_t capacidad){
+
+	(void)hash;
+	(void)capacidad;
+
+	return false;
+}
+
+// pre: hash, clave e insertado son distintos de NULL
+// pos: el snapshot es de solo lectura; devuelve NULL
+void** snapshot_buscar_o_insertar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash, bool* insertado){
+
+	(void)hash;
+	(void)clave;
+	(void)largo;
+	(void)valor_hash;
+	*insertado = false;
+
+	return NULL;
+}
+
+// pre: hash y clave son distintos de NULL
+// pos: el snapshot es de solo lectura; devuelve -1
+int snapshot_quitar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash){
+
+	(void)hash;
+	(void)clave;
+	(void)largo;
+	(void)valor_hash;
+
+	return ERROR;
+}
+
+// pre: hash y clave son distintos de NULL y valor_hash es el hash de la clave
+// pos: devuelve true si la clave esta, dejando en elemento (si no es NULL) un puntero a su elemento dentro del archivo
+bool snapshot_buscar(hash_t* hash, const void* clave, size_t largo, uint64_t valor_hash, void** elemento){
+
+	const registro_snapshot_t* registro = snapshot_ubicar(hash, clave, largo, valor_hash);
+	if(!registro)
+		return false;
+
+	if(elemento)
+		*elemento = elemento_del_registro(registro);
+
+	return true;
+}
+
+// pre: hash es distinto de NULL
+// pos: el snapshot es de solo lectura; devuelve -1
+int snapshot_reservar(hash_t* hash, size_t cantidad){
+
+	(void)hash;
+	(void)cantidad;
+
+	return ERROR;
+}
+
+// pre: hash es distinto de NULL
+// pos: deja de proyectar el archivo
+void snapshot_destruir(hash_t* hash){
+
+	munmap((void*)hash->mapa, hash->tamanio_mapa);
+}
+
+// pre: hash es distinto de NULL
+// pos: pide a cache el inicio del balde que le corresponde a valor_hash
+void snapshot_anticipar_balde(const hash_t* hash, uint64_t valor_hash){
+
+	ANTICIPAR(&hash->inicios[valor_hash & (hash->capacidad - 1)]);
+}
+
+// pre: hash es distinto de NULL
+// pos: pide a cache el primer registro del balde que le corresponde a valor_hash
+void snapshot_anticipar_elemento(const hash_t* hash, uint64_t valor_hash){
+
+	uint64_t posicion = hash->inicios[valor_hash & (hash->capacidad - 1)];
+	if(posicion < hash->tamanio_mapa)
+		ANTICIPAR(hash->mapa + posicion);
+}
+
+// pre: cursor es distinto de NULL
+// pos: posiciona el cursor en el primer registro
+void snapshot_cursor_iniciar(hash_cursor_t* cursor){
+
+	cursor->posicion = (size_t)cursor->hash->inicios[0];
+}
+
+// pre: cursor, clave, largo y elemento son distintos de NULL
+// pos: devuelve el proximo registro y avanza el cursor, o false si no habia mas
+bool snapshot_cursor_siguiente(hash_cursor_t* cursor, const char** clave, size_t* largo, void** elemento){
+
+	const hash_t* hash = cursor->hash;
+	size_t tamanio = 0;
+	if(cursor->posicion < hash->inicios[hash->capacidad])
+		tamanio = tamanio_registro_valido(hash->mapa, cursor->posicion, hash->inicios[hash->capacidad]);
+	if(tamanio == 0){
+		cursor->actual = NULL;
+		return false;
+	}
+
+	const registro_snapshot_t* registro = (const registro_snapshot_t*)(hash->mapa + cursor->posicion);
+	cursor->posicion += tamanio;
+	cursor->actual = (void*)registro;
+
+	*clave = registro->clave;
+	*largo = registro->largo_clave;
+	*elemento = elemento_del_registro(registro);
+	cursor->valor_hash = registro->hash;
+
+	return true;
+}
+
+// pre: cursor es distinto de NULL
+// pos: el snapshot es de solo lectura; devuelve -1
+int snapshot_cursor_quitar(hash_cursor_t* cursor){
+
+	(void)cursor;
+
+	return ERROR;
+}
+
+// pre: hash y estadisticas son distintos de NULL
+// pos: agrega a las estadisticas la cantidad de registros de cada balde y la memoria del archivo proyectado
+void snapshot_estadisticas(hash_t* hash, hash_estadisticas_t* estadisticas){
+
+	estadisticas->bytes_baldes = sizeof(cabecera_snapshot_t) + (hash->capacidad + 1) * sizeof(uint64_t);
+
+	for(size_t balde = 0; balde < hash->capacidad; balde++){
+
+		uint64_t posicion = hash->inicios[balde];
+		uint64_t fin = hash->inicios[balde + 1];
+		size_t largo = 0;
+
+		while(posicion < fin){
+			size_t tamanio = tamanio_registro_valido(hash->mapa, posicion, fin);
+			if(tamanio == 0)
+				break;
+			const registro_snapshot_t* registro = (const registro_snapshot_t*)(hash->mapa + posicion);
+			posicion += tamanio;
+			largo++;
+			estadisticas->bytes_entradas += tamanio - (registro->largo_clave + 1);
+			estadisticas->bytes_claves += registro->largo_clave + 1;
+		}
+
+		hash_contar_cadena(estadisticas, largo);
+	}
+}
+
+const hash_operaciones_t OPERACIONES_SNAPSHOT = {
+	.crear = snapshot_crear,
+	.buscar_o_insertar = snapshot_buscar_o_insertar,
+	.quitar = snapshot_quitar,
+	.buscar = snapshot_buscar,
+	.reservar = snapshot_reservar,
+	.destruir = snapshot_destruir,
+	.anticipar_balde = snapshot_anticipar_balde,
+	.anticipar_elemento = snapshot_anticipar_elemento,
+	.cursor_iniciar = snapshot_cursor_iniciar,
+	.cursor_siguiente = snapshot_cursor_siguiente,
+	.cursor_quitar = snapshot_cursor_quitar,
+	.estadisticas = snapshot_estadisticas
+};
+
+// pre: elemento es un string o NULL
+// pos: devuelve cuantos bytes ocupa el string con su '\0', o 0 si es NULL
+size_t tamanio_string(const void* elemento){
+
+	return elemento ? strlen(elemento) + 1 : 0;
+}
+
+// pre:
+// pos: devuelve con que codigo se guarda la funcion de hash en el snapshot
+uint32_t codigo_de_funcion(hash_funcion_t funcion){
+
+	if(funcion == hash_funcion_rapida)
+		return FUNCION_RAPIDA;
+	if(funcion == hash_funcion_siphash)
+		return FUNCION_SIPHASH;
+
+	return FUNCION_PROPIA;
+}
+
+// pre: ruta es distinto de NULL
+// pos: lleva a disco el directorio que contiene ruta, para que sobrevivan a un corte de luz los archivos creados o renombrados en el. Devuelve 0 si pudo o -1 si no
+int sincronizar_directorio(const char* ruta){
+
+	const char* barra = strrchr(ruta, '/');
+	char* directorio;
+	if(!barra)
+		directorio = strdup(".");
+	else if(barra == ruta)
+		directorio = strdup("/");
+	else
+		directorio = strndup(ruta, (size_t)(barra - ruta));
+	if(!directorio)
+		return ERROR;
+
+	int descriptor = open(directorio, O_RDONLY | O_DIRECTORY);
+	free(directorio);
+	if(descriptor < 0)
+		return ERROR;
+
+	bool sincronizado = fsync(descriptor) == 0;
+	close(descriptor);
+
+	return sincronizado ? EXITO : ERROR;
+}
+
+// pre: ruta y temporal son distintos de NULL
+// pos: crea para escribir un archivo aparte junto a ruta, con un nombre que no usa nadie mas, y deja ese nombre en temporal. Devuelve NULL si no pudo
+FILE* abrir_temporal(const char* ruta, char** temporal){
+
+	*temporal = malloc(strlen(ruta) + sizeof(".XXXXXX"));
+	if(!*temporal)
+		return NULL;
+	sprintf(*temporal, "%s.XXXXXX", ruta);
+
+	// Dos escrituras de la misma ruta a la vez no pueden pisarse el archivo a medias
+	FILE* archivo = NULL;
+	int descriptor = mkstemp(*temporal);
+	if(descriptor >= 0 && fchmod(descriptor, 0644) == 0)
+		archivo = fdopen(descriptor, "wb");
+
+	if(!archivo){
+		if(descriptor >= 0){
+			close(descriptor);
+			remove(*temporal);
+		}
+		free(*temporal);
+		*temporal = NULL;
+	}
+
+	return archivo;
+}
+
+// pre: archivo y temporal son los que devolvio abrir_temporal para ruta
+// pos: si escrito es true lleva el archivo a disco y recien entonces lo renombra a ruta, sincronizando tambien el directorio para que el renombre no se pierda; si no, o si algo de eso falla, lo borra. Libera temporal. Devuelve 0 si pudo o -1 si no
+int cerrar_temporal(FILE* archivo, char* temporal, const char* ruta, bool escrito){
+
+	escrito = escrito && fflush(archivo) == 0 && fsync(fileno(archivo)) == 0;
+	escrito = fclose(archivo) == 0 && escrito;
+	escrito = escrito && rename(temporal, ruta) == 0;
+	if(!escrito)
+		remove(temporal);
+	escrito = escrito && sincronizar_directorio(ruta) == EXITO;
+
+	free(temporal);
+
+	return escrito ? EXITO : ERROR;
+}
+
+// pre: inicios tiene las posiciones acumuladas de los capacidad baldes y desde < capacidad
+// pos: devuelve el balde siguiente al ultimo de la ventana que empieza en desde: la ventana suma baldes mientras sus registros entren en ventana bytes, pero siempre tiene al menos uno
+size_t fin_de_ventana(const uint64_t* inicios, size_t capacidad, size_t desde, size_t ventana){
+
+	size_t hasta = desde + 1;
+	while(hasta < capacidad && inicios[hasta + 1] - inicios[desde] <= ventana)
+		hasta++;
+
+	return hasta;
+}
+
+/*
+ * Guarda en el archivo ruta una copia del hash que hash_abrir_snapshot
+ * puede usar sin reconstruirla: en lugar de punteros guarda
+ * desplazamientos dentro del archivo, y cada clave se guarda junto con
+ * los bytes de su elemento.
+ * tamanio_elemento devuelve cuantos bytes del elemento guardar; si es
+ * NULL los elementos se guardan como strings (incluyendo el '\0'). Un
+ * elemento NULL o de 0 bytes se lee como NULL.
+ * El archivo se escribe aparte y reemplaza a ruta recien cuando esta
+ * completo. Solo puede leerse en maquinas con el mismo orden de bytes.
+ * Los registros se arman en memoria de a partes de 1 MiB o de un octavo
+ * del archivo (la mayor), recorriendo el hash una vez por parte; nunca
+ * se arma el archivo entero en memoria.
+ * Devuelve 0 si pudo guardarlo o -1 si no pudo.
+ */
+int hash_guardar_snapshot(hash_t* hash, const char* ruta, hash_tamanio_dato_t tamanio_elemento){
+
+	if(!hash || !ruta)
+		return ERROR;
+
+	if(!tamanio_elemento)
+		tamanio_elemento = tamanio_string;
+
+	size_t capacidad = 1;
+	while(capacidad < hash->cantidad_elementos)
+		capacidad <<= 1;
+
+	uint64_t* inicios = calloc(capacidad + 1, sizeof(uint64_t));
+	uint64_t* posiciones = malloc(capacidad * sizeof(uint64_t));
+	if(!inicios || !posiciones){
+		free(inicios);
+		free(posiciones);
+		return ERROR;
+	}
+
+	// Primera pasada: cuantos bytes ocupa cada balde. Cada entrada ya tiene guardado su
+	// hash, asi que no hace falta volver a calcularlo
+	hash_cursor_t cursor;
+	const char* clave;
+	size_t largo;
+	void* elemento;
+	size_t cantidad = 0;
+
+	hash_cursor_iniciar(&cursor, hash);
+	while(hash_cursor_siguiente(&cursor, &clave, &largo, &elemento)){
+		inicios[(cursor.valor_hash & (capacidad - 1)) + 1] += tamanio_registro(largo, tamanio_elemento(elemento));
+		cantidad++;
+	}
+
+	inicios[0] = sizeof(cabecera_snapshot_t) + (capacidad + 1) * sizeof(uint64_t);
+	for(size_t i = 0; i < capacidad; i++)
+		inicios[i + 1] += inicios[i];
+	size_t tamanio = (size_t)inicios[capacidad];
+
+	// Los registros se arman de a ventanas de baldes consecutivos, recorriendo el hash una
+	// vez por ventana, para no tener nunca la imagen entera en memoria
+	size_t ventana = (tamanio - (size_t)inicios[0]) / PASADAS_MAXIMAS_SNAPSHOT;
+	if(ventana < VENTANA_MINIMA_SNAPSHOT)
+		ventana = VENTANA_MINIMA_SNAPSHOT;
+
+	size_t mayor_ventana = 0;
+	for(size_t desde = 0, hasta; desde < capacidad; desde = hasta){
+		hasta = fin_de_ventana(inicios, capacidad, desde, ventana);
+		if(inicios[hasta] - inicios[desde] > mayor_ventana)
+			mayor_ventana = (size_t)(inicios[hasta] - inicios[desde]);
+	}
+
+	char* temporal = NULL;
+	uint8_t* datos = malloc(mayor_ventana + 1);
+	FILE* archivo = datos ? abrir_temporal(ruta, &temporal) : NULL;
+	if(!archivo){
+		free(datos);
+		free(inicios);
+		free(posiciones);
+		return ERROR;
+	}
+
+	cabecera_snapshot_t cabecera = {
+		.orden = ORDEN_SNAPSHOT,
+		.funcion = codigo_de_funcion(hash->funcion),
+		.semilla = hash->semilla,
+		.cantidad = cantidad,
+		.capacidad = capacidad,
+		.tamanio = tamanio
+	};
+	memcpy(cabecera.magia, MAGIA_SNAPSHOT, sizeof(cabecera.magia));
+
+	bool escrito = fwrite(&cabecera, sizeof(cabecera), 1, archivo) == 1 && fwrite(inicios, sizeof(uint64_t), capacidad + 1, archivo) == capacidad + 1;
+
+	// Siguientes pasadas: cada registro de la ventana a continuacion de los anteriores de su balde
+	for(size_t desde = 0, hasta; escrito && desde < capacidad; desde = hasta){
+
+		hasta = fin_de_ventana(inicios, capacidad, desde, ventana);
+		size_t bytes = (size_t)(inicios[hasta] - inicios[desde]);
+		if(bytes == 0)
+			continue;
+
+		memset(datos, 0, bytes);
+		for(size_t balde = desde; balde < hasta; balde++)
+			posiciones[balde] = inicios[balde] - inicios[desde];
+
+		hash_cursor_iniciar(&cursor, hash);
+		while(hash_cursor_siguiente(&cursor, &clave, &largo, &elemento)){
+			size_t balde = (size_t)(cursor.valor_hash & (capacidad - 1));
+			if(balde < desde || balde >= hasta)
+				continue;
+
+			size_t largo_elemento = tamanio_elemento(elemento);
+			registro_snapshot_t* registro = (registro_snapshot_t*)(datos + posiciones[balde]);
+			registro->hash = cursor.valor_hash;
+			registro->largo_clave = largo;
+			registro->largo_elemento = largo_elemento;
+			memcpy(registro->clave, clave, largo);
+			if(largo_elemento > 0)
+				memcpy(registro->clave + alinear_a_8(largo + 1), elemento, largo_elemento);
+
+			posiciones[balde] += tamanio_registro(largo, largo_elemento);
+		}
+
+		escrito = fwrite(datos, 1, bytes, archivo) == bytes;
+	}
+
+	int resultado = cerrar_temporal(archivo, temporal, ruta, escrito);
+
+	free(datos);
+	free(inicios);
+	free(posiciones);
+
+	return resultado;
+}
+
+// pre: mapa tiene al menos tamanio bytes
+// pos: devuelve true si la cabecera es de un snapshot completo y coherente con el tamanio del archivo, y los inicios de los baldes van desde el final de la tabla de inicios hasta el final del archivo sin retroceder y alineados a 8
+bool cabecera_valida(const cabecera_snapshot_t* cabecera, size_t tamanio){
+
+	if(memcmp(cabecera->magia, MAGIA_SNAPSHOT, sizeof(cabecera->magia)) != 0 || cabecera->orden != ORDEN_SNAPSHOT)
+		return false;
+
+	if(cabecera->tamanio != tamanio || cabecera->funcion > FUNCION_PROPIA)
+		return false;
+
+	if(cabecera->capacidad == 0 || (cabecera->capacidad & (cabecera->capacidad - 1)) != 0)
+		return false;
+
+	if(cabecera->capacidad >= (tamanio - sizeof(cabecera_snapshot_t)) / sizeof(uint64_t))
+		return false;
+
+	size_t capacidad = (size_t)cabecera->capacidad;
+	const uint64_t* inicios = (const uint64_t*)((const uint8_t*)cabecera + sizeof(cabecera_snapshot_t));
+	if(inicios[0] != sizeof(cabecera_snapshot_t) + (capacidad + 1) * sizeof(uint64_t) || inicios[capacidad] != tamanio)
+		return false;
+
+	for(size_t i = 0; i < capacidad; i++){
+		if(inicios[i + 1] < inicios[i] || inicios[i + 1] % 8 != 0)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Abre un snapshot guardado con hash_guardar_snapshot proyectandolo en
+ * memoria con mmap: no lee el archivo ni inserta ninguna clave, y las
+ * paginas se cargan recien cuando una busqueda las necesita.
+ * El hash devuelto es de solo lectura: hash_obtener, hash_contiene, los
+ * lotes de consulta, el iterador y el cursor funcionan igual que con
+ * cualquier hash, pero insertar, quitar o reservar devuelven error. Los
+ * elementos que devuelve apuntan dentro del archivo proyectado, no deben
+ * modificarse y son validos hasta destruir el hash con hash_destruir.
+ * funcion solo se usa si el snapshot se guardo con una funcion de hash
+ * propia, y debe ser esa misma funcion.
+ * Devuelve el hash o NULL si no pudo abrir el archivo o no es un
+ * snapshot valido.
+ */
+hash_t* hash_abrir_snapshot(const char* ruta, hash_funcion_t funcion){
+
+	if(!ruta)
+		return NULL;
+
+	int descriptor = open(ruta, O_RDONLY);
+	if(descriptor < 0)
+		return NULL;
+
+	struct stat estado;
+	if(fstat(descriptor, &estado) != 0 || (size_t)estado.st_size < sizeof(cabecera_snapshot_t)){
+		close(descriptor);
+		return NULL;
+	}
+
+	size_t tamanio = (size_t)estado.st_size;
+	void* mapa = mmap(NULL, tamanio, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+	if(mapa == MAP_FAILED)
+		return NULL;
+
+	// Las busquedas saltan a cualquier parte del archivo: leer por adelantado no sirve
+	madvise(mapa, tamanio, MADV_RANDOM);
+
+	const cabecera_snapshot_t* cabecera = mapa;
+	hash_t* hash = NULL;
+	if(cabecera_valida(cabecera, tamanio) && (cabecera->funcion != FUNCION_PROPIA || funcion)){
+		if(cabecera->funcion == FUNCION_RAPIDA)
+			funcion = hash_funcion_rapida;
+		else if(cabecera->funcion == FUNCION_SIPHASH)
+			funcion = hash_funcion_siphash;
+		hash = hash_nuevo(&OPERACIONES_SNAPSHOT, funcion, cabecera->semilla, (size_t)cabecera->capacidad, NULL);
+	}
+
+	if(!hash){
+		munmap(mapa, tamanio);
+		return NULL;
+	}
+
+	hash->cantidad_elementos = (size_t)cabecera->cantidad;
+	hash->mapa = mapa;
+	hash->tamanio_mapa = tamanio;
+	hash->inicios = (const uint64_t*)((const uint8_t*)mapa + sizeof(cabecera_snapshot_t));
+
+	return hash;
+}
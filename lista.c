@@ -17,6 +17,7 @@ struct lista{
     nodo_t* nodo_inicio;
 	nodo_t* nodo_fin;
 	size_t tamanio;
+	slab_t* slab;
 };
 
 struct lista_iterador{
@@ -30,7 +31,18 @@ struct lista_iterador{
  */
 lista_t* lista_crear(){
 
-	lista_t* lista = malloc(sizeof(lista_t));
+	return lista_crear_en_slab(NULL);
+}
+
+/*
+ * Crea la lista igual que lista_crear pero tomando la memoria de la
+ * lista y de sus nodos del asignador dado. Si slab es NULL se comporta
+ * igual que lista_crear.
+ * Devuelve un puntero a la lista creada o NULL en caso de error.
+ */
+lista_t* lista_crear_en_slab(slab_t* slab){
+
+	lista_t* lista = slab ? slab_reservar(slab, sizeof(lista_t)) : malloc(sizeof(lista_t));
 	
 	if(!lista)
 		return NULL;
@@ -38,15 +50,16 @@ lista_t* lista_crear(){
 	lista->nodo_inicio = NULL;
 	lista->nodo_fin = NULL;
 	lista->tamanio = SIN_ELEMENTOS;
+	lista->slab = slab;
 
 	return lista;
 
 }
 // pre:
 // pos:  crea un nuevo nodo y pone el elemento en el. Devuelve NULL si hubo error.
-nodo_t* crear_nuevo_nodo(void* elemento, void* nodo_siguiente){
+nodo_t* crear_nuevo_nodo(lista_t* lista, void* elemento, void* nodo_siguiente){
 
-	nodo_t* nodo = malloc(sizeof(nodo_t));
+	nodo_t* nodo = lista->slab ? slab_reservar(lista->slab, sizeof(nodo_t)) : malloc(sizeof(nodo_t));
 	
 	if(!nodo)
 		return NULL;
@@ -57,6 +70,16 @@ nodo_t* crear_nuevo_nodo(void* elemento, void* nodo_siguiente){
 	return nodo;
 }
 
+// pre:
+// pos: libera el nodo devolviendolo a donde fue reservado
+void liberar_nodo(lista_t* lista, nodo_t* nodo){
+
+	if(lista->slab)
+		slab_liberar(lista->slab, nodo, sizeof(nodo_t));
+	else
+		free(nodo);
+}
+
 // pre: posicion es mayor a 0
 // pos: devuelve un puntero al nodo posicion
 nodo_t* obtener_puntero_a_nodo(lista_t* lista, size_t posicion){
@@ -65,7 +88,7 @@ nodo_t* obtener_puntero_a_nodo(lista_t* lista, size_t posicion){
 		return NULL;
 
 	nodo_t* aux = lista->nodo_inicio;
-	int i = 0;
+	size_t i = 0;
 
 	while(i < posicion){
 		
@@ -85,7 +108,7 @@ int lista_insertar(lista_t* lista, void* elemento){
 	if(!lista)
 		return ERROR;
 
-	nodo_t* nodo = crear_nuevo_nodo(elemento, NULL);
+	nodo_t* nodo = crear_nuevo_nodo(lista, elemento, NULL);
 	if(!nodo)
 		return ERROR;
 
@@ -124,7 +147,7 @@ int lista_insertar_primero(lista_t* lista, void* elemento){
 	if(!lista)
 		return ERROR;
 
-	nodo_t* aux = crear_nuevo_nodo(elemento, lista->nodo_inicio);
+	nodo_t* aux = crear_nuevo_nodo(lista, elemento, lista->nodo_inicio);
 	if(!aux)
 		return ERROR;
 
@@ -154,7 +177,7 @@ int lista_insertar_en_posicion(lista_t* lista, void* elemento, size_t posicion){
 	if(!nodo_anterior)
 		return ERROR;
 
-	nodo_t* nuevo_nodo = crear_nuevo_nodo(elemento, nodo_anterior->siguiente);
+	nodo_t* nuevo_nodo = crear_nuevo_nodo(lista, elemento, nodo_anterior->siguiente);
 	if(!nuevo_nodo)
 		return ERROR;
 
@@ -173,7 +196,7 @@ int lista_borrar(lista_t* lista){
 	if(!lista || lista_vacia(lista))
 		return ERROR;
 
-	free(lista->nodo_fin);
+	liberar_nodo(lista, lista->nodo_fin);
 	lista->tamanio--;
 	
 	if(reasignar_punteros_limites(lista))
@@ -200,7 +223,7 @@ int lista_borrar_primero(lista_t* lista){
 	nodo_t* aux = lista->nodo_inicio;		
 	lista->nodo_inicio = aux->siguiente;
 	
-	free(aux);
+	liberar_nodo(lista, aux);
 	lista->tamanio--;
 	
 	return EXITO;
@@ -230,9 +253,11 @@ int lista_borrar_de_posicion(lista_t* lista, size_t posicion){
 
 	nodo_t* nodo_a_borrar = nodo_anterior->siguiente;
 	nodo_anterior->siguiente = nodo_a_borrar->siguiente;
+	if(nodo_a_borrar == lista->nodo_fin)
+		lista->nodo_fin = nodo_anterior;
 	
 	lista->tamanio--;
-	free(nodo_a_borrar);
+	liberar_nodo(lista, nodo_a_borrar);
 	reasignar_punteros_limites(lista);
 
 	return EXITO;
@@ -291,6 +316,18 @@ size_t lista_elementos(lista_t* lista){
 
 }
 
+/*
+ * Devuelve la cantidad de bytes que ocupan la lista y sus nodos, sin
+ * contar los elementos.
+ */
+size_t lista_memoria(lista_t* lista){
+
+	if(!lista)
+		return 0;
+
+	return sizeof(lista_t) + lista->tamanio * sizeof(nodo_t);
+}
+
 // pre: 
 // pos: vacia toda la lista. Si lista no existe no hace nada
 void lista_vaciar(lista_t* lista){
@@ -303,6 +340,35 @@ void lista_vaciar(lista_t* lista){
 	
 }
 
+/*
+ * Pasa el primer nodo de origen al final de destino sin reservar ni
+ * liberar memoria, asi que no puede fallar por falta de memoria. Ambas
+ * listas tienen que tomar sus nodos del mismo asignador (el mismo slab,
+ * o ninguno). Origen y destino pueden ser la misma lista.
+ * Devuelve 0 si pudo o -1 si origen esta vacia.
+ */
+int lista_mover_primero(lista_t* origen, lista_t* destino){
+
+	if(!origen || !destino || lista_vacia(origen))
+		return ERROR;
+
+	nodo_t* nodo = origen->nodo_inicio;
+	origen->nodo_inicio = nodo->siguiente;
+	if(!origen->nodo_inicio)
+		origen->nodo_fin = NULL;
+	origen->tamanio--;
+
+	nodo->siguiente = NULL;
+	if(destino->nodo_fin)
+		destino->nodo_fin->siguiente = nodo;
+	else
+		destino->nodo_inicio = nodo;
+	destino->nodo_fin = nodo;
+	destino->tamanio++;
+
+	return EXITO;
+}
+
 /*
  * Libera la memoria reservada por la lista.
  */
@@ -314,7 +380,10 @@ void lista_destruir(lista_t* lista){
 	if(!lista_vacia(lista))
 		lista_vaciar(lista);
 
-	free(lista);
+	if(lista->slab)
+		slab_liberar(lista->slab, lista, sizeof(lista_t));
+	else
+		free(lista);
 }
 
 /*
@@ -389,6 +458,74 @@ void lista_iterador_destruir(lista_iterador_t* iterador){
 	free(iterador);
 }
 
+/*
+ * Inicia un cursor sobre la lista. A diferencia del iterador, el cursor
+ * no reserva memoria: se declara donde se lo use (por ejemplo en la
+ * pila) y es valido mientras no se modifique la lista, salvo con
+ * lista_cursor_quitar.
+ */
+void lista_cursor_iniciar(lista_t* lista, lista_cursor_t* cursor){
+
+	if(!cursor)
+		return;
+
+	cursor->lista = lista;
+	cursor->anterior = NULL;
+	cursor->actual = NULL;
+}
+
+/*
+ * Devuelve en elemento el proximo elemento de la lista y avanza el
+ * cursor. Devuelve false si no habia mas elementos.
+ */
+bool lista_cursor_siguiente(lista_cursor_t* cursor, void** elemento){
+
+	if(!cursor || !cursor->lista)
+		return false;
+
+	nodo_t* anterior = cursor->actual ? cursor->actual : cursor->anterior;
+	nodo_t* proximo = anterior ? anterior->siguiente : cursor->lista->nodo_inicio;
+	if(!proximo)
+		return false;
+
+	cursor->anterior = anterior;
+	cursor->actual = proximo;
+	*elemento = proximo->elemento;
+
+	return true;
+}
+
+/*
+ * Quita de la lista el ultimo elemento devuelto por el cursor, sin
+ * volver a recorrerla, y lo devuelve en elemento. El cursor sigue
+ * siendo valido y continua por el elemento que seguia al quitado.
+ * Devuelve false si no habia elemento para quitar.
+ */
+bool lista_cursor_quitar(lista_cursor_t* cursor, void** elemento){
+
+	if(!cursor || !cursor->actual)
+		return false;
+
+	lista_t* lista = cursor->lista;
+	nodo_t* anterior = cursor->anterior;
+	nodo_t* actual = cursor->actual;
+
+	if(anterior)
+		anterior->siguiente = actual->siguiente;
+	else
+		lista->nodo_inicio = actual->siguiente;
+
+	if(lista->nodo_fin == actual)
+		lista->nodo_fin = anterior;
+
+	lista->tamanio--;
+	*elemento = actual->elemento;
+	liberar_nodo(lista, actual);
+	cursor->actual = NULL;
+
+	return true;
+}
+
 /*
  * Iterador interno. Recorre la lista e invoca la funcion con cada
  * elemento de la misma.
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include "slab.h"
 
 
 typedef struct lista lista_t;
@@ -10,12 +11,27 @@ typedef struct lista lista_t;
 
 typedef struct lista_iterador lista_iterador_t;
 
+/* Cursor de la lista. Sus campos son privados. */
+typedef struct lista_cursor{
+	lista_t* lista;
+	void* anterior;
+	void* actual;
+}lista_cursor_t;
+
 /*
  * Crea la lista reservando la memoria necesaria.
  * Devuelve un puntero a la lista creada o NULL en caso de error.
  */
 lista_t* lista_crear();
 
+/*
+ * Crea la lista igual que lista_crear pero tomando la memoria de la
+ * lista y de sus nodos del asignador dado. Si slab es NULL se comporta
+ * igual que lista_crear.
+ * Devuelve un puntero a la lista creada o NULL en caso de error.
+ */
+lista_t* lista_crear_en_slab(slab_t* slab);
+
 /*
  * Inserta un elemento al final de la lista.
  * Devuelve 0 si pudo insertar o -1 si no pudo.
@@ -69,6 +85,21 @@ bool lista_vacia(lista_t* lista);
  */
 size_t lista_elementos(lista_t* lista);
 
+/*
+ * Devuelve la cantidad de bytes que ocupan la lista y sus nodos, sin
+ * contar los elementos.
+ */
+size_t lista_memoria(lista_t* lista);
+
+/*
+ * Pasa el primer nodo de origen al final de destino sin reservar ni
+ * liberar memoria, asi que no puede fallar por falta de memoria. Ambas
+ * listas tienen que tomar sus nodos del mismo asignador (el mismo slab,
+ * o ninguno). Origen y destino pueden ser la misma lista.
+ * Devuelve 0 si pudo o -1 si origen esta vacia.
+ */
+int lista_mover_primero(lista_t* origen, lista_t* destino);
+
 /*
  * Libera la memoria reservada por la lista.
  */
@@ -101,6 +132,28 @@ void* lista_iterador_siguiente(lista_iterador_t* iterador);
  */
 void lista_iterador_destruir(lista_iterador_t* iterador);
 
+/*
+ * Inicia un cursor sobre la lista. A diferencia del iterador, el cursor
+ * no reserva memoria: se declara donde se lo use (por ejemplo en la
+ * pila) y es valido mientras no se modifique la lista, salvo con
+ * lista_cursor_quitar.
+ */
+void lista_cursor_iniciar(lista_t* lista, lista_cursor_t* cursor);
+
+/*
+ * Devuelve en elemento el proximo elemento de la lista y avanza el
+ * cursor. Devuelve false si no habia mas elementos.
+ */
+bool lista_cursor_siguiente(lista_cursor_t* cursor, void** elemento);
+
+/*
+ * Quita de la lista el ultimo elemento devuelto por el cursor, sin
+ * volver a recorrerla, y lo devuelve en elemento. El cursor sigue
+ * siendo valido y continua por el elemento que seguia al quitado.
+ * Devuelve false si no habia elemento para quitar.
+ */
+bool lista_cursor_quitar(lista_cursor_t* cursor, void** elemento);
+
 /*
  * Iterador interno. Recorre la lista e invoca la funcion con cada
  * elemento de la misma.
@@ -2,15 +2,24 @@
 #include <stdbool.h>
 #include "hash.h"
 #include "hash_iterador.h"
+#include "hash_concurrente.h"
+#include "hash_rcu.h"
+#include "hash_libre.h"
+#include "hash_durable.h"
+#include "hash_interno.h"
 #include "pruebas.h"
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #define ERROR -1
 #define EXITO 0
 #define ANSI_COLOR_GREEN   "\x1b[1m\x1b[32m"
 #define ANSI_COLOR_RESET "\x1b[0m"
 #define ANSI_COLOR_RED	"\x1b[1m\x1b[31m"
 
+#define CANTIDAD_MOTORES 3
+
+static const hash_motor_t motores[CANTIDAD_MOTORES] = {HASH_MOTOR_LISTAS, HASH_MOTOR_ABIERTO, HASH_MOTOR_ENCADENADO};
 static int failure_count = 0; 		// Contador de pruebas fallidas
 static int success_count = 0; 		// Contador de pruebas pasadas
 extern char* strdup(const char*);
@@ -135,6 +144,1324 @@ void test_iterador(){
 
 }
 
+// Prueba insercion, reemplazo, borrado, busqueda e iteracion sobre un motor
+void probar_motor(hash_motor_t motor){
+
+	hash_opciones_t opciones = {0};
+	opciones.motor = motor;
+	hash_t* hash = hash_crear_con_opciones(destruir_string, 5, &opciones);
+
+	assert_prueba("Creo un hash con el motor pedido", hash != NULL);
+	assert_prueba("Inserto un elemento, deberia devolver EXITO", hash_insertar(hash, "ABCD123BD", strdup("PRUEBA 1")) == EXITO);
+	assert_prueba("Inserto un anagrama de la clave, deberia devolver EXITO", hash_insertar(hash, "DB321DCBA", strdup("PRUEBA 2")) == EXITO);
+	assert_prueba("Cada clave conserva su elemento", strcmp(hash_obtener(hash, "ABCD123BD"), "PRUEBA 1") == 0 && strcmp(hash_obtener(hash, "DB321DCBA"), "PRUEBA 2") == 0);
+
+	hash_insertar(hash, "ABCD123BD", strdup("PRUEBA 3"));
+	assert_prueba("Inserto un elemento con misma clave, deberia reemplazarlo", strcmp(hash_obtener(hash, "ABCD123BD"), "PRUEBA 3") == 0 && hash_cantidad(hash) == 2);
+
+	char clave[20];
+	int correctamente_insertados = 0;
+	for(int i = 0; i < 1000; i++){
+		sprintf(clave, "AA%03iZZ", i);
+		if(hash_insertar(hash, clave, strdup(clave)) == EXITO)
+			correctamente_insertados++;
+	}
+	assert_prueba("Inserto 1000 elementos, la tabla deberia agrandarse sin problemas", correctamente_insertados == 1000 && hash_cantidad(hash) == 1002);
+
+	int quitados = 0;
+	for(int i = 0; i < 1000; i += 2){
+		sprintf(clave, "AA%03iZZ", i);
+		if(hash_quitar(hash, clave) == EXITO)
+			quitados++;
+	}
+	assert_prueba("Quito la mitad de los elementos", quitados == 500 && hash_cantidad(hash) == 502);
+
+	int coincidencias = 0;
+	for(int i = 0; i < 1000; i++){
+		sprintf(clave, "AA%03iZZ", i);
+		char* elemento = hash_obtener(hash, clave);
+		if((i % 2 == 0 && !elemento && !hash_contiene(hash, clave)) || (i % 2 == 1 && elemento && strcmp(elemento, clave) == 0))
+			coincidencias++;
+	}
+	assert_prueba("Solo se encuentran los elementos que no fueron quitados", coincidencias == 1000);
+
+	int cantidad_recorridos = 0;
+	hash_iterador_t* iter = hash_iterador_crear(hash);
+	while(hash_iterador_tiene_siguiente(iter)){
+		if(hash_contiene(hash, hash_iterador_siguiente(iter)))
+			cantidad_recorridos++;
+	}
+	assert_prueba("El iterador recorre todas las claves", cantidad_recorridos == 502 && hash_iterador_siguiente(iter) == NULL);
+	hash_iterador_destruir(iter);
+
+	hash_destruir(hash);
+}
+
+void test_motor_abierto(){
+
+	printf("\nTEST MOTOR ABIERTO: \n\n");
+	probar_motor(HASH_MOTOR_ABIERTO);
+}
+
+void test_motor_encadenado(){
+
+	printf("\nTEST MOTOR ENCADENADO: \n\n");
+	probar_motor(HASH_MOTOR_ENCADENADO);
+}
+
+// Funcion de hash que hace colisionar todas las claves
+uint64_t hash_constante(const void* clave, size_t largo, uint64_t semilla){
+
+	(void)clave;
+	(void)largo;
+	(void)semilla;
+
+	return 42;
+}
+
+void test_funciones_hash(){
+
+	printf("\nTEST FUNCIONES DE HASH: \n\n");
+
+	assert_prueba("Los anagramas no deberian colisionar", hash_funcion_rapida("ABC123", 6, 0) != hash_funcion_rapida("321CBA", 6, 0));
+	assert_prueba("La misma clave y semilla dan el mismo hash", hash_funcion_rapida("ABCD123BD", 9, 7) == hash_funcion_rapida("ABCD123BD", 9, 7));
+	assert_prueba("Otra semilla da otro hash", hash_funcion_rapida("ABCD123BD", 9, 7) != hash_funcion_rapida("ABCD123BD", 9, 8));
+	assert_prueba("SipHash distingue anagramas y semillas", hash_funcion_siphash("ABC123", 6, 1) != hash_funcion_siphash("321CBA", 6, 1) && hash_funcion_siphash("ABC123", 6, 1) != hash_funcion_siphash("ABC123", 6, 2));
+
+	// Vectores de referencia de SipHash-2-4: clave secreta 00 01 .. 0f y mensaje 00 01 .. largo-1
+	uint8_t mensaje[64];
+	for(int i = 0; i < 64; i++)
+		mensaje[i] = (uint8_t)i;
+	uint64_t k0 = 0x0706050403020100ULL, k1 = 0x0f0e0d0c0b0a0908ULL;
+	assert_prueba("SipHash-2-4 coincide con los vectores de referencia", siphash_2_4(mensaje, 0, k0, k1) == 0x726fdb47dd0e0e31ULL && siphash_2_4(mensaje, 1, k0, k1) == 0x74f839c593dc67fdULL && siphash_2_4(mensaje, 7, k0, k1) == 0xab0200f58b01d137ULL && siphash_2_4(mensaje, 8, k0, k1) == 0x93f5f5799a932462ULL && siphash_2_4(mensaje, 15, k0, k1) == 0xa129ca6149be45e5ULL && siphash_2_4(mensaje, 63, k0, k1) == 0x958a324ceb064572ULL);
+
+	// Vectores de wyhash final4 (test_vector.cpp de la implementacion original): la semilla es el numero de vector
+	const char* textos[] = {"", "a", "abc", "message digest", "abcdefghijklmnopqrstuvwxyz", "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789", "12345678901234567890123456789012345678901234567890123456789012345678901234567890"};
+	const uint64_t esperados[] = {0x0409638ee2bde459ULL, 0xa8412d091b5fe0a9ULL, 0x32dd92e4b2915153ULL, 0x8619124089a3a16bULL, 0x7a43afb61d7f5f40ULL, 0xff42329b90e50d58ULL, 0xc39cab13b115aad3ULL};
+	bool coinciden = true;
+	for(int i = 0; i < 7; i++)
+		coinciden = coinciden && hash_funcion_rapida(textos[i], strlen(textos[i]), (uint64_t)i) == esperados[i];
+	assert_prueba("hash_funcion_rapida coincide con los vectores de wyhash", coinciden);
+
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		opciones.funcion = hash_constante;
+		hash_t* hash = hash_crear_con_opciones(destruir_string, 5, &opciones);
+
+		char clave[20];
+		for(int i = 0; i < 100; i++){
+			sprintf(clave, "CLAVE%i", i);
+			hash_insertar(hash, clave, strdup(clave));
+		}
+
+		int coincidencias = 0;
+		for(int i = 0; i < 100; i++){
+			sprintf(clave, "CLAVE%i", i);
+			if(strcmp(hash_obtener(hash, clave), clave) == 0)
+				coincidencias++;
+		}
+
+		assert_prueba("Con una funcion propia que hace colisionar todo, se encuentran todas las claves", coincidencias == 100 && hash_quitar(hash, "CLAVE50") == EXITO && !hash_contiene(hash, "CLAVE50"));
+		hash_destruir(hash);
+	}
+
+	hash_opciones_t opciones = {0};
+	opciones.funcion = hash_funcion_siphash;
+	opciones.semilla = 1234;
+	opciones.semilla_fija = true;
+	hash_t* hash = hash_crear_con_opciones(NULL, 5, &opciones);
+	hash_insertar(hash, "ABC123", "1");
+	hash_insertar(hash, "321CBA", "2");
+	assert_prueba("Un hash con SipHash y semilla fija guarda ambos anagramas", strcmp(hash_obtener(hash, "ABC123"), "1") == 0 && strcmp(hash_obtener(hash, "321CBA"), "2") == 0);
+	hash_destruir(hash);
+}
+
+static int llamadas_hash = 0;
+
+// Funcion de hash que cuenta cuantas veces se la invoca
+uint64_t hash_contador(const void* clave, size_t largo, uint64_t semilla){
+
+	llamadas_hash++;
+	return hash_funcion_rapida(clave, largo, semilla);
+}
+
+void test_hash_guardado(){
+
+	printf("\nTEST HASH GUARDADO EN CADA ELEMENTO: \n\n");
+
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		opciones.funcion = hash_contador;
+		hash_t* hash = hash_crear_con_opciones(NULL, 3, &opciones);
+
+		llamadas_hash = 0;
+		char clave[20];
+		for(int i = 0; i < 500; i++){
+			sprintf(clave, "PAT%iENTE", i);
+			hash_insertar(hash, clave, NULL);
+		}
+
+		assert_prueba("Agrandar la tabla no vuelve a calcular el hash de las claves", llamadas_hash <= 2 * 500 && hash_cantidad(hash) == 500);
+		hash_destruir(hash);
+	}
+}
+
+void test_asignacion_slab(){
+
+	printf("\nTEST ASIGNACION EN SLAB: \n\n");
+
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		opciones.asignacion = HASH_ASIGNACION_SLAB;
+		hash_t* hash = hash_crear_con_opciones(destruir_string, 5, &opciones);
+		hash_t* sin_destructor = hash_crear_con_opciones(NULL, 5, &opciones);
+
+		char clave[300];
+		int correctamente_insertados = 0;
+		for(int i = 0; i < 2000; i++){
+			sprintf(clave, "AB%iCD", i);
+			if(hash_insertar(hash, clave, strdup(clave)) == EXITO && hash_insertar(sin_destructor, clave, NULL) == EXITO)
+				correctamente_insertados++;
+		}
+		assert_prueba("Inserto 2000 elementos tomando la memoria del slab", correctamente_insertados == 2000);
+
+		for(int i = 0; i < 2000; i += 2){
+			sprintf(clave, "AB%iCD", i);
+			hash_quitar(hash, clave);
+		}
+		for(int i = 0; i < 1000; i++){
+			sprintf(clave, "XY%iZW", i);
+			hash_insertar(hash, clave, strdup(clave));
+		}
+
+		memset(clave, 'L', sizeof(clave) - 1);
+		clave[sizeof(clave) - 1] = 0;
+		hash_insertar(hash, clave, strdup("CLAVE LARGA"));
+
+		int coincidencias = 0;
+		for(int i = 1; i < 2000; i += 2){
+			sprintf(clave, "AB%iCD", i);
+			if(strcmp(hash_obtener(hash, clave), clave) == 0)
+				coincidencias++;
+		}
+		for(int i = 0; i < 1000; i++){
+			sprintf(clave, "XY%iZW", i);
+			if(strcmp(hash_obtener(hash, clave), clave) == 0)
+				coincidencias++;
+		}
+		assert_prueba("Las claves que reutilizan bloques liberados se encuentran bien", coincidencias == 2000 && hash_cantidad(hash) == 2001);
+
+		hash_destruir(hash);
+		hash_destruir(sin_destructor);
+	}
+}
+
+void test_rehash_incremental(){
+
+	printf("\nTEST REHASH INCREMENTAL: \n\n");
+
+	hash_opciones_t opciones = {0};
+	opciones.motor = HASH_MOTOR_ENCADENADO;
+	opciones.rehash_incremental = true;
+	hash_t* hash = hash_crear_con_opciones(destruir_string, 5, &opciones);
+
+	char clave[20];
+	int encontrados = 0;
+	for(int i = 0; i < 5000; i++){
+		sprintf(clave, "INC%iREM", i);
+		hash_insertar(hash, clave, strdup(clave));
+		sprintf(clave, "INC%iREM", i / 2);
+		if(hash_contiene(hash, clave))
+			encontrados++;
+	}
+	assert_prueba("Las claves anteriores se encuentran mientras la tabla se muda", encontrados == 5000 && hash_cantidad(hash) == 5000);
+
+	int quitados = 0;
+	for(int i = 0; i < 5000; i += 3){
+		sprintf(clave, "INC%iREM", i);
+		if(hash_quitar(hash, clave) == EXITO)
+			quitados++;
+	}
+	for(int i = 5000; i < 6000; i++){
+		sprintf(clave, "INC%iREM", i);
+		hash_insertar(hash, clave, strdup(clave));
+	}
+	assert_prueba("Se pueden quitar e insertar elementos durante la mudanza", quitados == 1667 && hash_cantidad(hash) == 6000 - 1667);
+
+	int coincidencias = 0;
+	for(int i = 0; i < 6000; i++){
+		sprintf(clave, "INC%iREM", i);
+		char* elemento = hash_obtener(hash, clave);
+		if((i < 5000 && i % 3 == 0) ? !elemento : (elemento && strcmp(elemento, clave) == 0))
+			coincidencias++;
+	}
+	assert_prueba("Todas las claves tienen su elemento correcto", coincidencias == 6000);
+
+	for(int i = 6000; i < 9000; i++){
+		sprintf(clave, "INC%iREM", i);
+		hash_insertar(hash, clave, strdup(clave));
+	}
+
+	int cantidad_recorridos = 0;
+	hash_iterador_t* iter = hash_iterador_crear(hash);
+	while(hash_iterador_tiene_siguiente(iter)){
+		if(hash_contiene(hash, hash_iterador_siguiente(iter)))
+			cantidad_recorridos++;
+	}
+	hash_iterador_destruir(iter);
+	assert_prueba("El iterador recorre cada clave una sola vez durante la mudanza", cantidad_recorridos == 9000 - 1667 && (size_t)cantidad_recorridos == hash_cantidad(hash));
+
+	hash_destruir(hash);
+}
+
+void test_obtener_o_insertar(){
+
+	printf("\nTEST OBTENER O INSERTAR: \n\n");
+
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		opciones.funcion = hash_contador;
+		hash_t* hash = hash_crear_con_opciones(free, 5, &opciones);
+
+		char* palabras[8] = {"AAA111", "BBB222", "AAA111", "CCC333", "AAA111", "BBB222", "DDD444", "AAA111"};
+		llamadas_hash = 0;
+		int nuevas = 0;
+		for(int i = 0; i < 8; i++){
+			bool insertado;
+			void** lugar = hash_obtener_o_insertar(hash, palabras[i], &insertado);
+			if(insertado){
+				nuevas++;
+				*lugar = calloc(1, sizeof(int));
+			}
+			(*(int*)*lugar)++;
+		}
+
+		assert_prueba("Cuento apariciones con una sola busqueda por palabra", nuevas == 4 && llamadas_hash == 8 && *(int*)hash_obtener(hash, "AAA111") == 4 && *(int*)hash_obtener(hash, "BBB222") == 2);
+
+		void* anterior = NULL;
+		int* nuevo = calloc(1, sizeof(int));
+		llamadas_hash = 0;
+		assert_prueba("Reemplazar devuelve el elemento anterior sin destruirlo", hash_insertar_o_reemplazar(hash, "DDD444", nuevo, &anterior) == EXITO && anterior && *(int*)anterior == 1 && hash_obtener(hash, "DDD444") == nuevo && llamadas_hash == 2);
+		free(anterior);
+
+		anterior = nuevo;
+		assert_prueba("Insertar una clave nueva deja anterior en NULL", hash_insertar_o_reemplazar(hash, "EEE555", calloc(1, sizeof(int)), &anterior) == EXITO && anterior == NULL && hash_cantidad(hash) == 5);
+
+		hash_destruir(hash);
+	}
+}
+
+void test_con_hash(){
+
+	printf("\nTEST BUSQUEDAS CON HASH PRECALCULADO: \n\n");
+
+	hash_opciones_t opciones = {0};
+	opciones.funcion = hash_contador;
+	opciones.semilla = 99;
+	opciones.semilla_fija = true;
+
+	hash_t* tablas[CANTIDAD_MOTORES];
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+		opciones.motor = motores[m];
+		tablas[m] = hash_crear_con_opciones(NULL, 5, &opciones);
+		hash_insertar(tablas[m], "ABCD123BD", "PRINCIPAL");
+	}
+
+	llamadas_hash = 0;
+	uint64_t valor_hash = hash_calcular(tablas[0], "ABCD123BD", 9);
+	int encontrados = 0;
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+		if(hash_contiene_con_hash(tablas[m], "ABCD123BD", valor_hash) && strcmp(hash_obtener_con_hash(tablas[m], "ABCD123BD", valor_hash), "PRINCIPAL") == 0)
+			encontrados++;
+	}
+	assert_prueba("Con un solo calculo del hash busco la clave en todas las tablas", encontrados == CANTIDAD_MOTORES && llamadas_hash == 1);
+
+	uint64_t otro_hash = hash_calcular(tablas[0], "ZZZ999", 6);
+	int correctos = 0;
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+		if(hash_insertar_con_hash(tablas[m], "ZZZ999", otro_hash, "SECUNDARIO") == EXITO && strcmp(hash_obtener(tablas[m], "ZZZ999"), "SECUNDARIO") == 0 && hash_quitar_con_hash(tablas[m], "ZZZ999", otro_hash) == EXITO && !hash_contiene(tablas[m], "ZZZ999"))
+			correctos++;
+	}
+	assert_prueba("Insertar y quitar con hash precalculado coincide con las funciones comunes", correctos == CANTIDAD_MOTORES);
+
+	for(int m = 0; m < CANTIDAD_MOTORES; m++)
+		hash_destruir(tablas[m]);
+}
+
+void test_claves_binarias(){
+
+	printf("\nTEST CLAVES BINARIAS: \n\n");
+
+	const char buffer[] = "GET clave\0con\0ceros FIN";
+	const char con_ceros[] = {'A', '\0', 'B'};
+	const char otra_con_ceros[] = {'A', '\0', 'C'};
+	int correctos = 0;
+
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		hash_t* hash = hash_crear_con_opciones(NULL, 5, &opciones);
+
+		bool bien = hash_insertar_n(hash, con_ceros, 3, "CERO B") == EXITO;
+		bien &= hash_insertar_n(hash, otra_con_ceros, 3, "CERO C") == EXITO;
+		bien &= hash_insertar_n(hash, "A", 1, "SOLO A") == EXITO;
+		bien &= hash_insertar_n(hash, "", 0, "VACIA") == EXITO;
+		bien &= hash_cantidad(hash) == 4;
+
+		// Las claves con ceros no se confunden entre si ni con su prefijo como string
+		bien &= strcmp(hash_obtener_n(hash, con_ceros, 3), "CERO B") == 0;
+		bien &= strcmp(hash_obtener_n(hash, otra_con_ceros, 3), "CERO C") == 0;
+		bien &= strcmp(hash_obtener(hash, "A"), "SOLO A") == 0;
+		bien &= strcmp(hash_obtener(hash, ""), "VACIA") == 0;
+		bien &= !hash_contiene_n(hash, con_ceros, 2);
+
+		// Busca directamente sobre un fragmento de un buffer mas grande
+		bien &= hash_insertar(hash, "clave", "DEL BUFFER") == EXITO;
+		bien &= strcmp(hash_obtener_n(hash, buffer + 4, 5), "DEL BUFFER") == 0;
+		bien &= !hash_contiene_n(hash, buffer + 4, 6);
+
+		bool insertado = false;
+		void** lugar = hash_obtener_o_insertar_n(hash, buffer + 10, 3, &insertado);
+		bien &= lugar && insertado && hash_contiene(hash, "con");
+
+		bien &= hash_quitar_n(hash, con_ceros, 3) == EXITO;
+		bien &= !hash_contiene_n(hash, con_ceros, 3) && hash_contiene_n(hash, otra_con_ceros, 3);
+		bien &= hash_quitar_n(hash, con_ceros, 3) == ERROR;
+
+		if(bien)
+			correctos++;
+
+		hash_destruir(hash);
+	}
+
+	assert_prueba("Las claves de largo explicito con ceros se insertan, buscan y quitan en todos los motores", correctos == CANTIDAD_MOTORES);
+}
+
+void test_lotes(){
+
+	printf("\nTEST OPERACIONES POR LOTES: \n\n");
+
+	char claves_guardadas[100][20];
+	const char* claves[100];
+	void* elementos[100];
+	for(int i = 0; i < 100; i++){
+		sprintf(claves_guardadas[i], "LOTE%i", i);
+		claves[i] = claves_guardadas[i];
+		elementos[i] = claves_guardadas[i];
+	}
+
+	const char* buscadas[] = {"LOTE0", "NO ESTA", NULL, "LOTE99", "LOTE50"};
+	int correctos = 0;
+
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		hash_t* hash = hash_crear_con_opciones(NULL, 5, &opciones);
+
+		bool bien = hash_insertar_lote(hash, claves, elementos, 100) == EXITO && hash_cantidad(hash) == 100;
+
+		void* resultados[100];
+		bien &= hash_obtener_lote(hash, claves, 100, resultados) == 100;
+		for(int i = 0; i < 100; i++)
+			bien &= resultados[i] == elementos[i];
+
+		void* obtenidos[5];
+		bool presentes[5];
+		bien &= hash_obtener_lote(hash, buscadas, 5, obtenidos) == 3;
+		bien &= hash_contiene_lote(hash, buscadas, 5, presentes) == 3;
+		bien &= obtenidos[0] == elementos[0] && !obtenidos[1] && !obtenidos[2] && obtenidos[3] == elementos[99] && obtenidos[4] == elementos[50];
+		bien &= presentes[0] && !presentes[1] && !presentes[2] && presentes[3] && presentes[4];
+
+		bien &= hash_insertar_lote(hash, buscadas, elementos, 5) == ERROR && hash_contiene(hash, "NO ESTA");
+
+		if(bien)
+			correctos++;
+
+		hash_destruir(hash);
+	}
+
+	assert_prueba("Insertar, obtener y buscar por lotes coincide con las operaciones de a una en todos los motores", correctos == CANTIDAD_MOTORES);
+	assert_prueba("Las operaciones por lotes con hash NULL no hacen nada", hash_insertar_lote(NULL, claves, elementos, 100) == ERROR && hash_obtener_lote(NULL, claves, 100, elementos) == 0);
+}
+
+void test_reservar(){
+
+	printf("\nTEST RESERVAR CAPACIDAD: \n\n");
+
+	char clave[20];
+	int correctos = 0;
+
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		hash_t* hash = hash_crear_con_opciones(NULL, 5, &opciones);
+
+		bool bien = hash_reservar(hash, 3000) == EXITO;
+		void** primero = hash_obtener_o_insertar(hash, "RES0", NULL);
+		*primero = "PRIMERO";
+
+		for(int i = 1; i < 3000; i++){
+			sprintf(clave, "RES%i", i);
+			bien &= hash_insertar(hash, clave, NULL) == EXITO;
+		}
+
+		// Sin redimensiones en el medio, el lugar del primer elemento no se movio
+		bien &= hash_obtener_o_insertar(hash, "RES0", NULL) == primero && strcmp(*primero, "PRIMERO") == 0;
+		bien &= hash_reservar(hash, 10) == EXITO && hash_cantidad(hash) == 3000;
+
+		for(int i = 0; i < 3000; i++){
+			sprintf(clave, "RES%i", i);
+			bien &= hash_contiene(hash, clave);
+		}
+
+		if(bien)
+			correctos++;
+
+		hash_destruir(hash);
+	}
+
+	assert_prueba("Despues de reservar, las inserciones no redimensionan la tabla en ningun motor", correctos == CANTIDAD_MOTORES);
+	assert_prueba("Reservar en un hash NULL devuelve error", hash_reservar(NULL, 10) == ERROR);
+
+	hash_t* hash = hash_crear(NULL, 5);
+	assert_prueba("Se puede reservar lugar para muchos elementos de una vez", hash_reservar(hash, 3000000) == EXITO && hash_insertar(hash, "GRANDE", NULL) == EXITO && hash_contiene(hash, "GRANDE"));
+	hash_destruir(hash);
+}
+
+#define HILOS_PRUEBA 4
+#define CLAVES_POR_HILO 2000
+
+typedef struct trabajo_concurrente{
+	hash_concurrente_t* hash;
+	int hilo;
+	int correctos;
+}trabajo_concurrente_t;
+
+void* insertar_y_buscar_concurrente(void* argumento){
+
+	trabajo_concurrente_t* trabajo = argumento;
+	char clave[30];
+
+	for(int i = 0; i < CLAVES_POR_HILO; i++){
+		sprintf(clave, "H%iC%i", trabajo->hilo, i);
+		if(hash_concurrente_insertar(trabajo->hash, clave, strdup(clave)) == EXITO)
+			trabajo->correctos++;
+
+		// Busca tambien claves de los otros hilos, que pueden estar o no
+		sprintf(clave, "H%iC%i", (trabajo->hilo + 1) % HILOS_PRUEBA, i);
+		hash_concurrente_contiene(trabajo->hash, clave);
+	}
+
+	for(int i = 0; i < CLAVES_POR_HILO; i += 2){
+		sprintf(clave, "H%iC%i", trabajo->hilo, i);
+		if(hash_concurrente_quitar(trabajo->hash, clave) == EXITO)
+			trabajo->correctos++;
+	}
+
+	return NULL;
+}
+
+void test_hash_concurrente(){
+
+	printf("\nTEST HASH CONCURRENTE: \n\n");
+
+	int correctos = 0;
+
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		hash_concurrente_t* hash = hash_concurrente_crear(destruir_string, 5, 8, &opciones);
+
+		pthread_t hilos[HILOS_PRUEBA];
+		trabajo_concurrente_t trabajos[HILOS_PRUEBA];
+		for(int i = 0; i < HILOS_PRUEBA; i++){
+			trabajos[i] = (trabajo_concurrente_t){hash, i, 0};
+			pthread_create(&hilos[i], NULL, insertar_y_buscar_concurrente, &trabajos[i]);
+		}
+
+		bool bien = true;
+		for(int i = 0; i < HILOS_PRUEBA; i++){
+			pthread_join(hilos[i], NULL);
+			bien &= trabajos[i].correctos == CLAVES_POR_HILO + CLAVES_POR_HILO / 2;
+		}
+
+		bien &= hash_concurrente_cantidad(hash) == HILOS_PRUEBA * CLAVES_POR_HILO / 2;
+
+		char clave[30];
+		for(int h = 0; h < HILOS_PRUEBA; h++){
+			for(int i = 0; i < CLAVES_POR_HILO; i++){
+				sprintf(clave, "H%iC%i", h, i);
+				char* elemento = hash_concurrente_obtener(hash, clave);
+				bien &= (i % 2 == 0) ? !elemento : (elemento && strcmp(elemento, clave) == 0);
+			}
+		}
+
+		if(bien)
+			correctos++;
+
+		hash_concurrente_destruir(hash);
+	}
+
+	assert_prueba("Varios hilos insertan, buscan y quitan a la vez sin perder claves en todos los motores", correctos == CANTIDAD_MOTORES);
+	assert_prueba("Las operaciones con hash NULL fallan", hash_concurrente_insertar(NULL, "A", NULL) == ERROR && !hash_concurrente_obtener(NULL, "A") && hash_concurrente_cantidad(NULL) == 0);
+
+	hash_concurrente_t* un_fragmento = hash_concurrente_crear(NULL, 5, 1, NULL);
+	assert_prueba("Con un solo fragmento se comporta como un hash comun", hash_concurrente_insertar(un_fragmento, "UNO", "1") == EXITO && strcmp(hash_concurrente_obtener(un_fragmento, "UNO"), "1") == 0);
+	hash_concurrente_destruir(un_fragmento);
+}
+
+#define LECTURAS_RCU 20000
+
+typedef struct lectura_rcu{
+	hash_rcu_t* hash;
+	int correctas;
+}lectura_rcu_t;
+
+void* leer_hash_rcu(void* argumento){
+
+	lectura_rcu_t* lectura = argumento;
+	hash_rcu_lector_t* lector = hash_rcu_registrar_lector(lectura->hash);
+	char clave[30];
+
+	for(int i = 0; i < LECTURAS_RCU; i++){
+		sprintf(clave, "FIJA%i", i % 100);
+		hash_rcu_leer(lector);
+		char* elemento = hash_rcu_obtener(lector, clave);
+		// Aunque el escritor reemplace el elemento, sigue vivo hasta terminar la lectura
+		if(elemento && strncmp(elemento, clave, strlen(clave)) == 0)
+			lectura->correctas++;
+		sprintf(clave, "VARIABLE%i", i % 500);
+		hash_rcu_contiene(lector, clave);
+		hash_rcu_terminar_lectura(lector);
+	}
+
+	hash_rcu_desregistrar_lector(lector);
+	return NULL;
+}
+
+int elementos_destruidos_rcu = 0;
+
+void contar_destruccion_rcu(void* elemento){
+
+	(void)elemento;
+	elementos_destruidos_rcu++;
+}
+
+void test_hash_rcu(){
+
+	printf("\nTEST HASH CON LECTURAS SIN CANDADOS: \n\n");
+
+	hash_rcu_t* hash = hash_rcu_crear(destruir_string, 5);
+	char clave[30];
+	char valor[40];
+
+	for(int i = 0; i < 100; i++){
+		sprintf(clave, "FIJA%i", i);
+		hash_rcu_insertar(hash, clave, strdup(clave));
+	}
+
+	pthread_t hilos[HILOS_PRUEBA];
+	lectura_rcu_t lecturas[HILOS_PRUEBA];
+	for(int i = 0; i < HILOS_PRUEBA; i++){
+		lecturas[i] = (lectura_rcu_t){hash, 0};
+		pthread_create(&hilos[i], NULL, leer_hash_rcu, &lecturas[i]);
+	}
+
+	// Mientras tanto reemplaza las claves fijas y agrega y quita otras, agrandando la tabla
+	for(int vuelta = 0; vuelta < 5; vuelta++){
+		for(int i = 0; i < 500; i++){
+			sprintf(clave, "VARIABLE%i", i);
+			hash_rcu_insertar(hash, clave, strdup(clave));
+		}
+		for(int i = 0; i < 100; i++){
+			sprintf(clave, "FIJA%i", i);
+			sprintf(valor, "FIJA%iV%i", i, vuelta);
+			hash_rcu_insertar(hash, clave, strdup(valor));
+		}
+		for(int i = 0; i < 500; i++){
+			sprintf(clave, "VARIABLE%i", i);
+			hash_rcu_quitar(hash, clave);
+		}
+	}
+
+	bool todas = true;
+	for(int i = 0; i < HILOS_PRUEBA; i++){
+		pthread_join(hilos[i], NULL);
+		todas &= lecturas[i].correctas == LECTURAS_RCU;
+	}
+	assert_prueba("Los lectores siempre encuentran las claves fijas mientras se modifican", todas);
+	assert_prueba("La cantidad es correcta despues de las modificaciones", hash_rcu_cantidad(hash) == 100);
+
+	hash_rcu_lector_t* lector = hash_rcu_registrar_lector(hash);
+	hash_rcu_leer(lector);
+	assert_prueba("Se obtiene el ultimo elemento insertado", strcmp(hash_rcu_obtener(lector, "FIJA7"), "FIJA7V4") == 0 && !hash_rcu_contiene(lector, "VARIABLE3"));
+	hash_rcu_terminar_lectura(lector);
+	hash_rcu_desregistrar_lector(lector);
+
+	assert_prueba("Quitar una clave inexistente devuelve error", hash_rcu_quitar(hash, "NO ESTA") == ERROR && hash_rcu_insertar(NULL, "A", NULL) == ERROR);
+
+	hash_rcu_destruir(hash);
+
+	elementos_destruidos_rcu = 0;
+	hash = hash_rcu_crear(contar_destruccion_rcu, 5);
+	for(int i = 0; i < 1000; i++){
+		sprintf(clave, "R%i", i);
+		hash_rcu_insertar(hash, clave, NULL);
+	}
+	lector = hash_rcu_registrar_lector(hash);
+	int encontradas = 0;
+	hash_rcu_leer(lector);
+	for(int i = 0; i < 1000; i++){
+		sprintf(clave, "R%i", i);
+		if(hash_rcu_contiene(lector, clave))
+			encontradas++;
+	}
+	hash_rcu_terminar_lectura(lector);
+	assert_prueba("Al agrandarse la tabla sin copiar los nodos no se pierde ninguna clave", encontradas == 1000 && !hash_rcu_contiene(lector, "R1000"));
+
+	hash_rcu_quitar(hash, "R7");
+	for(int i = 0; i < 256; i++){
+		hash_rcu_leer(lector);
+		hash_rcu_contiene(lector, "R8");
+		hash_rcu_terminar_lectura(lector);
+	}
+	assert_prueba("Si no hay mas modificaciones, los lectores liberan lo que quedo retirado", elementos_destruidos_rcu == 1);
+	hash_rcu_desregistrar_lector(lector);
+
+	hash_rcu_destruir(hash);
+	assert_prueba("Al destruir se invoca el destructor con el resto de los elementos", elementos_destruidos_rcu == 1000);
+}
+
+typedef struct trabajo_libre{
+	hash_libre_t* hash;
+	int hilo;
+	int correctos;
+}trabajo_libre_t;
+
+void* insertar_y_quitar_sin_candados(void* argumento){
+
+	trabajo_libre_t* trabajo = argumento;
+	hash_libre_hilo_t* hilo = hash_libre_registrar_hilo(trabajo->hash);
+	char clave[30];
+
+	for(int i = 0; i < CLAVES_POR_HILO; i++){
+		sprintf(clave, "L%iC%i", trabajo->hilo, i);
+		if(hash_libre_insertar(hilo, clave, strdup(clave)) == EXITO)
+			trabajo->correctos++;
+
+		// Todos los hilos reemplazan y buscan tambien una clave compartida
+		sprintf(clave, "COMPARTIDA%i", i % 10);
+		hash_libre_insertar(hilo, clave, strdup(clave));
+		hash_libre_contiene(hilo, clave);
+	}
+
+	for(int i = 0; i < CLAVES_POR_HILO; i += 2){
+		sprintf(clave, "L%iC%i", trabajo->hilo, i);
+		if(hash_libre_quitar(hilo, clave) == EXITO)
+			trabajo->correctos++;
+	}
+
+	hash_libre_desregistrar_hilo(hilo);
+	return NULL;
+}
+
+void test_hash_libre(){
+
+	printf("\nTEST HASH SIN CANDADOS: \n\n");
+
+	hash_libre_t* hash = hash_libre_crear(destruir_string, 5);
+
+	pthread_t hilos[HILOS_PRUEBA];
+	trabajo_libre_t trabajos[HILOS_PRUEBA];
+	for(int i = 0; i < HILOS_PRUEBA; i++){
+		trabajos[i] = (trabajo_libre_t){hash, i, 0};
+		pthread_create(&hilos[i], NULL, insertar_y_quitar_sin_candados, &trabajos[i]);
+	}
+
+	bool todos = true;
+	for(int i = 0; i < HILOS_PRUEBA; i++){
+		pthread_join(hilos[i], NULL);
+		todos &= trabajos[i].correctos == CLAVES_POR_HILO + CLAVES_POR_HILO / 2;
+	}
+	assert_prueba("Varios hilos insertan y quitan a la vez sin candados", todos);
+	assert_prueba("La cantidad incluye las claves propias que quedaron y las compartidas", hash_libre_cantidad(hash) == HILOS_PRUEBA * CLAVES_POR_HILO / 2 + 10);
+
+	hash_libre_hilo_t* hilo = hash_libre_registrar_hilo(hash);
+	char clave[30];
+	bool correctos = true;
+	for(int h = 0; h < HILOS_PRUEBA; h++){
+		for(int i = 0; i < CLAVES_POR_HILO; i++){
+			sprintf(clave, "L%iC%i", h, i);
+			char* elemento = hash_libre_obtener(hilo, clave);
+			correctos &= (i % 2 == 0) ? !elemento : (elemento && strcmp(elemento, clave) == 0);
+		}
+	}
+	assert_prueba("Cada clave tiene su elemento despues de agrandarse la tabla", correctos);
+	assert_prueba("Quitar una clave inexistente devuelve error", hash_libre_quitar(hilo, "NO ESTA") == ERROR && hash_libre_insertar(NULL, "A", NULL) == ERROR);
+	hash_libre_desregistrar_hilo(hilo);
+
+	hash_libre_destruir(hash);
+}
+
+void test_rehash_paralelo(){
+
+	printf("\nTEST REHASH EN PARALELO: \n\n");
+
+	hash_opciones_t opciones = {0};
+	opciones.motor = HASH_MOTOR_ENCADENADO;
+	opciones.hilos_rehash = 4;
+	hash_t* hash = hash_crear_con_opciones(destruir_string, 5, &opciones);
+
+	char clave[20];
+	for(int i = 0; i < 40000; i++){
+		sprintf(clave, "PAR%i", i);
+		hash_insertar(hash, clave, strdup(clave));
+	}
+
+	int encontrados = 0;
+	for(int i = 0; i < 40000; i++){
+		sprintf(clave, "PAR%i", i);
+		char* elemento = hash_obtener(hash, clave);
+		if(elemento && strcmp(elemento, clave) == 0)
+			encontrados++;
+	}
+	assert_prueba("Despues de varias mudanzas en paralelo estan todas las claves", encontrados == 40000 && hash_cantidad(hash) == 40000);
+
+	assert_prueba("Reservar varias veces la capacidad tambien se muda en paralelo", hash_reservar(hash, 1000000) == EXITO && hash_contiene(hash, "PAR0") && hash_contiene(hash, "PAR39999"));
+
+	int recorridos = 0;
+	hash_iterador_t* iter = hash_iterador_crear(hash);
+	while(hash_iterador_siguiente(iter))
+		recorridos++;
+	hash_iterador_destruir(iter);
+	assert_prueba("El iterador recorre cada clave una sola vez", recorridos == 40000);
+
+	hash_destruir(hash);
+
+	opciones.rehash_incremental = true;
+	hash = hash_crear_con_opciones(destruir_string, 5, &opciones);
+	for(int i = 0; i < 20000; i++){
+		sprintf(clave, "PAR%i", i);
+		hash_insertar(hash, clave, strdup(clave));
+	}
+	iter = hash_iterador_crear(hash);
+	recorridos = 0;
+	while(hash_iterador_siguiente(iter))
+		recorridos++;
+	hash_iterador_destruir(iter);
+	assert_prueba("Terminar una mudanza incremental empezada tambien puede hacerse en paralelo", recorridos == 20000);
+	hash_destruir(hash);
+}
+
+void test_construir_paralelo(){
+
+	printf("\nTEST CONSTRUCCION EN PARALELO: \n\n");
+
+	const size_t cantidad = 30000;
+	char** claves = malloc(cantidad * sizeof(char*));
+	void** elementos = malloc(cantidad * sizeof(void*));
+	char clave[30];
+
+	// Cada decima clave repite una anterior: debe quedar el ultimo elemento
+	for(size_t i = 0; i < cantidad; i++){
+		sprintf(clave, "CONS%zu", i % 10 == 9 ? i - 5 : i);
+		claves[i] = strdup(clave);
+	}
+
+	hash_motor_t motores[] = {HASH_MOTOR_ENCADENADO, HASH_MOTOR_LISTAS, HASH_MOTOR_ABIERTO};
+	for(size_t m = 0; m < sizeof(motores) / sizeof(motores[0]); m++){
+
+		for(size_t i = 0; i < cantidad; i++){
+			sprintf(clave, "%zu", i);
+			elementos[i] = strdup(clave);
+		}
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		hash_t* hash = hash_construir_paralelo(destruir_string, (const char* const*)claves, elementos, cantidad, 4, &opciones);
+
+		size_t distintas = 0, correctos = 0;
+		for(size_t i = 0; i < cantidad; i++){
+			if(i % 10 == 9)
+				continue;
+			distintas++;
+			size_t ultimo = i % 10 == 4 ? i + 5 : i;
+			char* elemento = hash_obtener(hash, claves[i]);
+			sprintf(clave, "%zu", ultimo);
+			if(elemento && strcmp(elemento, clave) == 0)
+				correctos++;
+		}
+		assert_prueba("Construir en paralelo guarda cada clave con su ultimo elemento", hash && correctos == distintas && hash_cantidad(hash) == distintas);
+
+		size_t recorridos = 0;
+		hash_iterador_t* iter = hash_iterador_crear(hash);
+		while(hash_iterador_siguiente(iter))
+			recorridos++;
+		hash_iterador_destruir(iter);
+		assert_prueba("El hash construido se recorre como cualquier otro", recorridos == distintas);
+
+		assert_prueba("El hash construido admite inserciones y borrados normales", hash_insertar(hash, "NUEVA", strdup("NUEVA")) == EXITO && hash_quitar(hash, claves[0]) == EXITO && hash_cantidad(hash) == distintas);
+
+		hash_destruir(hash);
+	}
+
+	assert_prueba("No se puede construir con una clave NULL", !hash_construir_paralelo(NULL, (const char* const[]){"A", NULL}, (void* const[]){NULL, NULL}, 2, 2, NULL));
+
+	hash_t* vacio = hash_construir_paralelo(NULL, NULL, NULL, 0, 4, NULL);
+	assert_prueba("Construir sin claves devuelve un hash vacio", vacio && hash_cantidad(vacio) == 0);
+	hash_destruir(vacio);
+
+	hash_opciones_t encadenado = {0};
+	encadenado.motor = HASH_MOTOR_ENCADENADO;
+	hash_t* pocos = hash_construir_paralelo(NULL, (const char* const[]){"A", "B", "C"}, (void* const[]){NULL, NULL, NULL}, 3, (size_t)1 << 40, &encadenado);
+	assert_prueba("Pedir muchisimos hilos usa a lo sumo uno por procesador y por clave", pocos && hash_cantidad(pocos) == 3 && hash_contiene(pocos, "B"));
+	hash_destruir(pocos);
+
+	for(size_t i = 0; i < cantidad; i++)
+		free(claves[i]);
+	free(claves);
+	free(elementos);
+}
+
+void test_cursor(){
+
+	printf("\nTEST CURSOR: \n\n");
+
+	hash_cursor_t cursor;
+	assert_prueba("No se puede iniciar un cursor sobre un hash NULL", !hash_cursor_iniciar(&cursor, NULL) && !hash_cursor_siguiente(&cursor, NULL, NULL, NULL));
+
+	hash_motor_t motores[] = {HASH_MOTOR_LISTAS, HASH_MOTOR_ABIERTO, HASH_MOTOR_ENCADENADO};
+	for(size_t m = 0; m < sizeof(motores) / sizeof(motores[0]); m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		hash_t* hash = hash_crear_con_opciones(NULL, 5, &opciones);
+
+		// Pocas claves en muchos baldes vacios
+		hash_reservar(hash, 500000);
+		hash_insertar(hash, "Uno", "1");
+		hash_insertar(hash, "Dos", "2");
+		hash_insertar_n(hash, "T\0s", 3, "3");
+
+		size_t recorridos = 0, correctos = 0;
+		const char* clave;
+		size_t largo;
+		void* elemento;
+		hash_cursor_iniciar(&cursor, hash);
+		while(hash_cursor_siguiente(&cursor, &clave, &largo, &elemento)){
+			recorridos++;
+			if(elemento == hash_obtener_n(hash, clave, largo))
+				correctos++;
+		}
+		assert_prueba("El cursor devuelve cada clave con su largo y su elemento", recorridos == 3 && correctos == 3);
+		assert_prueba("Un cursor terminado no devuelve mas elementos", !hash_cursor_siguiente(&cursor, &clave, NULL, NULL));
+
+		hash_iterador_t* iter = hash_iterador_crear(hash);
+		recorridos = 0;
+		while(hash_iterador_tiene_siguiente(iter) && hash_iterador_siguiente(iter))
+			recorridos++;
+		assert_prueba("El iterador recorre una tabla casi vacia sin problemas", recorridos == 3 && !hash_iterador_siguiente(iter));
+		hash_iterador_destruir(iter);
+
+		hash_destruir(hash);
+	}
+}
+
+bool es_par(const char* clave, void* elemento, void* contexto){
+
+	(void)clave;
+	(void)contexto;
+
+	return atoi(elemento) % 2 == 0;
+}
+
+void test_quitar_recorriendo(){
+
+	printf("\nTEST QUITAR RECORRIENDO: \n\n");
+
+	hash_motor_t motores[] = {HASH_MOTOR_LISTAS, HASH_MOTOR_ABIERTO, HASH_MOTOR_ENCADENADO};
+	for(size_t m = 0; m < sizeof(motores) / sizeof(motores[0]); m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		opciones.asignacion = m == 0 ? HASH_ASIGNACION_SLAB : HASH_ASIGNACION_MALLOC;
+		hash_t* hash = hash_crear_con_opciones(destruir_string, 5, &opciones);
+
+		char clave[30];
+		for(int i = 0; i < 3000; i++){
+			sprintf(clave, "%i", i);
+			hash_insertar(hash, clave, strdup(clave));
+		}
+
+		hash_iterador_t* iter = hash_iterador_crear(hash);
+		assert_prueba("No se puede quitar antes de avanzar el iterador", hash_iterador_quitar_actual(iter) == ERROR);
+
+		int recorridos = 0, quitados = 0;
+		char* actual;
+		while((actual = hash_iterador_siguiente(iter))){
+			recorridos++;
+			if(atoi(actual) % 3 == 0 && hash_iterador_quitar_actual(iter) == EXITO)
+				quitados++;
+		}
+		hash_iterador_destruir(iter);
+		assert_prueba("Quitar con el iterador no saltea ni repite claves", recorridos == 3000 && quitados == 1000);
+		assert_prueba("Quedan solo las claves que no se quitaron", hash_cantidad(hash) == 2000 && !hash_contiene(hash, "0") && !hash_contiene(hash, "2997") && hash_contiene(hash, "2998"));
+
+		hash_cursor_t cursor;
+		hash_cursor_iniciar(&cursor, hash);
+		assert_prueba("Un cursor recien iniciado no tiene elemento para quitar", hash_cursor_quitar(&cursor) == ERROR);
+		hash_cursor_siguiente(&cursor, NULL, NULL, NULL);
+		assert_prueba("El cursor no quita dos veces el mismo elemento", hash_cursor_quitar(&cursor) == EXITO && hash_cursor_quitar(&cursor) == ERROR && hash_cantidad(hash) == 1999);
+
+		size_t antes = hash_cantidad(hash);
+		size_t pares = hash_quitar_si(hash, es_par, NULL);
+		assert_prueba("hash_quitar_si quita en una pasada las claves que cumplen el predicado", pares > 0 && hash_cantidad(hash) == antes - pares && !hash_contiene(hash, "2") && hash_contiene(hash, "1"));
+
+		assert_prueba("El hash sigue funcionando despues de quitar recorriendo", hash_insertar(hash, "2", strdup("2")) == EXITO && hash_contiene(hash, "2"));
+
+		hash_destruir(hash);
+	}
+}
+
+size_t tamanio_int(const void* elemento){
+
+	(void)elemento;
+
+	return sizeof(int);
+}
+
+#define ENTEROS_POR_BLOQUE 128
+#define BLOQUES_SNAPSHOT 8000
+
+size_t tamanio_bloque(const void* elemento){
+
+	(void)elemento;
+
+	return ENTEROS_POR_BLOQUE * sizeof(int);
+}
+
+void test_snapshot(){
+
+	printf("\nTEST SNAPSHOT: \n\n");
+
+	const char* ruta = "prueba_snapshot.dat";
+	char clave[30];
+
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		hash_t* hash = hash_crear_con_opciones(destruir_string, 5, &opciones);
+		for(int i = 0; i < 5000; i++){
+			sprintf(clave, "SNAP%i", i);
+			hash_insertar(hash, clave, strdup(clave));
+		}
+		hash_insertar(hash, "NULO", NULL);
+		hash_insertar_n(hash, "B\0N", 3, strdup("binaria"));
+
+		assert_prueba("Se puede guardar un snapshot", hash_guardar_snapshot(hash, ruta, NULL) == EXITO);
+		hash_destruir(hash);
+
+		hash_t* snapshot = hash_abrir_snapshot(ruta, NULL);
+		assert_prueba("Se puede abrir el snapshot guardado", snapshot && hash_cantidad(snapshot) == 5002);
+
+		int encontrados = 0;
+		for(int i = 0; i < 5000; i++){
+			sprintf(clave, "SNAP%i", i);
+			char* elemento = hash_obtener(snapshot, clave);
+			if(elemento && strcmp(elemento, clave) == 0)
+				encontrados++;
+		}
+		assert_prueba("El snapshot devuelve cada elemento guardado", encontrados == 5000);
+		assert_prueba("Los elementos NULL y las claves binarias se conservan", hash_contiene(snapshot, "NULO") && !hash_obtener(snapshot, "NULO") && strcmp(hash_obtener_n(snapshot, "B\0N", 3), "binaria") == 0 && !hash_contiene(snapshot, "B"));
+
+		size_t recorridos = 0;
+		hash_cursor_t cursor;
+		hash_cursor_iniciar(&cursor, snapshot);
+		while(hash_cursor_siguiente(&cursor, NULL, NULL, NULL))
+			recorridos++;
+		assert_prueba("El cursor recorre todo el snapshot", recorridos == 5002);
+
+		assert_prueba("El snapshot es de solo lectura", hash_insertar(snapshot, "NUEVA", NULL) == ERROR && hash_quitar(snapshot, "SNAP1") == ERROR && hash_reservar(snapshot, 100000) == ERROR && hash_cursor_quitar(&cursor) == ERROR && hash_cantidad(snapshot) == 5002);
+
+		hash_destruir(snapshot);
+	}
+
+	hash_opciones_t opciones = {0};
+	opciones.funcion = hash_contador;
+	hash_t* hash = hash_crear_con_opciones(NULL, 5, &opciones);
+	int numeros[100];
+	for(int i = 0; i < 100; i++){
+		numeros[i] = i * i;
+		sprintf(clave, "%i", i);
+		hash_insertar(hash, clave, &numeros[i]);
+	}
+	hash_guardar_snapshot(hash, ruta, tamanio_int);
+	hash_destruir(hash);
+
+	assert_prueba("Un snapshot con funcion de hash propia necesita esa funcion para abrirse", !hash_abrir_snapshot(ruta, NULL));
+	hash = hash_abrir_snapshot(ruta, hash_contador);
+	int* numero = hash_obtener(hash, "12");
+	assert_prueba("Los elementos de tamanio fijo se leen directamente del archivo", numero && *numero == 144 && numero != &numeros[12]);
+	hash_destruir(hash);
+
+	// Unos 4 MiB de registros: el snapshot se arma en varias partes
+	int* bloques = malloc(BLOQUES_SNAPSHOT * ENTEROS_POR_BLOQUE * sizeof(int));
+	hash = hash_crear(NULL, 5);
+	for(int i = 0; i < BLOQUES_SNAPSHOT; i++){
+		for(int j = 0; j < ENTEROS_POR_BLOQUE; j++)
+			bloques[i * ENTEROS_POR_BLOQUE + j] = i + j;
+		sprintf(clave, "BLOQUE%i", i);
+		hash_insertar(hash, clave, &bloques[i * ENTEROS_POR_BLOQUE]);
+	}
+	assert_prueba("Se puede guardar un snapshot mas grande que una parte", hash_guardar_snapshot(hash, ruta, tamanio_bloque) == EXITO);
+	hash_destruir(hash);
+
+	hash = hash_abrir_snapshot(ruta, NULL);
+	int iguales = 0;
+	for(int i = 0; hash && i < BLOQUES_SNAPSHOT; i++){
+		sprintf(clave, "BLOQUE%i", i);
+		int* bloque = hash_obtener(hash, clave);
+		if(bloque && memcmp(bloque, &bloques[i * ENTEROS_POR_BLOQUE], tamanio_bloque(bloque)) == 0)
+			iguales++;
+	}
+	assert_prueba("Cada registro queda completo aunque el snapshot se arme en partes", hash && hash_cantidad(hash) == BLOQUES_SNAPSHOT && iguales == BLOQUES_SNAPSHOT);
+	hash_destruir(hash);
+	free(bloques);
+
+	// Un registro con largos corruptos no se lee, aunque el archivo tenga el tamanio correcto
+	hash = hash_crear(NULL, 5);
+	for(int i = 0; i < 100; i++){
+		sprintf(clave, "CORRUPTA%i", i);
+		hash_insertar(hash, clave, NULL);
+	}
+	hash_guardar_snapshot(hash, ruta, NULL);
+	hash_destruir(hash);
+
+	uint64_t inicios[2];
+	uint64_t largo_corrupto = UINT64_MAX - 7;
+	FILE* archivo = fopen(ruta, "r+b");
+	fseek(archivo, 48, SEEK_SET);
+	fread(inicios, sizeof(uint64_t), 2, archivo);
+	fseek(archivo, (long)inicios[0] + 8, SEEK_SET);
+	fwrite(&largo_corrupto, sizeof(largo_corrupto), 1, archivo);
+	fclose(archivo);
+
+	hash = hash_abrir_snapshot(ruta, NULL);
+	size_t leidos = 0;
+	hash_cursor_t cursor;
+	hash_cursor_iniciar(&cursor, hash);
+	while(hash_cursor_siguiente(&cursor, NULL, NULL, NULL))
+		leidos++;
+	int encontradas = 0;
+	for(int i = 0; i < 100; i++){
+		sprintf(clave, "CORRUPTA%i", i);
+		if(hash_contiene(hash, clave))
+			encontradas++;
+	}
+	hash_estadisticas_t estadisticas;
+	assert_prueba("Un registro con largos corruptos corta el recorrido sin leer fuera del archivo", hash && leidos == 0 && encontradas < 100 && hash_estadisticas(hash, &estadisticas) == EXITO);
+	hash_destruir(hash);
+
+	// Y una tabla de inicios que apunta fuera del archivo no se abre
+	uint64_t inicio_corrupto = inicios[0] + 1000000;
+	archivo = fopen(ruta, "r+b");
+	fseek(archivo, 48 + 8, SEEK_SET);
+	fwrite(&inicio_corrupto, sizeof(inicio_corrupto), 1, archivo);
+	fclose(archivo);
+	assert_prueba("No se abre un snapshot cuyos inicios de balde no son coherentes", !hash_abrir_snapshot(ruta, NULL));
+
+	archivo = fopen(ruta, "r+b");
+	fputs("no es un snapshot", archivo);
+	fclose(archivo);
+	assert_prueba("No se abre un archivo que no es un snapshot", !hash_abrir_snapshot(ruta, hash_contador) && !hash_abrir_snapshot("no_existe.dat", NULL));
+	remove(ruta);
+}
+
+void test_cargar_archivo(){
+
+	printf("\nTEST CARGAR ARCHIVO: \n\n");
+
+	const char* ruta = "prueba_carga.txt";
+	FILE* archivo = fopen(ruta, "w");
+	for(int i = 0; i < 10000; i++)
+		fprintf(archivo, "K%i\tV%i\n", i, i);
+	fprintf(archivo, "\nK7\tREPETIDA\nTAB\ta\tb\nULTIMA\tSIN FIN");
+	fclose(archivo);
+
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		hash_t* hash = hash_crear_con_opciones(NULL, 3, &opciones);
+
+		assert_prueba("Se puede cargar un archivo de claves y valores", hash_cargar_archivo(hash, ruta, NULL) == EXITO && hash_cantidad(hash) == 10002);
+
+		int correctos = 0;
+		char clave[30], valor[30];
+		for(int i = 0; i < 10000; i++){
+			sprintf(clave, "K%i", i);
+			sprintf(valor, "V%i", i);
+			char* elemento = hash_obtener(hash, clave);
+			if(elemento && strcmp(elemento, valor) == 0)
+				correctos++;
+		}
+		assert_prueba("Cada clave queda con su valor", correctos == 9999 && strcmp(hash_obtener(hash, "K7"), "REPETIDA") == 0);
+		assert_prueba("El valor es el resto de la linea y la ultima linea no necesita fin", strcmp(hash_obtener(hash, "TAB"), "a\tb") == 0 && strcmp(hash_obtener(hash, "ULTIMA"), "SIN FIN") == 0);
+
+		hash_destruir(hash);
+	}
+
+	archivo = fopen(ruta, "w");
+	fprintf(archivo, "uno;1|dos;2|tres;3|");
+	fclose(archivo);
+	hash_formato_t formato = {';', '|'};
+	hash_t* hash = hash_crear(NULL, 3);
+	assert_prueba("Se puede cargar con otro separador y otro fin de registro", hash_cargar_archivo(hash, ruta, &formato) == EXITO && hash_cantidad(hash) == 3 && strcmp(hash_obtener(hash, "dos"), "2") == 0);
+	hash_destruir(hash);
+
+	archivo = fopen(ruta, "w");
+	fprintf(archivo, "uno\t1\nsin separador\ntres\t3\n");
+	fclose(archivo);
+	hash = hash_crear(NULL, 3);
+	assert_prueba("Un registro sin separador es un error", hash_cargar_archivo(hash, ruta, NULL) == ERROR && hash_contiene(hash, "uno") && !hash_contiene(hash, "tres"));
+	hash_destruir(hash);
+
+	hash = hash_crear(destruir_string, 3);
+	assert_prueba("No se puede cargar en un hash con destructor ni un archivo inexistente", hash_cargar_archivo(hash, ruta, NULL) == ERROR && hash_cargar_archivo(hash, "no_existe.txt", NULL) == ERROR && hash_cantidad(hash) == 0);
+	hash_destruir(hash);
+
+	remove(ruta);
+}
+
+typedef struct trabajo_durable{
+	hash_durable_t* hash;
+	int hilo;
+	int correctos;
+}trabajo_durable_t;
+
+void* insertar_durable(void* argumento){
+
+	trabajo_durable_t* trabajo = argumento;
+	char clave[30];
+
+	for(int i = 0; i < 500; i++){
+		sprintf(clave, "D%iC%i", trabajo->hilo, i);
+		if(hash_durable_insertar(trabajo->hash, clave, &i, sizeof(i)) == EXITO)
+			trabajo->correctos++;
+	}
+
+	return NULL;
+}
+
+void* consultar_durable(void* argumento){
+
+	trabajo_durable_t* trabajo = argumento;
+	int numero;
+
+	for(int i = 0; i < 2000; i++){
+		if(hash_durable_obtener(trabajo->hash, "C77", &numero, sizeof(numero), NULL) && numero == -77)
+			trabajo->correctos++;
+		if(i % 100 == 0 && hash_durable_checkpoint(trabajo->hash) == ERROR)
+			trabajo->correctos--;
+	}
+
+	return NULL;
+}
+
+void test_hash_durable(){
+
+	printf("\nTEST HASH DURABLE: \n\n");
+
+	const char* ruta = "prueba_durable";
+	remove("prueba_durable.log");
+	remove("prueba_durable.snapshot");
+
+	hash_durable_t* hash = hash_durable_abrir(ruta, NULL, NULL);
+	assert_prueba("Se puede abrir un hash durable nuevo", hash && hash_durable_cantidad(hash) == 0);
+
+	char clave[30];
+	for(int i = 0; i < 1000; i++){
+		sprintf(clave, "C%i", i);
+		hash_durable_insertar(hash, clave, &i, sizeof(i));
+	}
+	hash_durable_insertar(hash, "TEXTO", "hola", 5);
+	hash_durable_quitar(hash, "C0");
+	assert_prueba("No se puede quitar una clave que no esta", hash_durable_quitar(hash, "NO") == ERROR);
+	hash_durable_cerrar(hash);
+
+	hash = hash_durable_abrir(ruta, NULL, NULL);
+	int numero = 0;
+	size_t tamanio = 0;
+	char texto[10];
+	assert_prueba("Al reabrir se recuperan los cambios del log", hash && hash_durable_cantidad(hash) == 1000 && !hash_durable_contiene(hash, "C0") && hash_durable_obtener(hash, "C77", &numero, sizeof(numero), &tamanio) && numero == 77 && tamanio == sizeof(int));
+	assert_prueba("Los elementos se copian con su tamanio", hash_durable_obtener(hash, "TEXTO", texto, sizeof(texto), &tamanio) && tamanio == 5 && strcmp(texto, "hola") == 0);
+
+	assert_prueba("Se puede hacer un checkpoint", hash_durable_checkpoint(hash) == EXITO);
+	hash_durable_insertar(hash, "C77", &(int){-77}, sizeof(int));
+	hash_durable_quitar(hash, "C1");
+	assert_prueba("Se puede esperar a que los cambios esten en disco", hash_durable_sincronizar(hash) == EXITO);
+	hash_durable_cerrar(hash);
+
+	// Simula un corte en medio de la escritura de un registro
+	FILE* log = fopen("prueba_durable.log", "ab");
+	fputs("registro cortado", log);
+	fclose(log);
+
+	hash = hash_durable_abrir(ruta, NULL, NULL);
+	assert_prueba("Al reabrir se aplica el log sobre el snapshot y se descarta el registro cortado", hash && hash_durable_cantidad(hash) == 999 && !hash_durable_contiene(hash, "C1") && hash_durable_obtener(hash, "C77", &numero, sizeof(numero), NULL) && numero == -77);
+	hash_durable_cerrar(hash);
+
+	hash_durable_opciones_t durabilidad = {0};
+	durabilidad.esperar_commit = true;
+	hash_opciones_t opciones = {0};
+	opciones.motor = HASH_MOTOR_ENCADENADO;
+	hash = hash_durable_abrir(ruta, &opciones, &durabilidad);
+
+	pthread_t hilos[HILOS_PRUEBA];
+	trabajo_durable_t trabajos[HILOS_PRUEBA];
+	for(int i = 0; i < HILOS_PRUEBA; i++){
+		trabajos[i] = (trabajo_durable_t){hash, i, 0};
+		pthread_create(&hilos[i], NULL, insertar_durable, &trabajos[i]);
+	}
+	// Dos hilos consultan y hacen checkpoints a la vez
+	pthread_t consultores[2];
+	trabajo_durable_t consultas[2];
+	for(int i = 0; i < 2; i++){
+		consultas[i] = (trabajo_durable_t){hash, i, 0};
+		pthread_create(&consultores[i], NULL, consultar_durable, &consultas[i]);
+	}
+	int correctos = 0;
+	for(int i = 0; i < HILOS_PRUEBA; i++){
+		pthread_join(hilos[i], NULL);
+		correctos += trabajos[i].correctos;
+	}
+	for(int i = 0; i < 2; i++)
+		pthread_join(consultores[i], NULL);
+	assert_prueba("Varios hilos pueden escribir esperando cada uno su commit", correctos == HILOS_PRUEBA * 500 && hash_durable_cantidad(hash) == 999 + HILOS_PRUEBA * 500);
+	assert_prueba("Las consultas y los checkpoints de varios hilos pueden hacerse mientras otros hilos escriben", consultas[0].correctos == 2000 && consultas[1].correctos == 2000);
+	hash_durable_cerrar(hash);
+
+	hash = hash_durable_abrir(ruta, NULL, NULL);
+	assert_prueba("Los cambios de todos los hilos estan en disco", hash && hash_durable_cantidad(hash) == 999 + HILOS_PRUEBA * 500 && hash_durable_contiene(hash, "D3C499"));
+	hash_durable_cerrar(hash);
+
+	remove("prueba_durable.log");
+	remove("prueba_durable.snapshot");
+}
+
 void print_count(){
 
 	printf("\nOverall:\n");
@@ -142,4 +1469,191 @@ void print_count(){
 	printf("Pruebas Corridas: %i\n", failure_count + success_count);
 	printf("Pruebas Pasadas:" ANSI_COLOR_GREEN "%i \n" ANSI_COLOR_RESET , success_count);
 	printf("Pruebas Fallidas:" ANSI_COLOR_RED "%i\n" ANSI_COLOR_RESET, failure_count);
-}
\ No newline at end of file
+}
+void test_estadisticas(){
+
+	printf("\nTEST ESTADISTICAS: \n\n");
+
+	hash_estadisticas_t estadisticas;
+	assert_prueba("No se pueden pedir estadisticas de un hash NULL", hash_estadisticas(NULL, &estadisticas) == ERROR);
+
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		hash_t* hash = hash_crear_con_opciones(NULL, 5, &opciones);
+
+		char clave[20];
+		size_t bytes_claves = 0;
+		for(int i = 0; i < 1000; i++){
+			snprintf(clave, sizeof(clave), "clave%d", i);
+			hash_insertar(hash, clave, NULL);
+			bytes_claves += strlen(clave) + 1;
+		}
+
+		assert_prueba("Las estadisticas de un hash valido se pueden pedir", hash_estadisticas(hash, &estadisticas) == EXITO);
+		assert_prueba("El factor de carga no se redondea", estadisticas.cantidad == 1000 && estadisticas.factor_carga == 1000.0 / (double)estadisticas.capacidad);
+
+		size_t elementos = 0;
+		for(size_t i = 0; i < HASH_LARGOS_CADENA; i++)
+			elementos += i * estadisticas.histograma_cadenas[i];
+		assert_prueba("El histograma de cadenas cuenta todos los elementos", elementos == 1000 && estadisticas.histograma_cadenas[0] == estadisticas.baldes_vacios);
+		assert_prueba("Los sondeos son de al menos un balde", estadisticas.sondeo_medio >= 1 && estadisticas.sondeo_maximo >= 1);
+		assert_prueba("Se cuentan los rehashes y su duracion", estadisticas.rehashes > 0 && estadisticas.nanosegundos_rehash > 0);
+		assert_prueba("Se cuenta la memoria de las claves", estadisticas.bytes_claves == bytes_claves && estadisticas.bytes_baldes > 0);
+
+		hash_destruir(hash);
+	}
+
+	hash_opciones_t opciones = {0};
+	opciones.motor = HASH_MOTOR_ENCADENADO;
+	opciones.funcion = hash_constante;
+	hash_t* hash = hash_crear_con_opciones(NULL, 100, &opciones);
+
+	hash_insertar(hash, "A", NULL);
+	hash_insertar(hash, "B", NULL);
+	hash_insertar(hash, "C", NULL);
+	hash_insertar(hash, "D", NULL);
+	hash_estadisticas(hash, &estadisticas);
+	assert_prueba("Con todas las claves en un balde la cadena tiene todos los elementos", estadisticas.cadena_maxima == 4 && estadisticas.histograma_cadenas[4] == 1);
+	assert_prueba("El resto de los baldes queda vacio", estadisticas.baldes_vacios == estadisticas.capacidad - 1);
+	assert_prueba("Una cadena de 4 se recorre en promedio hasta la mitad", estadisticas.sondeo_medio == 2.5 && estadisticas.sondeo_maximo == 4);
+	assert_prueba("Una tabla creada con lugar suficiente no hace rehash", estadisticas.rehashes == 0);
+
+	hash_destruir(hash);
+}
+
+#define LECTURAS_MEDIDAS 5000
+
+void* leer_midiendo(void* argumento){
+
+	hash_t* hash = argumento;
+	char clave[20];
+
+	for(int i = 0; i < LECTURAS_MEDIDAS; i++){
+		snprintf(clave, sizeof(clave), "clave%d", i % 100);
+		hash_obtener(hash, clave);
+	}
+
+	return NULL;
+}
+
+void test_latencias(){
+
+	printf("\nTEST LATENCIAS: \n\n");
+
+	hash_t* hash = hash_crear(NULL, 5);
+	hash_insertar(hash, "Uno", NULL);
+	assert_prueba("Un hash sin muestreo no mide latencias", hash_latencia_percentil(hash, HASH_OPERACION_INSERTAR, 50) == 0);
+	assert_prueba("Un hash sin muestreo no exporta latencias", hash_exportar_latencias(hash, stdout, HASH_EXPORTAR_TEXTO) == ERROR);
+	hash_destruir(hash);
+
+	char buffer[4096];
+	char clave[20];
+
+	for(int m = 0; m < CANTIDAD_MOTORES; m++){
+
+		hash_opciones_t opciones = {0};
+		opciones.motor = motores[m];
+		opciones.muestreo_latencia = 1;
+		opciones.contadores_hardware = true;
+		hash = hash_crear_con_opciones(NULL, 5, &opciones);
+
+		for(int i = 0; i < 1000; i++){
+			snprintf(clave, sizeof(clave), "clave%d", i);
+			hash_insertar(hash, clave, NULL);
+			hash_obtener(hash, clave);
+		}
+
+		uint64_t p50 = hash_latencia_percentil(hash, HASH_OPERACION_INSERTAR, 50);
+		uint64_t p99 = hash_latencia_percentil(hash, HASH_OPERACION_INSERTAR, 99);
+		uint64_t maximo = hash_latencia_percentil(hash, HASH_OPERACION_INSERTAR, 100);
+		assert_prueba("Los percentiles de latencia crecen hasta el maximo", p50 > 0 && p50 <= p99 && p99 <= maximo);
+		assert_prueba("Una operacion que no se uso no tiene latencias", hash_latencia_percentil(hash, HASH_OPERACION_QUITAR, 50) == 0);
+
+		FILE* archivo = tmpfile();
+		bool exporto = hash_exportar_latencias(hash, archivo, HASH_EXPORTAR_JSON) == EXITO;
+		rewind(archivo);
+		size_t leidos = fread(buffer, 1, sizeof(buffer) - 1, archivo);
+		buffer[leidos] = '\0';
+		fclose(archivo);
+		assert_prueba("Las latencias se exportan como JSON", exporto && buffer[0] == '{' && strstr(buffer, "\"obtener\":{\"muestras\":1000,") && strstr(buffer, "\"histograma\":[["));
+
+		archivo = tmpfile();
+		assert_prueba("Las latencias se exportan como texto", hash_exportar_latencias(hash, archivo, HASH_EXPORTAR_TEXTO) == EXITO && ftell(archivo) > 0);
+		fclose(archivo);
+
+		hash_destruir(hash);
+	}
+
+	hash_opciones_t opciones = {0};
+	opciones.muestreo_latencia = 10;
+	hash = hash_crear_con_opciones(NULL, 5, &opciones);
+	for(int i = 0; i < 1000; i++){
+		snprintf(clave, sizeof(clave), "clave%d", i);
+		hash_insertar(hash, clave, NULL);
+	}
+	for(int i = 0; i < 1000; i += 2){
+		snprintf(clave, sizeof(clave), "clave%d", i);
+		hash_quitar(hash, clave);
+	}
+
+	FILE* archivo = tmpfile();
+	hash_exportar_latencias(hash, archivo, HASH_EXPORTAR_JSON);
+	rewind(archivo);
+	size_t leidos = fread(buffer, 1, sizeof(buffer) - 1, archivo);
+	buffer[leidos] = '\0';
+	fclose(archivo);
+	assert_prueba("Se mide una de cada muestreo_latencia operaciones", strstr(buffer, "\"insertar\":{\"muestras\":100,") && strstr(buffer, "\"quitar\":{\"muestras\":50,"));
+
+	hash_destruir(hash);
+
+	// Varios lectores a la vez, como los de un fragmento de hash_concurrente con el candado de lectura
+	opciones.motor = HASH_MOTOR_ABIERTO;
+	opciones.muestreo_latencia = 1;
+	hash = hash_crear_con_opciones(NULL, 100, &opciones);
+	for(int i = 0; i < 100; i++){
+		snprintf(clave, sizeof(clave), "clave%d", i);
+		hash_insertar(hash, clave, NULL);
+	}
+
+	pthread_t hilos[HILOS_PRUEBA];
+	for(int i = 0; i < HILOS_PRUEBA; i++)
+		pthread_create(&hilos[i], NULL, leer_midiendo, hash);
+	for(int i = 0; i < HILOS_PRUEBA; i++)
+		pthread_join(hilos[i], NULL);
+
+	archivo = tmpfile();
+	hash_exportar_latencias(hash, archivo, HASH_EXPORTAR_JSON);
+	rewind(archivo);
+	leidos = fread(buffer, 1, sizeof(buffer) - 1, archivo);
+	buffer[leidos] = '\0';
+	fclose(archivo);
+	char esperado[64];
+	snprintf(esperado, sizeof(esperado), "\"obtener\":{\"muestras\":%d,", HILOS_PRUEBA * LECTURAS_MEDIDAS);
+	assert_prueba("Las lecturas concurrentes se miden todas", strstr(buffer, esperado) != NULL);
+
+	hash_destruir(hash);
+
+	// hash_obtener_o_insertar y los lotes pasan por la misma medicion que las operaciones individuales
+	opciones.muestreo_latencia = 1;
+	hash = hash_crear_con_opciones(NULL, 100, &opciones);
+	bool insertado;
+	const char* claves_lote[] = {"uno", "dos", "tres"};
+	void* resultados[3];
+	for(int i = 0; i < 3; i++)
+		hash_obtener_o_insertar(hash, claves_lote[i], &insertado);
+	hash_obtener_o_insertar(hash, "uno", &insertado);
+	hash_obtener_lote(hash, claves_lote, 3, resultados);
+
+	archivo = tmpfile();
+	hash_exportar_latencias(hash, archivo, HASH_EXPORTAR_JSON);
+	rewind(archivo);
+	leidos = fread(buffer, 1, sizeof(buffer) - 1, archivo);
+	buffer[leidos] = '\0';
+	fclose(archivo);
+	assert_prueba("hash_obtener_o_insertar se mide como insercion", strstr(buffer, "\"insertar\":{\"muestras\":4,") != NULL);
+	assert_prueba("hash_obtener_lote mide cada clave como una busqueda", strstr(buffer, "\"obtener\":{\"muestras\":3,") != NULL);
+
+	hash_destruir(hash);
+}
@@ -5,6 +5,29 @@
 void test_hash_nulos();
 void test_insercion_borrado_busqueda();
 void test_iterador();
+void test_motor_abierto();
+void test_motor_encadenado();
+void test_funciones_hash();
+void test_hash_guardado();
+void test_asignacion_slab();
+void test_rehash_incremental();
+void test_obtener_o_insertar();
+void test_con_hash();
+void test_claves_binarias();
+void test_lotes();
+void test_reservar();
+void test_hash_concurrente();
+void test_hash_rcu();
+void test_hash_libre();
+void test_rehash_paralelo();
+void test_construir_paralelo();
+void test_cursor();
+void test_quitar_recorriendo();
+void test_snapshot();
+void test_cargar_archivo();
+void test_hash_durable();
+void test_estadisticas();
+void test_latencias();
 void print_count();
 
 
@@ -0,0 +1,176 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include "slab.h"
+
+#define TAMANIO_PAGINA (64 * 1024)
+#define GRANULARIDAD 16
+#define CANTIDAD_CLASES 16
+#define TAMANIO_MAXIMO_CLASE (GRANULARIDAD * CANTIDAD_CLASES)
+#define ENCABEZADO 16
+
+typedef struct bloque_libre{
+	struct bloque_libre* siguiente;
+}bloque_libre_t;
+
+typedef struct pagina{
+	struct pagina* siguiente;
+}pagina_t;
+
+typedef struct bloque_grande{
+	struct bloque_grande* anterior;
+	struct bloque_grande* siguiente;
+}bloque_grande_t;
+
+struct slab{
+	bloque_libre_t* libres[CANTIDAD_CLASES];
+	char* actual;
+	size_t disponible;
+	pagina_t* paginas;
+	size_t cantidad_paginas;
+	bloque_grande_t* grandes;
+};
+
+/*
+ * Crea un asignador vacio.
+ * Devuelve un puntero al asignador creado o NULL en caso de error.
+ */
+slab_t* slab_crear(){
+
+	return calloc(1, sizeof(slab_t));
+}
+
+// pre: tamanio es a lo sumo TAMANIO_MAXIMO_CLASE
+// pos: devuelve la clase de tamaño que corresponde a tamanio
+size_t slab_clase(size_t tamanio){
+
+	if(tamanio == 0)
+		return 0;
+
+	return (tamanio + GRANULARIDAD - 1) / GRANULARIDAD - 1;
+}
+
+// pre: slab es distinto de NULL
+// pos: reserva un bloque fuera de las paginas, enlazado para poder liberarlo al destruir el asignador
+void* slab_reservar_grande(slab_t* slab, size_t tamanio){
+
+	bloque_grande_t* bloque = malloc(ENCABEZADO + tamanio);
+	if(!bloque)
+		return NULL;
+
+	bloque->anterior = NULL;
+	bloque->siguiente = slab->grandes;
+	if(slab->grandes)
+		slab->grandes->anterior = bloque;
+	slab->grandes = bloque;
+
+	return (char*)bloque + ENCABEZADO;
+}
+
+// pre: slab es distinto de NULL
+// pos: agrega una pagina nueva de la cual cortar bloques. Devuelve false si no hay memoria
+bool slab_agregar_pagina(slab_t* slab){
+
+	pagina_t* pagina = malloc(TAMANIO_PAGINA);
+	if(!pagina)
+		return false;
+
+	pagina->siguiente = slab->paginas;
+	slab->paginas = pagina;
+	slab->cantidad_paginas++;
+	slab->actual = (char*)pagina + ENCABEZADO;
+	slab->disponible = TAMANIO_PAGINA - ENCABEZADO;
+
+	return true;
+}
+
+/*
+ * Devuelve un bloque de al menos tamanio bytes alineado a 16 bytes, o
+ * NULL si no hay memoria.
+ */
+void* slab_reservar(slab_t* slab, size_t tamanio){
+
+	if(!slab)
+		return NULL;
+
+	if(tamanio > TAMANIO_MAXIMO_CLASE)
+		return slab_reservar_grande(slab, tamanio);
+
+	size_t clase = slab_clase(tamanio);
+	bloque_libre_t* libre = slab->libres[clase];
+	if(libre){
+		slab->libres[clase] = libre->siguiente;
+		return libre;
+	}
+
+	size_t tamanio_bloque = (clase + 1) * GRANULARIDAD;
+	if(slab->disponible < tamanio_bloque && !slab_agregar_pagina(slab))
+		return NULL;
+
+	void* bloque = slab->actual;
+	slab->actual += tamanio_bloque;
+	slab->disponible -= tamanio_bloque;
+
+	return bloque;
+}
+
+/*
+ * Devuelve el bloque al asignador. Tamanio debe ser el mismo con el
+ * que se reservo el bloque.
+ */
+void slab_liberar(slab_t* slab, void* bloque, size_t tamanio){
+
+	if(!slab || !bloque)
+		return;
+
+	if(tamanio > TAMANIO_MAXIMO_CLASE){
+		bloque_grande_t* grande = (bloque_grande_t*)((char*)bloque - ENCABEZADO);
+		if(grande->anterior)
+			grande->anterior->siguiente = grande->siguiente;
+		else
+			slab->grandes = grande->siguiente;
+		if(grande->siguiente)
+			grande->siguiente->anterior = grande->anterior;
+		free(grande);
+		return;
+	}
+
+	size_t clase = slab_clase(tamanio);
+	bloque_libre_t* libre = bloque;
+	libre->siguiente = slab->libres[clase];
+	slab->libres[clase] = libre;
+}
+
+/*
+ * Devuelve la cantidad de paginas reservadas por el asignador.
+ */
+size_t slab_paginas(slab_t* slab){
+
+	if(!slab)
+		return 0;
+
+	return slab->cantidad_paginas;
+}
+
+/*
+ * Libera toda la memoria del asignador, incluyendo los bloques que no
+ * hayan sido liberados.
+ */
+void slab_destruir(slab_t* slab){
+
+	if(!slab)
+		return;
+
+	while(slab->paginas){
+		pagina_t* siguiente = slab->paginas->siguiente;
+		free(slab->paginas);
+		slab->paginas = siguiente;
+	}
+
+	while(slab->grandes){
+		bloque_grande_t* siguiente = slab->grandes->siguiente;
+		free(slab->grandes);
+		slab->grandes = siguiente;
+	}
+
+	free(slab);
+}
@@ -0,0 +1,46 @@
+#ifndef __SLAB_H__
+#define __SLAB_H__
+
+#include <stddef.h>
+
+/*
+ * Asignador de memoria por bloques. Los pedidos chicos se agrupan por
+ * tamaño y se sirven desde paginas grandes, reutilizando los bloques
+ * liberados mediante listas de libres. Destruir el asignador libera
+ * todas las paginas de una vez, sin importar cuantos bloques se
+ * hayan pedido.
+ *
+ * No es seguro usar un mismo asignador desde varios hilos a la vez.
+ */
+typedef struct slab slab_t;
+
+/*
+ * Crea un asignador vacio.
+ * Devuelve un puntero al asignador creado o NULL en caso de error.
+ */
+slab_t* slab_crear();
+
+/*
+ * Devuelve un bloque de al menos tamanio bytes alineado a 16 bytes, o
+ * NULL si no hay memoria.
+ */
+void* slab_reservar(slab_t* slab, size_t tamanio);
+
+/*
+ * Devuelve el bloque al asignador. Tamanio debe ser el mismo con el
+ * que se reservo el bloque.
+ */
+void slab_liberar(slab_t* slab, void* bloque, size_t tamanio);
+
+/*
+ * Devuelve la cantidad de paginas reservadas por el asignador.
+ */
+size_t slab_paginas(slab_t* slab);
+
+/*
+ * Libera toda la memoria del asignador, incluyendo los bloques que no
+ * hayan sido liberados.
+ */
+void slab_destruir(slab_t* slab);
+
+#endif /* __SLAB_H__ */